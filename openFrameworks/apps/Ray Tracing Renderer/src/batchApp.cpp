@@ -0,0 +1,253 @@
+#include "batchApp.h"
+
+//Read the command line into the render settings
+void batchApp::parseArguments(int argc, char* argv[])
+{
+	vector<string> positional;
+
+	for (int argIndex = 1; argIndex < argc; argIndex++)
+	{
+		string argument = argv[argIndex];
+
+		if (argument.substr(0, 2) != "--")
+		{
+			positional.push_back(argument);
+			continue;
+		}
+
+		//Every option takes a value
+		if (argIndex + 1 >= argc)
+			throw "Missing value for option '" + argument + "'";
+
+		string value = argv[++argIndex];
+
+		try
+		{
+			if (argument == "--width")
+				width = stoi(value);
+			else if (argument == "--height")
+				height = stoi(value);
+			else if (argument == "--bounces")
+				maxBounces = stoi(value);
+			else if (argument == "--samples")
+				maxSamples = stoi(value);
+			else if (argument == "--exposure")
+				exposure = stof(value);
+			else if (argument == "--band-rows")
+				bandRows = stoi(value);
+			else if (argument == "--parallel-frames")
+				concurrentFrames = stoi(value);
+			else if (argument == "--aovs")
+				parseAOVs(value);
+			else if (argument == "--denoise")
+				denoisePasses = stoi(value);
+			else if (argument == "--frames")
+			{
+				//A range of frames is given as first-last, and a single frame as one number
+				size_t dash = value.find('-');
+				firstFrame = stoi(value.substr(0, dash));
+				lastFrame = (dash == string::npos) ? firstFrame : stoi(value.substr(dash + 1));
+
+				if (firstFrame < 0 || lastFrame < firstFrame)
+					throw "Invalid frame range '" + value + "'";
+			}
+			else if (argument == "--pipeline" && (value == "recursive" || value == "wavefront"))
+				pipeline = (value == "wavefront") ? renderPipeline::wavefront : renderPipeline::recursive;
+			else if (argument == "--tonemap" && (value == "none" || value == "reinhard" || value == "aces"))
+				ToneMapping = (value == "aces") ? toneMapping::aces : (value == "reinhard") ? toneMapping::reinhard : toneMapping::none;
+			else
+				throw "Invalid option '" + argument + " " + value + "'";
+		}
+		//stoi and stof throw if the value isn't a number
+		catch (const logic_error&)
+		{
+			throw "Invalid value for option '" + argument + "': '" + value + "'";
+		}
+	}
+
+	if (positional.size() != 2)
+		throw string("Expected a scene file and an output image");
+
+	if (width < 1 || height < 1)
+		throw string("The width and height must be at least one pixel");
+
+	if (bandRows < 0)
+		throw string("The band rows can't be negative");
+
+	if (concurrentFrames < 0)
+		throw string("The parallel frames can't be negative");
+
+	if (firstFrame >= 0 && bandRows > 0)
+		throw string("Animations can't be rendered a band at a time");
+
+	if (!aovTypes.empty() && bandRows > 0)
+		throw string("AOVs can't be written for images rendered a band at a time");
+
+	if (denoisePasses < 0)
+		throw string("The denoise passes can't be negative");
+
+	if (denoisePasses > 0 && bandRows > 0)
+		throw string("Images rendered a band at a time can't be denoised");
+
+	scenePath = positional[0];
+	outputPath = positional[1];
+}
+
+//Read a comma separated list of AOV names
+void batchApp::parseAOVs(string list)
+{
+	stringstream sstream(list);
+	string name;
+
+	while (getline(sstream, name, ','))
+	{
+		aovType type;
+
+		if (!rtAOVBuffers::findType(name, type))
+			throw "Unknown AOV '" + name + "'";
+
+		aovTypes.push_back(type);
+	}
+}
+
+void batchApp::printUsage()
+{
+	cout << "Usage: \"Ray Tracing Renderer\" <scene file> <output image> [options]" << endl
+		<< "The output format is chosen by extension: ppm, png, jpg, bmp, or exr and pfm for unclamped radiance" << endl
+		<< "Options:" << endl
+		<< "  --width <pixels>           Image width (default 1280)" << endl
+		<< "  --height <pixels>          Image height (default 720)" << endl
+		<< "  --bounces <count>          Maximum reflection bounces (default 3)" << endl
+		<< "  --samples <count>          Maximum anti-aliasing samples per pixel (default 1)" << endl
+		<< "  --pipeline <name>          recursive or wavefront (default recursive)" << endl
+		<< "  --tonemap <name>           none, reinhard or aces (default none)" << endl
+		<< "  --exposure <factor>        Radiance scale before tone mapping (default 1)" << endl
+		<< "  --band-rows <rows>         Render and write the image this many rows at a time. Only for ppm and pfm." << endl
+		<< "                             PFM files and images over " << maxFramePixels / (1024 * 1024) << " megapixels are always written in bands." << endl
+		<< "  --frames <first>-<last>    Render these frames of the scene's camera keys, each to its own image." << endl
+		<< "                             A run of '#' in the output path is replaced by the frame number, for example frame_####.png" << endl
+		<< "  --parallel-frames <count>  Frames rendered at a time (default chosen from the image size)" << endl
+		<< "  --aovs <list>              Also write these outputs of each image as EXR files named after it, separated by commas:" << endl
+		<< "                             depth, normal, albedo, object and face. Not for images written in bands." << endl
+		<< "  --denoise <passes>         Filter the noise out of each image with this many passes, 5 for most images (default 0)." << endl
+		<< "                             Not for images written in bands." << endl;
+}
+
+//Render each frame of the animation to its own image
+void batchApp::renderAnimation()
+{
+	rtSceneDescription description = rtSceneLoader::loadScene(scenePath);
+
+	//Each frame slot loads its own copy of the scene. The first slot reuses the copy already loaded.
+	shared_ptr<rtScene> loadedScene = description.scene;
+	string path = scenePath;
+
+	rtAnimationJob::sceneFactory makeScene = [&loadedScene, path]()
+	{
+		shared_ptr<rtScene> scene = loadedScene ? loadedScene : rtSceneLoader::loadScene(path).scene;
+		loadedScene = nullptr;
+		return scene;
+	};
+
+	rtAnimationJob job(makeScene, width, height, firstFrame, lastFrame, outputPath);
+	job.setMaxBounces(maxBounces);
+	job.setMaxSamples(maxSamples);
+	job.setRenderPipeline(pipeline);
+	job.setToneMapping(ToneMapping);
+	job.setExposure(exposure);
+	job.setConcurrentFrames(concurrentFrames);
+	job.setDenoisePasses(denoisePasses);
+
+	for (int aovIndex = 0; aovIndex < aovTypes.size(); aovIndex++)
+		job.enableAOV(aovTypes[aovIndex]);
+
+	//Without camera keys, every frame uses the view of the camera statement
+	if (description.cameraKeys.empty())
+		job.addCameraKey(0.0f, description.camPosition, description.camLookAt, description.camUp, description.fov);
+
+	for (int keyIndex = 0; keyIndex < description.cameraKeys.size(); keyIndex++)
+	{
+		rtCameraKey& key = description.cameraKeys[keyIndex];
+		job.addCameraKey(key.frame, key.position, key.lookAt, key.up, key.fov);
+	}
+
+	job.setFrameCallback([&job](int frame) { cout << "Wrote frame " << frame << " to '" << job.getFramePath(frame) << "'" << endl; });
+
+	cout << "Rendering frames " << firstFrame << " to " << lastFrame << ", " << job.getConcurrentFrames() << " at a time" << endl;
+	chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+	job.run();
+	chrono::duration<double> renderTime = chrono::steady_clock::now() - startTime;
+	int numFrames = lastFrame - firstFrame + 1;
+	cout << "Rendered " << numFrames << " frames of " << width << "x" << height << " in " << renderTime.count() << "s (" << renderTime.count() / numFrames << "s per frame)" << endl;
+}
+
+//Render the scene and write the image
+int batchApp::run(int argc, char* argv[])
+{
+	try
+	{
+		parseArguments(argc, argv);
+
+		if (firstFrame >= 0)
+		{
+			renderAnimation();
+			return 0;
+		}
+
+		bool writeBands = bandRows > 0 || (long long)width * height > maxFramePixels || rtImageWriter::getExtension(outputPath) == "pfm";
+		unique_ptr<rtImageWriter> writer;
+
+		//Find the writer first, so an unsupported format fails before rendering
+		if (!writeBands)
+			writer = rtImageWriter::forFile(outputPath);
+		else if (!rtBandWriter::forFile(outputPath))
+			throw "Images rendered a band at a time must be written as ppm or pfm, not '" + rtImageWriter::getExtension(outputPath) + "'";
+		else if (!aovTypes.empty())
+			throw string("AOVs can't be written for images rendered a band at a time");
+		else if (denoisePasses > 0)
+			throw string("Images rendered a band at a time can't be denoised");
+
+		rtSceneDescription description = rtSceneLoader::loadScene(scenePath);
+
+		//The frame buffers of a camera writing bands are never used, so they are kept to a single pixel
+		rtCam camera(writeBands ? 1 : width, writeBands ? 1 : height, description.camPosition, description.camLookAt, description.camUp);
+		camera.setScene(description.scene);
+		camera.setFov(description.fov);
+		camera.setMaxBounces(maxBounces);
+		camera.setMaxSamples(maxSamples);
+		camera.setRenderPipeline(pipeline);
+		camera.setToneMapping(ToneMapping);
+		camera.setExposure(exposure);
+		camera.setDenoisePasses(denoisePasses);
+
+		for (int aovIndex = 0; aovIndex < aovTypes.size(); aovIndex++)
+			camera.enableAOV(aovTypes[aovIndex]);
+
+		chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+		if (writeBands)
+		{
+			camera.renderToFile(outputPath, width, height, (bandRows > 0) ? bandRows : 256);
+		}
+		else
+		{
+			camera.render(true);
+			writer->write(outputPath, camera.getLatestFrame(), camera.getRadiance());
+
+			for (int aovIndex = 0; aovIndex < aovTypes.size(); aovIndex++)
+				rtEXRWriter().write(rtAOVBuffers::getPath(outputPath, aovTypes[aovIndex]), camera.getLatestFrame(), camera.getAOVs().getBuffer(aovTypes[aovIndex]));
+		}
+
+		chrono::duration<double> renderTime = chrono::steady_clock::now() - startTime;
+		cout << "Rendered " << width << "x" << height << " in " << renderTime.count() << "s to '" << outputPath << "'" << endl;
+
+		return 0;
+	}
+	catch (const string& error)
+	{
+		cerr << error << endl;
+		printUsage();
+
+		return 1;
+	}
+}
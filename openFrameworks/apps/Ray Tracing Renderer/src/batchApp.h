@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include "rtGraphics/rtMain.h"
+
+using namespace rtGraphics;
+
+/*
+ * Renders a scene file to an image without opening a window
+ * Usage: "Ray Tracing Renderer" <scene file> <output image> [options]
+ * With the frames option, the frames of the scene's animation are each written to an image named by the output path.
+ */
+class batchApp
+{
+private:
+	//Render settings, which can be changed with command line options
+	string scenePath;
+	string outputPath;
+	int width = 1280;
+	int height = 720;
+	int maxBounces = 3;
+	int maxSamples = 1;
+	renderPipeline pipeline = renderPipeline::recursive;
+	toneMapping ToneMapping = toneMapping::none;
+	float exposure = 1.0f;
+	//The rows rendered at a time when the image is written a band at a time, or zero to only do so for PFM files and very large images
+	int bandRows = 0;
+	//Larger images are rendered a band at a time, so the whole frame is never held in memory
+	static const long long maxFramePixels = 64 * 1024 * 1024;
+	//The frames of an animation to render, or a negative first frame to render a single image
+	int firstFrame = -1;
+	int lastFrame = -1;
+	//The number of frames of an animation rendered at a time, or zero to choose it from the frame size
+	int concurrentFrames = 0;
+	//The AOVs written next to each image
+	vector<aovType> aovTypes;
+	//The number of denoising passes, or zero to leave the images as rendered
+	int denoisePasses = 0;
+
+	//Read the command line into the render settings. Throws a string describing the problem if the arguments are invalid.
+	void parseArguments(int argc, char* argv[]);
+	void printUsage();
+	//Read a comma separated list of AOV names
+	void parseAOVs(string list);
+	//Render each frame of the animation to its own image
+	void renderAnimation();
+
+public:
+	//Render the scene and write the image. Returns the exit code of the program.
+	int run(int argc, char* argv[]);
+};
@@ -1,8 +1,13 @@
 #include "ofAppRunner.cpp"
 #include "ofApp.h"
+#include "batchApp.h"
 
-int main()
+int main(int argc, char* argv[])
 {
+	//With command line arguments, render the given scene to an image without opening a window
+	if (argc > 1)
+		return batchApp().run(argc, argv);
+
 	//Create a windowed application running in OpenGL 3.2
 	ofGLFWWindowSettings settings;
 	settings.setGLVersion(3, 2);
@@ -75,6 +75,11 @@ void ofApp::drawFps()
 {
 	int fps = mainCamera->getFps();
 	string fpsString = "FPS: " + to_string(fps);
+
+	//Show how far the resolution was scaled down to keep up
+	if (mainCamera->getRenderScale() < 1.0f)
+		fpsString += " (" + to_string((int)roundf(mainCamera->getRenderScale() * 100.0f)) + "% resolution)";
+
 	ofDrawBitmapString(fpsString, 10, 20, -1);
 }
 
@@ -83,10 +88,17 @@ void ofApp::keyPressed(int key)
 	//When the 't' key is pressed, render the scene using ray tracing
 	if (key == 't' || key == 'T')
 	{
+		//Abort a ray marched frame that is still rendering
+		mainCamera->cancelRender();
 		//Run the camera in real-time
 		mainCamera->enable();
 		//Set the rendering mode to ray tracing
 		mainCamera->setRenderMode(renderMode::rayTrace);
+		//Trace every pixel of the real-time frames once
+		mainCamera->setProgressive(false);
+		mainCamera->setMaxSamples(1);
+		//Lower the resolution on heavy views to keep the frame rate up
+		mainCamera->setTargetFrameTime(1000.0f / 30.0f);
 		//Show the fps counter
 		showFps = true;
 	}
@@ -97,6 +109,12 @@ void ofApp::keyPressed(int key)
 		mainCamera->disable();
 		//Set the rendering mode to ray marching
 		mainCamera->setRenderMode(renderMode::rayMarch);
+		//Show a coarse image right away and refine it while the slow frame renders
+		mainCamera->setProgressive(true);
+		//Smooth the edges of the still image
+		mainCamera->setMaxSamples(16);
+		//Render the still image at the full resolution, however long it takes
+		mainCamera->setTargetFrameTime(0.0f);
 		//Set the image to black
 		mainCamera->clearBuffer();
 		//Start rendering the scene without waiting for it to complete
@@ -104,4 +122,30 @@ void ofApp::keyPressed(int key)
 		//Hide the fps counter
 		showFps = false;
 	}
+	//When the 'b' key is pressed, benchmark the intersection of the scene and of each mesh in it, the BVH build methods and layouts, packet tracing and the render pipelines
+	else if (key == 'b' || key == 'B')
+	{
+		//Finish any frame rendering in the background so it doesn't compete with the benchmarks
+		mainCamera->finishFrame();
+
+		objectSet objects = demoScene->getObjects();
+		rtBenchmark::compareSceneIntersection(objects);
+		rtBenchmark::compareSceneLayouts(objects);
+		rtBenchmark::comparePacketSizes(objects, mainCamera->getPosition(), -mainCamera->getLookVector(), mainCamera->getUpVector(), mainCamera->getFov(),
+			mainCamera->getBufferPixels()->getWidth(), mainCamera->getBufferPixels()->getHeight(), mainCamera->getNearClip(), mainCamera->getFarClip());
+		rtBenchmark::comparePipelines(demoScene, mainCamera->getPosition(), -mainCamera->getLookVector(), mainCamera->getUpVector(), mainCamera->getFov(),
+			mainCamera->getBufferPixels()->getWidth(), mainCamera->getBufferPixels()->getHeight(), mainCamera->getNearClip(), mainCamera->getFarClip(), mainCamera->getMaxBounces());
+
+		for (int objectIndex = 0; objectIndex < objects->size(); objectIndex++)
+		{
+			rtMeshObject* meshObject = dynamic_cast<rtMeshObject*>(objects->at(objectIndex));
+
+			if (meshObject != nullptr)
+			{
+				rtBenchmark::compareMeshIntersection(*meshObject);
+				rtBenchmark::compareBuildMethods(*meshObject);
+				rtBenchmark::compareMeshLayouts(*meshObject);
+			}
+		}
+	}
 }
@@ -0,0 +1,713 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "rtBVH.h"
+
+namespace rtGraphics
+{
+	///SAH constants
+	float rtBVH::traversalCost = 1.0f;
+	float rtBVH::intersectionCost = 1.0f;
+	int rtBVH::maxLeafSize = 8;
+
+	///Build settings
+	bvhBuildMethod rtBVH::buildMethod = bvhBuildMethod::binnedSAH;
+	//Use the same number of threads as the render thread pool. hardware_concurrency() returns 0 if the count is unknown.
+	int rtBVH::numBuildThreads = max((int)thread::hardware_concurrency(), 1);
+	float rtBVH::rebuildThreshold = 1.5f;
+	bvhLayout rtBVH::layout = bvhLayout::wide4;
+
+	///Build methods
+	//Build the hierarchy over the given primitive bounds
+	void rtBVH::build(const vector<rtAABB>& primBounds)
+	{
+		chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+		clear();
+
+		int primCount = primBounds.size();
+
+		if (primCount > 0)
+		{
+			//Cache the centroid of each primitive and start with the primitives in their original order
+			vector<rtVec3f> centroids(primCount);
+			primIndices.resize(primCount);
+
+			for (int primIndex = 0; primIndex < primCount; primIndex++)
+			{
+				centroids[primIndex] = primBounds[primIndex].getCentroid();
+				primIndices[primIndex] = primIndex;
+			}
+
+			if (buildMethod == bvhBuildMethod::sweepSAH)
+				buildSweep(primBounds, centroids);
+			else
+				buildBinned(primBounds, centroids);
+
+			collapse();
+		}
+
+		//Record the statistics of the build
+		buildStats = rtBVHBuildStats();
+		buildStats.method = buildMethod;
+		buildStats.buildTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+		buildStats.sahCost = calcSAHCost();
+		buildStats.nodeCount = nodes.size();
+		currentSAHCost = buildStats.sahCost;
+
+		for (int nodeIndex = 0; nodeIndex < nodes.size(); nodeIndex++)
+			if (nodes[nodeIndex].isLeaf())
+				buildStats.leafCount++;
+	}
+
+	//Recalculate the node bounds from the leaves up. Children always have a higher index than their parent, so a reverse pass visits children first.
+	void rtBVH::refit(const vector<rtAABB>& primBounds)
+	{
+		//Sum the SAH cost of the nodes during the pass, before it is normalized by the area of the root
+		float weightedCost = 0.0f;
+
+		for (int nodeIndex = nodes.size() - 1; nodeIndex >= 0; nodeIndex--)
+		{
+			rtBVHNode& node = nodes[nodeIndex];
+			rtAABB bounds;
+
+			if (node.isLeaf())
+			{
+				for (int position = node.leftFirst; position < node.leftFirst + node.primCount; position++)
+					bounds.expand(primBounds[primIndices[position]]);
+
+				weightedCost += intersectionCost * getLeafTests(node.primCount) * bounds.getSurfaceArea();
+			}
+			else
+			{
+				bounds = nodes[node.leftFirst].bounds;
+				bounds.expand(nodes[node.leftFirst + 1].bounds);
+
+				weightedCost += traversalCost * bounds.getSurfaceArea();
+			}
+
+			node.bounds = bounds;
+		}
+
+		float rootArea = nodes.empty() ? 0.0f : nodes[0].bounds.getSurfaceArea();
+		currentSAHCost = (rootArea > 0.0f) ? weightedCost / rootArea : 0.0f;
+
+		//The topology is unchanged, so only the bounds of the wide tree need to be updated
+		if (!wide4Nodes.empty())
+			refitWide(wide4Nodes);
+		else if (!wide8Nodes.empty())
+			refitWide(wide8Nodes);
+	}
+
+	void rtBVH::clear()
+	{
+		nodes.clear();
+		primIndices.clear();
+		wide4Nodes.clear();
+		wide8Nodes.clear();
+		wideSourceNodes.clear();
+		currentSAHCost = 0.0f;
+	}
+
+	///Sweep build methods
+	//Build the tree by evaluating every split position of the sorted primitives. Slow to build, but produces the highest quality trees.
+	void rtBVH::buildSweep(const vector<rtAABB>& primBounds, const vector<rtVec3f>& centroids)
+	{
+		int primCount = primBounds.size();
+
+		//A binary tree with n leaves has at most 2n - 1 nodes
+		nodes.reserve(2 * primCount - 1);
+		nodes.push_back(rtBVHNode());
+
+		//Scratch space for the surface areas computed during the SAH sweep
+		vector<float> areaBuffer(primCount);
+
+		buildNode(0, 0, primCount, 0, primBounds, centroids, areaBuffer);
+		nodes.shrink_to_fit();
+	}
+
+	//Recursively build the node covering the primitive range [first, first + count)
+	void rtBVH::buildNode(int nodeIndex, int first, int count, int depth, const vector<rtAABB>& primBounds, const vector<rtVec3f>& centroids, vector<float>& areaBuffer)
+	{
+		//Calculate the bounds of the primitives and of their centroids
+		rtAABB bounds;
+		rtAABB centroidBounds;
+
+		for (int i = first; i < first + count; i++)
+		{
+			bounds.expand(primBounds[primIndices[i]]);
+			centroidBounds.expand(centroids[primIndices[i]]);
+		}
+
+		//Start the node as a leaf
+		nodes[nodeIndex].bounds = bounds;
+		nodes[nodeIndex].leftFirst = first;
+		nodes[nodeIndex].primCount = count;
+
+		if (count == 1 || depth >= maxDepth - 1)
+			return;
+
+		//The primitive range being split
+		int* range = &primIndices[first];
+		rtVec3f centroidExtent = centroidBounds.getExtent();
+
+		//The best split found so far. The split index is the number of primitives placed in the left child.
+		int bestAxis = -1;
+		int bestSplit = count / 2;
+		float bestCost = INFINITY;
+		int sortedAxis = -1;
+
+		//Sort the primitives along each axis and sweep over them to evaluate every possible split
+		for (int axis = 0; axis < 3; axis++)
+		{
+			//If all the centroids lie in the same plane, the primitives can't be separated along this axis
+			if (centroidExtent.getAxis(axis) <= 0.0f)
+				continue;
+
+			sort(range, range + count, [&centroids, axis](int lhs, int rhs) {
+				return centroids[lhs].getAxis(axis) < centroids[rhs].getAxis(axis);
+			});
+			sortedAxis = axis;
+
+			//Sweep from the right, storing the area of the bounds of every suffix
+			rtAABB rightBounds;
+
+			for (int i = count - 1; i > 0; i--)
+			{
+				rightBounds.expand(primBounds[range[i]]);
+				areaBuffer[i] = rightBounds.getSurfaceArea();
+			}
+
+			//Sweep from the left and compute the cost of splitting before each primitive
+			rtAABB leftBounds;
+
+			for (int i = 1; i < count; i++)
+			{
+				leftBounds.expand(primBounds[range[i - 1]]);
+				float cost = leftBounds.getSurfaceArea() * getLeafTests(i) + areaBuffer[i] * getLeafTests(count - i);
+
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = i;
+				}
+			}
+		}
+
+		if (bestAxis == -1)
+		{
+			//The centroids all coincide, so only split the range if the leaf would be too large
+			if (count <= maxLeafSize)
+				return;
+		}
+		else
+		{
+			//Compare the cost of intersecting every primitive against the cost of splitting
+			float leafCost = intersectionCost * getLeafTests(count);
+			float splitCost = traversalCost + intersectionCost * bestCost / bounds.getSurfaceArea();
+
+			if (count <= maxLeafSize && leafCost <= splitCost)
+				return;
+
+			//Restore the ordering of the best axis if another axis was sorted after it
+			if (sortedAxis != bestAxis)
+			{
+				sort(range, range + count, [&centroids, bestAxis](int lhs, int rhs) {
+					return centroids[lhs].getAxis(bestAxis) < centroids[rhs].getAxis(bestAxis);
+				});
+			}
+		}
+
+		//Turn the node into an internal node with two adjacent children
+		int leftChild = nodes.size();
+		nodes.push_back(rtBVHNode());
+		nodes.push_back(rtBVHNode());
+
+		nodes[nodeIndex].leftFirst = leftChild;
+		nodes[nodeIndex].primCount = 0;
+
+		buildNode(leftChild, first, bestSplit, depth + 1, primBounds, centroids, areaBuffer);
+		buildNode(leftChild + 1, first + bestSplit, count - bestSplit, depth + 1, primBounds, centroids, areaBuffer);
+	}
+
+
+	///Binned build methods
+	/*
+	 * Build the tree by binning the primitive centroids along each axis and only evaluating splits between bins
+	 * The top levels are split on the calling thread, with the binning of large ranges spread across the build threads.
+	 * Once the ranges are small enough, the remaining subtrees are built as independent tasks and appended to the node list.
+	 */
+	void rtBVH::buildBinned(const vector<rtAABB>& primBounds, const vector<rtVec3f>& centroids)
+	{
+		//A range of primitives waiting to be built into the given node
+		struct buildTask
+		{
+			int nodeIndex, first, count, depth;
+		};
+
+		int primCount = primBounds.size();
+
+		//Copy the bounds into a list that is reordered along with the indices, so that each range is contiguous in memory
+		vector<rtBVHPrimRef> primRefs(primCount);
+
+		for (int primIndex = 0; primIndex < primCount; primIndex++)
+			primRefs[primIndex] = { primBounds[primIndex], centroids[primIndex], primIndex };
+
+		//Ranges below this size are built as a single task. Aim for several tasks per thread so the threads stay balanced.
+		int taskSize = max(primCount / (numBuildThreads * 8), 1024);
+
+		nodes.reserve(2 * primCount - 1);
+		nodes.push_back(rtBVHNode());
+
+		//Split the top levels until every range is small enough to become a task
+		vector<buildTask> pendingRanges = { { 0, 0, primCount, 0 } };
+		vector<buildTask> subtreeTasks;
+
+		while (!pendingRanges.empty())
+		{
+			buildTask range = pendingRanges.back();
+			pendingRanges.pop_back();
+
+			if (range.count <= taskSize)
+			{
+				subtreeTasks.push_back(range);
+				continue;
+			}
+
+			rtAABB bounds;
+			int leftCount = splitBinned(range.first, range.count, range.depth, bounds, primRefs, true);
+
+			nodes[range.nodeIndex].bounds = bounds;
+			nodes[range.nodeIndex].leftFirst = range.first;
+			nodes[range.nodeIndex].primCount = range.count;
+
+			if (leftCount == 0)
+				continue;
+
+			//Turn the node into an internal node with two adjacent children
+			int leftChild = nodes.size();
+			nodes.push_back(rtBVHNode());
+			nodes.push_back(rtBVHNode());
+
+			nodes[range.nodeIndex].leftFirst = leftChild;
+			nodes[range.nodeIndex].primCount = 0;
+
+			pendingRanges.push_back({ leftChild, range.first, leftCount, range.depth + 1 });
+			pendingRanges.push_back({ leftChild + 1, range.first + leftCount, range.count - leftCount, range.depth + 1 });
+		}
+
+		//Start the largest subtrees first so that no thread is left with a large task at the end
+		sort(subtreeTasks.begin(), subtreeTasks.end(), [](const buildTask& lhs, const buildTask& rhs) {
+			return lhs.count > rhs.count;
+		});
+
+		//Build each subtree into its own node list, where the root of the subtree is the first node
+		vector<vector<rtBVHNode>> subtrees(subtreeTasks.size());
+
+		runParallel(subtreeTasks.size(), [&](int taskIndex) {
+			buildTask& task = subtreeTasks[taskIndex];
+			vector<rtBVHNode>& subtree = subtrees[taskIndex];
+
+			subtree.reserve(2 * task.count - 1);
+			subtree.push_back(rtBVHNode());
+			buildSubtreeBinned(subtree, 0, task.first, task.count, task.depth, primRefs);
+		});
+
+		//Stitch the subtrees into the tree. Children are appended after their parents so that they always have a higher index.
+		for (int taskIndex = 0; taskIndex < subtreeTasks.size(); taskIndex++)
+		{
+			vector<rtBVHNode>& subtree = subtrees[taskIndex];
+			//The index of the second subtree node once it is appended
+			int offset = nodes.size() - 1;
+
+			//Copy the subtree root into the node reserved for it
+			nodes[subtreeTasks[taskIndex].nodeIndex] = subtree[0];
+
+			if (!subtree[0].isLeaf())
+				nodes[subtreeTasks[taskIndex].nodeIndex].leftFirst += offset;
+
+			for (int nodeIndex = 1; nodeIndex < subtree.size(); nodeIndex++)
+			{
+				nodes.push_back(subtree[nodeIndex]);
+
+				if (!subtree[nodeIndex].isLeaf())
+					nodes.back().leftFirst += offset;
+			}
+		}
+
+		//Store the final order of the primitives
+		for (int i = 0; i < primCount; i++)
+			primIndices[i] = primRefs[i].primIndex;
+
+		nodes.shrink_to_fit();
+	}
+
+	//Recursively build a subtree into the given node list on the current thread
+	void rtBVH::buildSubtreeBinned(vector<rtBVHNode>& nodeList, int nodeIndex, int first, int count, int depth, vector<rtBVHPrimRef>& primRefs)
+	{
+		rtAABB bounds;
+		int leftCount = splitBinned(first, count, depth, bounds, primRefs, false);
+
+		nodeList[nodeIndex].bounds = bounds;
+		nodeList[nodeIndex].leftFirst = first;
+		nodeList[nodeIndex].primCount = count;
+
+		if (leftCount == 0)
+			return;
+
+		int leftChild = nodeList.size();
+		nodeList.push_back(rtBVHNode());
+		nodeList.push_back(rtBVHNode());
+
+		nodeList[nodeIndex].leftFirst = leftChild;
+		nodeList[nodeIndex].primCount = 0;
+
+		buildSubtreeBinned(nodeList, leftChild, first, leftCount, depth + 1, primRefs);
+		buildSubtreeBinned(nodeList, leftChild + 1, first + leftCount, count - leftCount, depth + 1, primRefs);
+	}
+
+	//Calculate the bounds of a range and partition it around the cheapest split between bins
+	int rtBVH::splitBinned(int first, int count, int depth, rtAABB& bounds, vector<rtBVHPrimRef>& primRefs, bool parallel)
+	{
+		//Split large ranges into chunks that are processed by separate threads
+		int numChunks = (parallel && count >= parallelBinThreshold) ? numBuildThreads : 1;
+		int chunkSize = (count + numChunks - 1) / numChunks;
+
+		///Calculate the bounds of the primitives and of their centroids
+		auto boundChunk = [&](int chunkFirst, int chunkEnd, rtAABB& chunkBounds, rtAABB& chunkCentroidBounds) {
+			for (int i = chunkFirst; i < chunkEnd; i++)
+			{
+				chunkBounds.expand(primRefs[i].bounds);
+				chunkCentroidBounds.expand(primRefs[i].centroid);
+			}
+		};
+
+		rtAABB centroidBounds;
+		bounds = rtAABB();
+
+		if (numChunks == 1)
+		{
+			boundChunk(first, first + count, bounds, centroidBounds);
+		}
+		else
+		{
+			vector<rtAABB> chunkBounds(numChunks);
+			vector<rtAABB> chunkCentroidBounds(numChunks);
+
+			runParallel(numChunks, [&](int chunk) {
+				int chunkFirst = first + chunk * chunkSize;
+				boundChunk(chunkFirst, min(chunkFirst + chunkSize, first + count), chunkBounds[chunk], chunkCentroidBounds[chunk]);
+			});
+
+			for (int chunk = 0; chunk < numChunks; chunk++)
+			{
+				bounds.expand(chunkBounds[chunk]);
+				centroidBounds.expand(chunkCentroidBounds[chunk]);
+			}
+		}
+
+		if (count == 1 || depth >= maxDepth - 1)
+			return 0;
+
+		//The scale that maps a centroid to a bin along each axis
+		rtVec3f centroidMin = centroidBounds.getMin();
+		rtVec3f centroidExtent = centroidBounds.getExtent();
+		float binScale[3];
+
+		for (int axis = 0; axis < 3; axis++)
+			binScale[axis] = (centroidExtent.getAxis(axis) > 0.0f) ? binCount / centroidExtent.getAxis(axis) : 0.0f;
+
+		//Returns the bin that a primitive falls into along the given axis
+		auto getBin = [&](const rtBVHPrimRef& primRef, int axis) {
+			int bin = (int)((primRef.centroid.getAxis(axis) - centroidMin.getAxis(axis)) * binScale[axis]);
+			return min(bin, binCount - 1);
+		};
+
+		///Bin the primitives along all three axes. Bins are stored per axis, so the bin for an axis is at axis * binCount + bin.
+		auto binChunk = [&](int chunkFirst, int chunkEnd, rtBVHBin* chunkBins) {
+			for (int i = chunkFirst; i < chunkEnd; i++)
+			{
+				for (int axis = 0; axis < 3; axis++)
+				{
+					rtBVHBin& bin = chunkBins[axis * binCount + getBin(primRefs[i], axis)];
+					bin.bounds.expand(primRefs[i].bounds);
+					bin.primCount++;
+				}
+			}
+		};
+
+		rtBVHBin bins[3][binCount];
+
+		if (numChunks == 1)
+		{
+			binChunk(first, first + count, &bins[0][0]);
+		}
+		else
+		{
+			vector<rtBVHBin> chunkBins(numChunks * 3 * binCount);
+
+			runParallel(numChunks, [&](int chunk) {
+				int chunkFirst = first + chunk * chunkSize;
+				binChunk(chunkFirst, min(chunkFirst + chunkSize, first + count), &chunkBins[chunk * 3 * binCount]);
+			});
+
+			//Merge the bins of each chunk
+			for (int chunk = 0; chunk < numChunks; chunk++)
+			{
+				for (int axis = 0; axis < 3; axis++)
+				{
+					for (int bin = 0; bin < binCount; bin++)
+					{
+						rtBVHBin& chunkBin = chunkBins[(chunk * 3 + axis) * binCount + bin];
+						bins[axis][bin].bounds.expand(chunkBin.bounds);
+						bins[axis][bin].primCount += chunkBin.primCount;
+					}
+				}
+			}
+		}
+
+		///Evaluate the cost of splitting between each pair of bins
+		int bestAxis = -1;
+		int bestBin = 0;
+		float bestCost = INFINITY;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (binScale[axis] == 0.0f)
+				continue;
+
+			//Sweep from the right, storing the area and count of every suffix of bins
+			float rightArea[binCount];
+			int rightCount[binCount];
+			rtAABB rightBounds;
+			int rightPrims = 0;
+
+			for (int bin = binCount - 1; bin > 0; bin--)
+			{
+				rightBounds.expand(bins[axis][bin].bounds);
+				rightPrims += bins[axis][bin].primCount;
+				rightArea[bin] = rightBounds.getSurfaceArea();
+				rightCount[bin] = rightPrims;
+			}
+
+			//Sweep from the left and compute the cost of splitting before each bin
+			rtAABB leftBounds;
+			int leftPrims = 0;
+
+			for (int bin = 1; bin < binCount; bin++)
+			{
+				leftBounds.expand(bins[axis][bin - 1].bounds);
+				leftPrims += bins[axis][bin - 1].primCount;
+
+				//Skip splits that leave one side empty
+				if (leftPrims == 0 || rightCount[bin] == 0)
+					continue;
+
+				float cost = leftBounds.getSurfaceArea() * getLeafTests(leftPrims) + rightArea[bin] * getLeafTests(rightCount[bin]);
+
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = bin;
+				}
+			}
+		}
+
+		rtBVHPrimRef* range = &primRefs[first];
+
+		if (bestAxis == -1)
+		{
+			//The centroids all coincide, so only split the range in half if the leaf would be too large
+			if (count <= maxLeafSize)
+				return 0;
+
+			return count / 2;
+		}
+
+		//Compare the cost of intersecting every primitive against the cost of splitting
+		float leafCost = intersectionCost * getLeafTests(count);
+		float splitCost = traversalCost + intersectionCost * bestCost / bounds.getSurfaceArea();
+
+		if (count <= maxLeafSize && leafCost <= splitCost)
+			return 0;
+
+		//Move the primitives in the bins left of the split to the start of the range
+		rtBVHPrimRef* middle = partition(range, range + count, [&](const rtBVHPrimRef& primRef) {
+			return getBin(primRef, bestAxis) < bestBin;
+		});
+
+		return middle - range;
+	}
+
+	//Run a number of independent tasks across the build threads. The calling thread also runs tasks.
+	template<typename Task>
+	void rtBVH::runParallel(int numTasks, Task task)
+	{
+		if (numTasks <= 1 || numBuildThreads <= 1)
+		{
+			for (int taskIndex = 0; taskIndex < numTasks; taskIndex++)
+				task(taskIndex);
+
+			return;
+		}
+
+		//Each thread takes the next task until there are none left
+		atomic<int> nextTask(0);
+
+		auto runTasks = [&]() {
+			for (int taskIndex = nextTask++; taskIndex < numTasks; taskIndex = nextTask++)
+				task(taskIndex);
+		};
+
+		int numThreads = min(numTasks, numBuildThreads);
+		vector<thread> threads;
+
+		for (int threadIndex = 1; threadIndex < numThreads; threadIndex++)
+			threads.emplace_back(runTasks);
+
+		runTasks();
+
+		for (int threadIndex = 0; threadIndex < threads.size(); threadIndex++)
+			threads[threadIndex].join();
+	}
+
+
+	///Wide layout methods
+	void rtBVH::collapse()
+	{
+		wide4Nodes.clear();
+		wide8Nodes.clear();
+		wideSourceNodes.clear();
+
+		if (nodes.empty())
+			return;
+
+		if (layout == bvhLayout::wide4)
+			collapseNode(wide4Nodes, 0);
+		else if (layout == bvhLayout::wide8)
+			collapseNode(wide8Nodes, 0);
+	}
+
+	template<int width>
+	int rtBVH::collapseNode(vector<rtBVHWideNode<width>>& wideNodes, int nodeIndex)
+	{
+		//Start with the children of the binary node, or the node itself if it is a leaf
+		int slots[width];
+		int slotCount = 0;
+
+		if (nodes[nodeIndex].isLeaf())
+		{
+			slots[slotCount++] = nodeIndex;
+		}
+		else
+		{
+			slots[slotCount++] = nodes[nodeIndex].leftFirst;
+			slots[slotCount++] = nodes[nodeIndex].leftFirst + 1;
+		}
+
+		//Replace the internal child with the largest area by its two children until the node is full
+		while (slotCount < width)
+		{
+			int largestSlot = -1;
+			float largestArea = -1.0f;
+
+			for (int slot = 0; slot < slotCount; slot++)
+			{
+				const rtBVHNode& child = nodes[slots[slot]];
+
+				if (!child.isLeaf() && child.bounds.getSurfaceArea() > largestArea)
+				{
+					largestArea = child.bounds.getSurfaceArea();
+					largestSlot = slot;
+				}
+			}
+
+			if (largestSlot == -1)
+				break;
+
+			int expanded = slots[largestSlot];
+			slots[largestSlot] = nodes[expanded].leftFirst;
+			slots[slotCount++] = nodes[expanded].leftFirst + 1;
+		}
+
+		//Children are added after their parent, so the root stays at index 0
+		int wideIndex = wideNodes.size();
+		wideNodes.push_back(rtBVHWideNode<width>());
+		wideSourceNodes.resize(wideNodes.size() * width, -1);
+
+		for (int slot = 0; slot < width; slot++)
+		{
+			if (slot >= slotCount)
+			{
+				wideNodes[wideIndex].setEmpty(slot);
+				continue;
+			}
+
+			wideSourceNodes[wideIndex * width + slot] = slots[slot];
+
+			const rtBVHNode& child = nodes[slots[slot]];
+
+			if (child.isLeaf())
+			{
+				wideNodes[wideIndex].setChild(slot, child.bounds, child.leftFirst, child.primCount);
+			}
+			else
+			{
+				//Collapsing the child may reallocate the node list, so index it again afterwards
+				int childIndex = collapseNode(wideNodes, slots[slot]);
+				wideNodes[wideIndex].setChild(slot, child.bounds, childIndex, 0);
+			}
+		}
+
+		return wideIndex;
+	}
+
+	template<int width>
+	void rtBVH::refitWide(vector<rtBVHWideNode<width>>& wideNodes)
+	{
+		for (int wideIndex = 0; wideIndex < wideNodes.size(); wideIndex++)
+		{
+			rtBVHWideNode<width>& wideNode = wideNodes[wideIndex];
+
+			for (int slot = 0; slot < width; slot++)
+			{
+				int sourceNode = wideSourceNodes[wideIndex * width + slot];
+
+				if (sourceNode != -1)
+					wideNode.setChild(slot, nodes[sourceNode].bounds, wideNode.child[slot], wideNode.primCount[slot]);
+			}
+		}
+	}
+
+
+	///Statistics
+	//Sum the cost of each node weighted by the probability that a ray through the root also passes through the node
+	float rtBVH::calcSAHCost() const
+	{
+		if (nodes.empty())
+			return 0.0f;
+
+		float rootArea = nodes[0].bounds.getSurfaceArea();
+
+		if (rootArea <= 0.0f)
+			return 0.0f;
+
+		float cost = 0.0f;
+
+		for (int nodeIndex = 0; nodeIndex < nodes.size(); nodeIndex++)
+		{
+			const rtBVHNode& node = nodes[nodeIndex];
+			float probability = node.bounds.getSurfaceArea() / rootArea;
+
+			if (node.isLeaf())
+				cost += intersectionCost * getLeafTests(node.primCount) * probability;
+			else
+				cost += traversalCost * probability;
+		}
+
+		return cost;
+	}
+}
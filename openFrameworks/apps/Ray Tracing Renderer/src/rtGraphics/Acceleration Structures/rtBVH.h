@@ -0,0 +1,489 @@
+#pragma once
+
+#include <vector>
+#include <math.h>
+#include "../Data Classes/rtVec3f.h"
+#include "../Data Classes/rtAABB.h"
+#include "../Data Classes/Data Types.h"
+#include "../Data Classes/rtRayPacket.h"
+#include "rtBVHWideNode.h"
+
+using namespace std;
+
+namespace rtGraphics
+{
+	/*
+	 * A node of a bounding volume hierarchy
+	 * Leaves store a range of the primitive index list. Internal nodes store the index of their left child, and the right child directly follows it.
+	 */
+	struct rtBVHNode
+	{
+		rtAABB bounds;
+		//The index of the left child for internal nodes, or the first primitive for leaves
+		int leftFirst;
+		//The number of primitives in a leaf. Internal nodes have no primitives.
+		int primCount;
+
+		bool isLeaf() const { return primCount > 0; }
+	};
+
+
+	//Statistics about the last build of a hierarchy
+	struct rtBVHBuildStats
+	{
+		bvhBuildMethod method = bvhBuildMethod::sweepSAH;
+		//The time taken to build the hierarchy in milliseconds
+		double buildTime = 0.0;
+		//The expected cost of tracing a ray through the tree according to the SAH. Lower is better.
+		float sahCost = 0.0f;
+		int nodeCount = 0;
+		int leafCount = 0;
+	};
+
+
+	//A primitive reference used by the binned SAH builder. References are partitioned in place so each range stays contiguous in memory.
+	struct rtBVHPrimRef
+	{
+		rtAABB bounds;
+		rtVec3f centroid;
+		int primIndex;
+	};
+
+
+	//A bin of primitives used by the binned SAH builder
+	struct rtBVHBin
+	{
+		rtAABB bounds;
+		int primCount = 0;
+	};
+
+
+	/*
+	 * A binary bounding volume hierarchy built with the surface area heuristic
+	 * The hierarchy only stores the bounds of its primitives. Owners provide a leaf intersector when traversing.
+	 * The binary tree can be collapsed into a 4 or 8 wide tree, which is then used for traversal.
+	 */
+	class rtBVH
+	{
+	private:
+		vector<rtBVHNode> nodes;
+		//The primitive indices, ordered so that each leaf references a contiguous range
+		vector<int> primIndices;
+		//The collapsed tree. Only the one matching the layout used for the last build is filled.
+		vector<rtBVHWideNode<4>> wide4Nodes;
+		vector<rtBVHWideNode<8>> wide8Nodes;
+		//The binary node copied into each slot of the wide tree, so a refit can update the wide bounds without collapsing again
+		vector<int> wideSourceNodes;
+
+		///SAH constants
+		//The estimated cost of visiting a node relative to intersecting a primitive
+		static float traversalCost;
+		static float intersectionCost;
+		//Leaves larger than this are always split if possible
+		static int maxLeafSize;
+		//The number of primitives the owner intersects at once. Leaves are costed by the number of blocks they fill.
+		int leafBlockWidth = 1;
+
+		///Build settings
+		static bvhBuildMethod buildMethod;
+		//The node layout used for traversal
+		static bvhLayout layout;
+		//The number of threads used by the binned builder. Matches the number of render threads.
+		static int numBuildThreads;
+		//The number of bins per axis used by the binned builder
+		static const int binCount = 16;
+		//Ranges with fewer primitives than this are binned on a single thread
+		static const int parallelBinThreshold = 65536;
+
+		//Statistics about the last build
+		rtBVHBuildStats buildStats;
+		//The SAH cost of the tree after the last build or refit
+		float currentSAHCost = 0.0f;
+		//The tree is considered degraded once refitting raises its SAH cost by this factor over the cost after the build
+		static float rebuildThreshold;
+
+		///Sweep build methods
+		void buildSweep(const vector<rtAABB>& primBounds, const vector<rtVec3f>& centroids);
+		void buildNode(int nodeIndex, int first, int count, int depth, const vector<rtAABB>& primBounds, const vector<rtVec3f>& centroids, vector<float>& areaBuffer);
+
+		///Binned build methods
+		void buildBinned(const vector<rtAABB>& primBounds, const vector<rtVec3f>& centroids);
+		//Recursively build a subtree into the given node list
+		void buildSubtreeBinned(vector<rtBVHNode>& nodeList, int nodeIndex, int first, int count, int depth, vector<rtBVHPrimRef>& primRefs);
+		//Calculate the bounds of a range and split it. Returns the number of primitives placed in the left child, or 0 if the range should be a leaf.
+		int splitBinned(int first, int count, int depth, rtAABB& bounds, vector<rtBVHPrimRef>& primRefs, bool parallel);
+		//Run a number of independent tasks across the build threads
+		template<typename Task>
+		static void runParallel(int numTasks, Task task);
+
+		///Wide layout methods
+		//Collapse the binary tree into the wide tree matching the current layout
+		void collapse();
+		//Collapse the binary subtree into a wide node, absorbing the children with the largest area until the node is full
+		template<int width>
+		int collapseNode(vector<rtBVHWideNode<width>>& wideNodes, int nodeIndex);
+		//Copy the bounds of the binary nodes into the wide tree after a refit
+		template<int width>
+		void refitWide(vector<rtBVHWideNode<width>>& wideNodes);
+
+		///Statistics
+		float calcSAHCost() const;
+		//The number of intersection tests needed for a leaf with the given number of primitives
+		int getLeafTests(int primCount) const;
+
+		///Traversal
+		template<typename LeafIntersector>
+		void traverseBinary(const rtVec3f& P, const rtVec3f& D, float tMin, float& tMax, LeafIntersector& intersectLeaf) const;
+		template<int width, typename LeafIntersector>
+		void traverseWide(const vector<rtBVHWideNode<width>>& wideNodes, const rtVec3f& P, const rtVec3f& D, float tMin, float& tMax, LeafIntersector& intersectLeaf) const;
+
+	public:
+		//The maximum depth of the tree. Traversal uses a fixed size stack of this size.
+		static const int maxDepth = 64;
+
+		///Build methods
+		//Build the hierarchy over the given primitive bounds using the current build method
+		void build(const vector<rtAABB>& primBounds);
+		//Update the bounds of every node bottom-up after the primitives move, keeping the tree topology. Takes O(n) time.
+		void refit(const vector<rtAABB>& primBounds);
+		void clear();
+
+		///Build settings
+		static bvhBuildMethod getBuildMethod();
+		static void setBuildMethod(bvhBuildMethod method);
+		static int getNumBuildThreads();
+		static void setNumBuildThreads(int numThreads);
+		static bvhLayout getLayout();
+		//The layout takes effect the next time a hierarchy is built
+		static void setLayout(bvhLayout layout);
+		static float getRebuildThreshold();
+		static void setRebuildThreshold(float threshold);
+		int getLeafBlockWidth() const;
+		//Set the number of primitives the leaf intersector tests at once. Takes effect the next time the hierarchy is built.
+		void setLeafBlockWidth(int width);
+
+		///Getters
+		const rtBVHBuildStats& getBuildStats() const;
+		float getCurrentSAHCost() const;
+		//Returns true if refitting has degraded the tree enough that rebuilding it would be cheaper than tracing through it
+		bool isDegraded() const;
+		bool isEmpty() const;
+		rtAABB getBounds() const;
+		int getNodeCount() const;
+		//Returns the number of nodes in the collapsed tree, or 0 for the binary layout
+		int getWideNodeCount() const;
+		//Returns the primitive stored at the given position of a leaf range
+		int getPrimIndex(int position) const;
+		//Call visitLeaf(first, count) for every leaf, such as to pack the primitives in leaf order
+		template<typename LeafVisitor>
+		void forEachLeaf(LeafVisitor visitLeaf) const;
+
+		/*
+		 * Traverse the hierarchy nearest child first, skipping any node that starts beyond the current tMax. Uses the wide tree if there is one.
+		 * The intersector is called as intersectLeaf(first, count, tMax) for each leaf the ray reaches, and should lower tMax when it finds a closer hit
+		 */
+		template<typename LeafIntersector>
+		void traverse(const rtVec3f& P, const rtVec3f& D, float tMin, float& tMax, LeafIntersector intersectLeaf) const;
+		/*
+		 * Traverse the hierarchy until any primitive is hit, such as for shadow rays. Returns true if the intersector reported a hit.
+		 * The intersector is called as intersectLeaf(first, count) and should return true as soon as it finds a hit.
+		 */
+		template<typename LeafOccluder>
+		bool traverseAny(const rtVec3f& P, const rtVec3f& D, float tMin, float tMax, LeafOccluder intersectLeaf) const;
+		/*
+		 * Traverse the binary tree with a coherent packet of rays, each with its own tMax. Only the rays in activeMasks are traced.
+		 * Nodes are tested against every ray that reached their parent, and are skipped once none of them hit.
+		 * The intersector is called as intersectLeaf(first, count, leafMasks) with the rays that reach each leaf, and should lower their tMax.
+		 */
+		template<typename PacketIntersector>
+		void traversePacket(const rtRayPacket& packet, const int* activeMasks, float tMin, float* tMax, PacketIntersector intersectLeaf) const;
+	};
+
+	///In-line method definitions
+	//Build settings
+	inline bvhBuildMethod rtBVH::getBuildMethod() { return buildMethod; }
+	inline void rtBVH::setBuildMethod(bvhBuildMethod method) { buildMethod = method; }
+	inline int rtBVH::getNumBuildThreads() { return numBuildThreads; }
+	inline void rtBVH::setNumBuildThreads(int numThreads) { numBuildThreads = (numThreads > 0) ? numThreads : 1; }
+	inline bvhLayout rtBVH::getLayout() { return layout; }
+	inline void rtBVH::setLayout(bvhLayout layout) { rtBVH::layout = layout; }
+	inline float rtBVH::getRebuildThreshold() { return rebuildThreshold; }
+	inline void rtBVH::setRebuildThreshold(float threshold) { rebuildThreshold = threshold; }
+	inline int rtBVH::getLeafBlockWidth() const { return leafBlockWidth; }
+	inline void rtBVH::setLeafBlockWidth(int width) { leafBlockWidth = (width > 0) ? width : 1; }
+
+	//Getters
+	inline const rtBVHBuildStats& rtBVH::getBuildStats() const { return buildStats; }
+	inline float rtBVH::getCurrentSAHCost() const { return currentSAHCost; }
+	inline bool rtBVH::isDegraded() const { return currentSAHCost > buildStats.sahCost * rebuildThreshold; }
+	inline bool rtBVH::isEmpty() const { return nodes.empty(); }
+	inline rtAABB rtBVH::getBounds() const { return nodes.empty() ? rtAABB() : nodes[0].bounds; }
+	inline int rtBVH::getNodeCount() const { return nodes.size(); }
+	inline int rtBVH::getWideNodeCount() const { return wide4Nodes.size() + wide8Nodes.size(); }
+	inline int rtBVH::getPrimIndex(int position) const { return primIndices[position]; }
+
+	//Statistics
+	inline int rtBVH::getLeafTests(int primCount) const { return (primCount + leafBlockWidth - 1) / leafBlockWidth; }
+
+	template<typename LeafVisitor>
+	inline void rtBVH::forEachLeaf(LeafVisitor visitLeaf) const
+	{
+		for (int nodeIndex = 0; nodeIndex < nodes.size(); nodeIndex++)
+			if (nodes[nodeIndex].isLeaf())
+				visitLeaf(nodes[nodeIndex].leftFirst, nodes[nodeIndex].primCount);
+	}
+
+	//Traversal
+	template<typename LeafIntersector>
+	inline void rtBVH::traverse(const rtVec3f& P, const rtVec3f& D, float tMin, float& tMax, LeafIntersector intersectLeaf) const
+	{
+		if (!wide8Nodes.empty())
+			traverseWide(wide8Nodes, P, D, tMin, tMax, intersectLeaf);
+		else if (!wide4Nodes.empty())
+			traverseWide(wide4Nodes, P, D, tMin, tMax, intersectLeaf);
+		else
+			traverseBinary(P, D, tMin, tMax, intersectLeaf);
+	}
+
+	template<typename LeafOccluder>
+	inline bool rtBVH::traverseAny(const rtVec3f& P, const rtVec3f& D, float tMin, float tMax, LeafOccluder intersectLeaf) const
+	{
+		bool occluded = false;
+
+		//Once a hit is found, lowering the cutoff below every entry distance ends the traversal
+		traverse(P, D, tMin, tMax, [&](int first, int count, float& tCutoff) {
+			if (intersectLeaf(first, count))
+			{
+				occluded = true;
+				tCutoff = -INFINITY;
+			}
+		});
+
+		return occluded;
+	}
+
+	template<typename LeafIntersector>
+	inline void rtBVH::traverseBinary(const rtVec3f& P, const rtVec3f& D, float tMin, float& tMax, LeafIntersector& intersectLeaf) const
+	{
+		if (nodes.empty())
+			return;
+
+		//Division by a zero component gives an infinite inverse, which the slab test handles
+		rtVec3f invD(1.0f / D.getX(), 1.0f / D.getY(), 1.0f / D.getZ());
+
+		//A stack of nodes to visit along with the distance where the ray enters them
+		int nodeStack[maxDepth];
+		float enterStack[maxDepth];
+		int stackSize = 0;
+
+		float tEnter;
+
+		if (!nodes[0].bounds.rayIntersect(P, invD, tMin, tMax, tEnter))
+			return;
+
+		nodeStack[stackSize] = 0;
+		enterStack[stackSize++] = tEnter;
+
+		while (stackSize > 0)
+		{
+			stackSize--;
+
+			//A closer hit may have been found since this node was pushed
+			if (enterStack[stackSize] > tMax)
+				continue;
+
+			const rtBVHNode& node = nodes[nodeStack[stackSize]];
+
+			if (node.isLeaf())
+			{
+				intersectLeaf(node.leftFirst, node.primCount, tMax);
+				continue;
+			}
+
+			//Test both children
+			int left = node.leftFirst;
+			int right = node.leftFirst + 1;
+			float tLeft, tRight;
+			bool hitLeft = nodes[left].bounds.rayIntersect(P, invD, tMin, tMax, tLeft);
+			bool hitRight = nodes[right].bounds.rayIntersect(P, invD, tMin, tMax, tRight);
+
+			if (hitLeft && hitRight)
+			{
+				//Push the far child first so the near child is visited next
+				if (tLeft <= tRight)
+				{
+					nodeStack[stackSize] = right;
+					enterStack[stackSize++] = tRight;
+					nodeStack[stackSize] = left;
+					enterStack[stackSize++] = tLeft;
+				}
+				else
+				{
+					nodeStack[stackSize] = left;
+					enterStack[stackSize++] = tLeft;
+					nodeStack[stackSize] = right;
+					enterStack[stackSize++] = tRight;
+				}
+			}
+			else if (hitLeft)
+			{
+				nodeStack[stackSize] = left;
+				enterStack[stackSize++] = tLeft;
+			}
+			else if (hitRight)
+			{
+				nodeStack[stackSize] = right;
+				enterStack[stackSize++] = tRight;
+			}
+		}
+	}
+
+	template<int width, typename LeafIntersector>
+	inline void rtBVH::traverseWide(const vector<rtBVHWideNode<width>>& wideNodes, const rtVec3f& P, const rtVec3f& D, float tMin, float& tMax, LeafIntersector& intersectLeaf) const
+	{
+		rtBVHWideRay ray(P, D);
+
+		/*
+		 * A stack of entries to visit along with the distance where the ray enters them
+		 * Leaf children are pushed as well so they are visited in order. They are stored as -(nodeIndex * width + slot) - 1.
+		 * Each level pushes at most width entries, and the tree is no deeper than the binary tree.
+		 */
+		int entryStack[maxDepth * width];
+		float enterStack[maxDepth * width];
+		int stackSize = 0;
+
+		entryStack[stackSize] = 0;
+		enterStack[stackSize++] = tMin;
+
+		while (stackSize > 0)
+		{
+			stackSize--;
+
+			//A closer hit may have been found since this entry was pushed
+			if (enterStack[stackSize] > tMax)
+				continue;
+
+			int entry = entryStack[stackSize];
+
+			if (entry < 0)
+			{
+				int leaf = -entry - 1;
+				const rtBVHWideNode<width>& parent = wideNodes[leaf / width];
+
+				intersectLeaf(parent.child[leaf % width], parent.primCount[leaf % width], tMax);
+				continue;
+			}
+
+			const rtBVHWideNode<width>& node = wideNodes[entry];
+			float tEnter[width];
+			int hitMask = intersectChildren(node, ray, tMin, tMax, tEnter);
+
+			//Sort the children that were hit from far to near
+			int hitSlots[width];
+			int hitCount = 0;
+
+			for (int slot = 0; slot < width; slot++)
+			{
+				if (!(hitMask & (1 << slot)))
+					continue;
+
+				int insert = hitCount++;
+
+				while (insert > 0 && tEnter[hitSlots[insert - 1]] < tEnter[slot])
+				{
+					hitSlots[insert] = hitSlots[insert - 1];
+					insert--;
+				}
+
+				hitSlots[insert] = slot;
+			}
+
+			//Push the far children first so the nearest child is visited next
+			for (int hit = 0; hit < hitCount; hit++)
+			{
+				int slot = hitSlots[hit];
+
+				entryStack[stackSize] = (node.primCount[slot] > 0) ? -(entry * width + slot) - 1 : node.child[slot];
+				enterStack[stackSize++] = tEnter[slot];
+			}
+		}
+	}
+
+	template<typename PacketIntersector>
+	inline void rtBVH::traversePacket(const rtRayPacket& packet, const int* activeMasks, float tMin, float* tMax, PacketIntersector intersectLeaf) const
+	{
+		if (nodes.empty())
+			return;
+
+		//A stack of nodes to visit along with the rays that reached their parent
+		int nodeStack[maxDepth];
+		int maskStack[maxDepth][rtRayPacket::maxGroups];
+		int stackSize = 0;
+
+		nodeStack[stackSize] = 0;
+
+		for (int group = 0; group < packet.numGroups; group++)
+			maskStack[stackSize][group] = activeMasks[group];
+
+		stackSize++;
+
+		//The first active ray decides which child is visited first
+		rtVec3f orderDir;
+
+		for (int ray = 0; ray < packet.size; ray++)
+		{
+			if (packet.isActive(activeMasks, ray))
+			{
+				orderDir = packet.directions[ray];
+				break;
+			}
+		}
+
+		while (stackSize > 0)
+		{
+			stackSize--;
+
+			const rtBVHNode& node = nodes[nodeStack[stackSize]];
+			const int* parentMasks = maskStack[stackSize];
+
+			//Test the node against the rays that reached its parent. Closer hits may have been found since it was pushed.
+			int nodeMasks[rtRayPacket::maxGroups];
+			bool anyHit = false;
+
+			for (int group = 0; group < packet.numGroups; group++)
+			{
+				nodeMasks[group] = parentMasks[group] ? packet.intersectBox(node.bounds, group, parentMasks[group], tMin, tMax) : 0;
+				anyHit |= (nodeMasks[group] != 0);
+			}
+
+			if (!anyHit)
+				continue;
+
+			if (node.isLeaf())
+			{
+				intersectLeaf(node.leftFirst, node.primCount, nodeMasks);
+				continue;
+			}
+
+			//Push the far child first so the near child is visited next
+			int left = node.leftFirst;
+			int right = node.leftFirst + 1;
+			float leftDist = (nodes[left].bounds.getCentroid() - packet.origin).dot(orderDir);
+			float rightDist = (nodes[right].bounds.getCentroid() - packet.origin).dot(orderDir);
+
+			int nearChild = (leftDist <= rightDist) ? left : right;
+			int farChild = (leftDist <= rightDist) ? right : left;
+
+			nodeStack[stackSize] = farChild;
+			nodeStack[stackSize + 1] = nearChild;
+
+			for (int group = 0; group < packet.numGroups; group++)
+			{
+				maskStack[stackSize][group] = nodeMasks[group];
+				maskStack[stackSize + 1][group] = nodeMasks[group];
+			}
+
+			stackSize += 2;
+		}
+	}
+}
\ No newline at end of file
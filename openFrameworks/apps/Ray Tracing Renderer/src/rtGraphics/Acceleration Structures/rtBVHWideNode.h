@@ -0,0 +1,138 @@
+#pragma once
+
+#include <math.h>
+#include <immintrin.h>
+#include "../Data Classes/rtVec3f.h"
+#include "../Data Classes/rtAABB.h"
+
+namespace rtGraphics
+{
+	/*
+	 * A node of a collapsed BVH with up to 4 or 8 children
+	 * The child bounds are stored as structure of arrays so that one SIMD slab test covers every child of the node.
+	 */
+	template<int width>
+	struct rtBVHWideNode
+	{
+		//The bounds of each child, indexed as [min or max][axis][child]
+		float bounds[2][3][width];
+		//The index of the child node, or the first primitive for leaf children
+		int child[width];
+		//The number of primitives in leaf children. Internal children have 0 and empty slots have -1.
+		int primCount[width];
+
+		void setChild(int slot, const rtAABB& childBounds, int childIndex, int childPrimCount);
+		void setEmpty(int slot);
+	};
+
+	//A ray prepared for the wide slab tests
+	struct rtBVHWideRay
+	{
+		float origin[3];
+		float invDir[3];
+		//1 if the ray points in the negative direction along the axis, so the max plane is entered first
+		int sign[3];
+
+		rtBVHWideRay(const rtVec3f& P, const rtVec3f& D);
+	};
+
+	///Constructors
+	inline rtBVHWideRay::rtBVHWideRay(const rtVec3f& P, const rtVec3f& D)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			origin[axis] = P.getAxis(axis);
+			//Division by a zero component gives an infinite inverse with the sign of the zero
+			invDir[axis] = 1.0f / D.getAxis(axis);
+			sign[axis] = signbit(invDir[axis]) ? 1 : 0;
+		}
+	}
+
+	///In-line method definitions
+	template<int width>
+	inline void rtBVHWideNode<width>::setChild(int slot, const rtAABB& childBounds, int childIndex, int childPrimCount)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			bounds[0][axis][slot] = childBounds.getMin().getAxis(axis);
+			bounds[1][axis][slot] = childBounds.getMax().getAxis(axis);
+		}
+
+		child[slot] = childIndex;
+		primCount[slot] = childPrimCount;
+	}
+
+	//Empty slots have inverted bounds. Since the slab test enters the near plane by the ray direction, an inverted box is never hit.
+	template<int width>
+	inline void rtBVHWideNode<width>::setEmpty(int slot)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			bounds[0][axis][slot] = INFINITY;
+			bounds[1][axis][slot] = -INFINITY;
+		}
+
+		child[slot] = 0;
+		primCount[slot] = -1;
+	}
+
+	/*
+	 * Slab test between a ray and 4 child boxes starting at the given offset of each bounds array
+	 * Returns a bit mask of the children hit within [tMin, tMax] and stores the entry distance of each child.
+	 * A NaN from an origin lying on a slab is discarded, since max and min return their second operand when either is NaN.
+	 */
+	template<int width>
+	inline int intersectChildrenSSE(const rtBVHWideNode<width>& node, int offset, const rtBVHWideRay& ray, float tMin, float tMax, float* tEnter)
+	{
+		__m128 enter = _mm_set1_ps(tMin);
+		__m128 exit = _mm_set1_ps(tMax);
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			__m128 origin = _mm_set1_ps(ray.origin[axis]);
+			__m128 invDir = _mm_set1_ps(ray.invDir[axis]);
+			__m128 nearPlane = _mm_loadu_ps(&node.bounds[ray.sign[axis]][axis][offset]);
+			__m128 farPlane = _mm_loadu_ps(&node.bounds[1 - ray.sign[axis]][axis][offset]);
+
+			enter = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(nearPlane, origin), invDir), enter);
+			exit = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(farPlane, origin), invDir), exit);
+		}
+
+		_mm_storeu_ps(tEnter, enter);
+		return _mm_movemask_ps(_mm_cmple_ps(enter, exit));
+	}
+
+	//Test all the children of a node. Returns a bit mask of the children hit and stores their entry distances.
+	inline int intersectChildren(const rtBVHWideNode<4>& node, const rtBVHWideRay& ray, float tMin, float tMax, float* tEnter)
+	{
+		return intersectChildrenSSE(node, 0, ray, tMin, tMax, tEnter);
+	}
+
+	inline int intersectChildren(const rtBVHWideNode<8>& node, const rtBVHWideRay& ray, float tMin, float tMax, float* tEnter)
+	{
+#ifdef __AVX__
+		__m256 enter = _mm256_set1_ps(tMin);
+		__m256 exit = _mm256_set1_ps(tMax);
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			__m256 origin = _mm256_set1_ps(ray.origin[axis]);
+			__m256 invDir = _mm256_set1_ps(ray.invDir[axis]);
+			__m256 nearPlane = _mm256_loadu_ps(node.bounds[ray.sign[axis]][axis]);
+			__m256 farPlane = _mm256_loadu_ps(node.bounds[1 - ray.sign[axis]][axis]);
+
+			enter = _mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(nearPlane, origin), invDir), enter);
+			exit = _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(farPlane, origin), invDir), exit);
+		}
+
+		_mm256_storeu_ps(tEnter, enter);
+		return _mm256_movemask_ps(_mm256_cmp_ps(enter, exit, _CMP_LE_OQ));
+#else
+		//Without AVX, test each half of the children with SSE
+		int lowMask = intersectChildrenSSE(node, 0, ray, tMin, tMax, tEnter);
+		int highMask = intersectChildrenSSE(node, 4, ray, tMin, tMax, tEnter + 4);
+
+		return lowMask | (highMask << 4);
+#endif
+	}
+}
@@ -0,0 +1,163 @@
+#include "rtSceneBVH.h"
+
+namespace rtGraphics
+{
+	//Rebuild the hierarchy from the current bounds of the given objects
+	void rtSceneBVH::build(objectSet objects)
+	{
+		this->objects = objects;
+		boundedObjects.clear();
+		unboundedObjects.clear();
+
+		vector<rtAABB> objectBounds;
+		objectBounds.reserve(objects->size());
+
+		//Sort the objects by whether they can be placed in the hierarchy
+		for (int objectIndex = 0; objectIndex < objects->size(); objectIndex++)
+		{
+			rtObject* currObject = objects->at(objectIndex);
+			rtAABB bounds = currObject->getBounds();
+
+			if (bounds.isFinite())
+			{
+				boundedObjects.push_back(currObject);
+				objectBounds.push_back(bounds);
+			}
+			else
+				unboundedObjects.push_back(currObject);
+		}
+
+		bvh.build(objectBounds);
+	}
+
+	//Find the closest object the ray hits
+	rtRayHit rtSceneBVH::rayIntersect(rtVec3f& P, rtVec3f& D, float nearClip, float farClip, rtRayHit& originPoint)
+	{
+		//The intersection data of the closest intersection
+		rtRayHit nearestHit;
+		//Set the hit data to a miss by default.
+		nearestHit.hit = false;
+		nearestHit.distance = INFINITY;
+
+		//The distance to the closest hit, used to cut off the traversal
+		float tNearest = farClip;
+
+		//Objects without bounds are always tested
+		for (int objectIndex = 0; objectIndex < unboundedObjects.size(); objectIndex++)
+		{
+			rtRayHit hitData = unboundedObjects[objectIndex]->rayIntersect(P, D, nearClip, tNearest, originPoint);
+
+			if (hitData.hit && hitData.distance < nearestHit.distance)
+			{
+				nearestHit = hitData;
+				tNearest = fminf(tNearest, hitData.distance);
+			}
+		}
+
+		//Only call the intersectors of the objects in the leaves that the ray reaches
+		bvh.traverse(P, D, nearClip, tNearest, [&](int first, int count, float& tMax) {
+			for (int position = first; position < first + count; position++)
+			{
+				rtObject* currObject = boundedObjects[bvh.getPrimIndex(position)];
+
+				//Determine if the ray intersects the object
+				rtRayHit hitData = currObject->rayIntersect(P, D, nearClip, tMax, originPoint);
+
+				//If the ray hit and the object is not obscured, save hit data
+				if (hitData.hit && hitData.distance < nearestHit.distance)
+				{
+					nearestHit = hitData;
+					tMax = fminf(tMax, hitData.distance);
+				}
+			}
+		});
+
+		//Return the hit data
+		return nearestHit;
+	}
+
+	//Determine if any object blocks the ray, stopping at the first one found
+	bool rtSceneBVH::occluded(rtVec3f& P, rtVec3f& D, float nearClip, float maxDist, rtRayHit& originPoint)
+	{
+		//Objects without bounds are always tested
+		for (int objectIndex = 0; objectIndex < unboundedObjects.size(); objectIndex++)
+			if (unboundedObjects[objectIndex]->occluded(P, D, nearClip, maxDist, originPoint))
+				return true;
+
+		//Only test the objects in the leaves that the ray reaches
+		return bvh.traverseAny(P, D, nearClip, maxDist, [&](int first, int count) {
+			for (int position = first; position < first + count; position++)
+				if (boundedObjects[bvh.getPrimIndex(position)]->occluded(P, D, nearClip, maxDist, originPoint))
+					return true;
+
+			return false;
+		});
+	}
+
+	//Find the closest object hit by each ray of a packet
+	void rtSceneBVH::rayIntersectPacket(const rtRayPacket& packet, float nearClip, float farClip, rtRayHit* hits)
+	{
+		//The distance to the closest hit of each ray, used to cut off the traversal
+		float tNearest[maxPacketSize];
+
+		for (int ray = 0; ray < packet.numGroups * 4; ray++)
+		{
+			hits[ray].hit = false;
+			hits[ray].distance = INFINITY;
+			tNearest[ray] = farClip;
+		}
+
+		//If the rays diverge, fall back on tracing them one at a time
+		if (!packet.coherent)
+		{
+			//There is no origin point for a camera ray
+			rtRayHit originPoint;
+			rtVec3f P = packet.origin;
+
+			for (int ray = 0; ray < packet.size; ray++)
+			{
+				if (!packet.isActive(packet.activeMasks, ray))
+					continue;
+
+				rtVec3f D = packet.directions[ray];
+				hits[ray] = rayIntersect(P, D, nearClip, farClip, originPoint);
+			}
+
+			return;
+		}
+
+		//Objects without bounds are always tested
+		for (int objectIndex = 0; objectIndex < unboundedObjects.size(); objectIndex++)
+			unboundedObjects[objectIndex]->rayIntersectPacket(packet, packet.activeMasks, nearClip, tNearest, hits);
+
+		//Only call the intersectors of the objects in the leaves that the rays reach, with the rays that reach them
+		bvh.traversePacket(packet, packet.activeMasks, nearClip, tNearest, [&](int first, int count, const int* leafMasks) {
+			for (int position = first; position < first + count; position++)
+				boundedObjects[bvh.getPrimIndex(position)]->rayIntersectPacket(packet, leafMasks, nearClip, tNearest, hits);
+		});
+	}
+
+	//Find the closest object by testing every object
+	rtRayHit rtSceneBVH::rayIntersectLinear(rtVec3f& P, rtVec3f& D, float nearClip, float farClip, rtRayHit& originPoint)
+	{
+		//The intersection data of the closest intersection
+		rtRayHit nearestHit;
+		//Set the hit data to a miss by default.
+		nearestHit.hit = false;
+		nearestHit.distance = INFINITY;
+
+		//Iterate over the all the objects
+		for (int objectIndex = 0; objectIndex < objects->size(); objectIndex++)
+		{
+			//Determine if the ray intersects the object
+			rtRayHit hitData = objects->at(objectIndex)->rayIntersect(P, D, nearClip, farClip, originPoint);
+
+			//If the ray hit and the object is not obscured, save hit data
+			if (hitData.hit && hitData.distance < nearestHit.distance)
+				nearestHit = hitData;
+		}
+
+		//Return the hit data
+		return nearestHit;
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include "rtBVH.h"
+#include "../Data Classes/rtScene.h"
+#include "../Data Classes/rtRayHit.h"
+
+using namespace std;
+
+namespace rtGraphics
+{
+	/*
+	 * The top level of a two-level acceleration structure
+	 * Builds a bounding volume hierarchy over the world bounds of the objects in a scene, and only calls the intersectors of objects whose bounds the ray reaches
+	 */
+	class rtSceneBVH
+	{
+	private:
+		//All the objects in the scene
+		objectSet objects;
+		//The objects with finite bounds. The primitive indices of the hierarchy refer to this list.
+		vector<rtObject*> boundedObjects;
+		//Objects without finite bounds, such as planes, are tested by every ray
+		vector<rtObject*> unboundedObjects;
+		//The hierarchy over the bounded objects
+		rtBVH bvh;
+
+	public:
+		///Constructors
+		rtSceneBVH();
+		rtSceneBVH(objectSet objects);
+
+		//Rebuild the hierarchy from the current bounds of the given objects
+		void build(objectSet objects);
+
+		///Getters
+		objectSet& getObjects();
+		//Returns the bounds of the objects with finite bounds
+		rtAABB getBounds() const;
+
+		///Ray tracing methods
+		//Find the closest object the ray hits. The origin point is passed to each object to resolve surface intersection issues.
+		rtRayHit rayIntersect(rtVec3f& P, rtVec3f& D, float nearClip, float farClip, rtRayHit& originPoint);
+		//Determine if any object blocks the ray closer than maxDist. Used for shadow rays.
+		bool occluded(rtVec3f& P, rtVec3f& D, float nearClip, float maxDist, rtRayHit& originPoint);
+		//Find the closest object hit by each active ray of a packet of camera rays. Incoherent packets are traced one ray at a time.
+		void rayIntersectPacket(const rtRayPacket& packet, float nearClip, float farClip, rtRayHit* hits);
+		//Find the closest object by testing every object. Used as a reference for benchmarking.
+		rtRayHit rayIntersectLinear(rtVec3f& P, rtVec3f& D, float nearClip, float farClip, rtRayHit& originPoint);
+	};
+
+	///Constructors
+	inline rtSceneBVH::rtSceneBVH()
+	{
+		objects = make_shared<vector<rtObject*>>();
+	}
+
+	inline rtSceneBVH::rtSceneBVH(objectSet objects)
+	{
+		build(objects);
+	}
+
+	///In-line method definitions
+	//Getters
+	inline objectSet& rtSceneBVH::getObjects() { return objects; }
+	inline rtAABB rtSceneBVH::getBounds() const { return bvh.getBounds(); }
+}
@@ -1,3 +1,17 @@
 #pragma once
 
-enum class renderMode { rayTrace, rayMarch };
\ No newline at end of file
+enum class renderMode { rayTrace, rayMarch };
+//How ray traced rays are scheduled. Recursive traces each pixel depth-first, wavefront traces a tile one bounce at a time.
+enum class renderPipeline { recursive, wavefront };
+enum class bvhBuildMethod { sweepSAH, binnedSAH };
+enum class bvhLayout { binary, wide4, wide8 };
+//The width in pixels of the square blocks of camera rays traced together
+enum class rayPacketSize { single = 1, packet2x2 = 2, packet4x4 = 4, packet8x8 = 8 };
+//The number of frames a camera keeps. With more than one, the next frame renders in the background while the latest completed one is shown.
+enum class frameBuffering { single = 1, doubleBuffer = 2, tripleBuffer = 3 };
+//How radiance is mapped to the display. None clamps it as linear color, the others compress it into the display range and encode it as sRGB.
+enum class toneMapping { none, reinhard, aces };
+//How keyframed values change between keys. Linear moves straight between keys, smooth follows a curve through them.
+enum class interpolation { linear, smooth };
+//The outputs written for each pixel besides its color, from the hit of its camera ray
+enum class aovType { depth, normal, albedo, objectID, faceID };
\ No newline at end of file
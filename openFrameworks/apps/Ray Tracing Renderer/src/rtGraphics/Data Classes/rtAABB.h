@@ -0,0 +1,125 @@
+#pragma once
+
+#include <math.h>
+#include "rtVec3f.h"
+
+namespace rtGraphics
+{
+	//An axis-aligned bounding box defined by a minimum and maximum corner
+	class rtAABB
+	{
+	private:
+		rtVec3f minCorner;
+		rtVec3f maxCorner;
+
+	public:
+		///Constructors
+		rtAABB();
+		rtAABB(const rtVec3f& minCorner, const rtVec3f& maxCorner);
+
+		///Getters
+		rtVec3f getMin() const;
+		rtVec3f getMax() const;
+		rtVec3f getCentroid() const;
+		rtVec3f getExtent() const;
+		float getSurfaceArea() const;
+		//Returns the index of the axis with the largest extent
+		int getLongestAxis() const;
+		//An empty box contains no points and is the identity for expand()
+		bool isEmpty() const;
+		//Returns false for boxes that extend infinitely, such as the bounds of a plane
+		bool isFinite() const;
+
+		///Bounding Box Methods
+		//Grow the box to contain the given point or box
+		void expand(const rtVec3f& point);
+		void expand(const rtAABB& box);
+		/*
+		 * Slab test between the box and a ray, given the inverse of the ray direction
+		 * Returns true if the ray overlaps the box within [tMin, tMax] and stores the entry distance in tEnter
+		 */
+		bool rayIntersect(const rtVec3f& P, const rtVec3f& invD, float tMin, float tMax, float& tEnter) const;
+	};
+
+	///Constructors
+	//By default the box is empty
+	inline rtAABB::rtAABB() : minCorner(INFINITY), maxCorner(-INFINITY) {}
+	inline rtAABB::rtAABB(const rtVec3f& minCorner, const rtVec3f& maxCorner) : minCorner(minCorner), maxCorner(maxCorner) {}
+
+	///In-line method definitions
+	//Getters
+	inline rtVec3f rtAABB::getMin() const { return minCorner; }
+	inline rtVec3f rtAABB::getMax() const { return maxCorner; }
+	inline rtVec3f rtAABB::getCentroid() const { return (minCorner + maxCorner) * 0.5f; }
+	inline rtVec3f rtAABB::getExtent() const { return maxCorner - minCorner; }
+
+	inline float rtAABB::getSurfaceArea() const
+	{
+		if (isEmpty())
+			return 0.0f;
+
+		rtVec3f extent = getExtent();
+		return 2.0f * (extent.getX() * extent.getY() + extent.getY() * extent.getZ() + extent.getZ() * extent.getX());
+	}
+
+	inline int rtAABB::getLongestAxis() const
+	{
+		rtVec3f extent = getExtent();
+
+		if (extent.getX() >= extent.getY() && extent.getX() >= extent.getZ())
+			return 0;
+		if (extent.getY() >= extent.getZ())
+			return 1;
+
+		return 2;
+	}
+
+	inline bool rtAABB::isEmpty() const
+	{
+		return (minCorner.getX() > maxCorner.getX() || minCorner.getY() > maxCorner.getY() || minCorner.getZ() > maxCorner.getZ());
+	}
+
+	inline bool rtAABB::isFinite() const
+	{
+		return (isfinite(minCorner.getX()) && isfinite(minCorner.getY()) && isfinite(minCorner.getZ()) &&
+			isfinite(maxCorner.getX()) && isfinite(maxCorner.getY()) && isfinite(maxCorner.getZ()));
+	}
+
+	//Bounding Box Methods
+	inline void rtAABB::expand(const rtVec3f& point)
+	{
+		minCorner = minCorner.getMin(point);
+		maxCorner = maxCorner.getMax(point);
+	}
+
+	inline void rtAABB::expand(const rtAABB& box)
+	{
+		minCorner = minCorner.getMin(box.minCorner);
+		maxCorner = maxCorner.getMax(box.maxCorner);
+	}
+
+	inline bool rtAABB::rayIntersect(const rtVec3f& P, const rtVec3f& invD, float tMin, float tMax, float& tEnter) const
+	{
+		/*
+		 * Clip the ray interval against the three pairs of slabs
+		 * A zero direction component produces an infinite inverse, and the NaN produced when the origin lies on a slab is discarded by fmax/fmin
+		 */
+		float tx0 = (minCorner.getX() - P.getX()) * invD.getX();
+		float tx1 = (maxCorner.getX() - P.getX()) * invD.getX();
+		tMin = fmaxf(tMin, fminf(tx0, tx1));
+		tMax = fminf(tMax, fmaxf(tx0, tx1));
+
+		float ty0 = (minCorner.getY() - P.getY()) * invD.getY();
+		float ty1 = (maxCorner.getY() - P.getY()) * invD.getY();
+		tMin = fmaxf(tMin, fminf(ty0, ty1));
+		tMax = fminf(tMax, fmaxf(ty0, ty1));
+
+		float tz0 = (minCorner.getZ() - P.getZ()) * invD.getZ();
+		float tz1 = (maxCorner.getZ() - P.getZ()) * invD.getZ();
+		tMin = fmaxf(tMin, fminf(tz0, tz1));
+		tMax = fminf(tMax, fmaxf(tz0, tz1));
+
+		tEnter = tMin;
+		return tMin <= tMax;
+	}
+}
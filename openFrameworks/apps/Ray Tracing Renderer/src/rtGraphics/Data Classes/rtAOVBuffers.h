@@ -0,0 +1,164 @@
+#pragma once
+
+#include <string>
+#include <math.h>
+#include "ofPixels.h"
+#include "Data Types.h"
+#include "rtRayHit.h"
+
+using namespace std;
+
+namespace rtGraphics
+{
+	/*
+	 * Buffers of arbitrary output variables, the hit data of the camera ray of each pixel written alongside its color
+	 *   depth: The distance along the camera ray to the hit, infinite where the ray misses
+	 *   normal: The surface normal at the hit
+	 *   albedo: The diffuse color of the material hit
+	 *   objectID: The index of the object hit in the scene
+	 *   faceID: The index of the mesh face hit
+	 * Every buffer holds floats so they can be written to the same float image formats. The IDs are -1 where there is nothing to identify.
+	 * Only the enabled buffers are allocated and written.
+	 */
+	class rtAOVBuffers
+	{
+	private:
+		static const int numTypes = 5;
+		bool enabled[numTypes] = {};
+		ofFloatPixels buffers[numTypes];
+
+	public:
+		void enable(aovType type, bool enable = true);
+		bool isEnabled(aovType type) const;
+		bool anyEnabled() const;
+		//Allocate the enabled buffers at the given dimensions and free the others
+		void allocate(int width, int height);
+		const ofFloatPixels& getBuffer(aovType type) const;
+
+		//Write the hit of the camera ray of a pixel to the enabled buffers
+		void setPixel(int pixelIndex, const rtRayHit& hit, int objectID);
+		//Copy every enabled buffer from one pixel to another
+		void copyPixel(int sourceIndex, int targetIndex);
+
+		//The number of channels of the type's buffer
+		static int getChannels(aovType type);
+		//The name of the type as written in file names and on the command line
+		static string getName(aovType type);
+		//Find the type with the given name. Returns false if there is none.
+		static bool findType(string name, aovType& type);
+		//The file an output is written to next to the given image, as an OpenEXR file named after the output
+		static string getPath(string imagePath, aovType type);
+	};
+
+	///In-line method definitions
+	inline void rtAOVBuffers::enable(aovType type, bool enable) { enabled[(int)type] = enable; }
+	inline bool rtAOVBuffers::isEnabled(aovType type) const { return enabled[(int)type]; }
+	inline const ofFloatPixels& rtAOVBuffers::getBuffer(aovType type) const { return buffers[(int)type]; }
+
+	inline bool rtAOVBuffers::anyEnabled() const
+	{
+		for (int type = 0; type < numTypes; type++)
+			if (enabled[type])
+				return true;
+
+		return false;
+	}
+
+	inline void rtAOVBuffers::allocate(int width, int height)
+	{
+		for (int type = 0; type < numTypes; type++)
+		{
+			if (enabled[type])
+				buffers[type].allocate(width, height, (getChannels((aovType)type) == 1) ? OF_PIXELS_GRAY : OF_PIXELS_RGB);
+			else
+				buffers[type].clear();
+		}
+	}
+
+	inline void rtAOVBuffers::setPixel(int pixelIndex, const rtRayHit& hit, int objectID)
+	{
+		if (enabled[(int)aovType::depth])
+			buffers[(int)aovType::depth][pixelIndex] = hit.hit ? hit.distance : INFINITY;
+
+		if (enabled[(int)aovType::normal])
+		{
+			rtVec3f normal = hit.hit ? hit.hitNormal : rtVec3f::zero;
+			float* target = buffers[(int)aovType::normal].getData() + pixelIndex * 3;
+			target[0] = normal.getX();
+			target[1] = normal.getY();
+			target[2] = normal.getZ();
+		}
+
+		if (enabled[(int)aovType::albedo])
+		{
+			rtColorf albedo = hit.hit ? hit.hitObject->getMat().getDiffuse() : rtColorf::black;
+			float* target = buffers[(int)aovType::albedo].getData() + pixelIndex * 3;
+			target[0] = albedo.getR();
+			target[1] = albedo.getG();
+			target[2] = albedo.getB();
+		}
+
+		if (enabled[(int)aovType::objectID])
+			buffers[(int)aovType::objectID][pixelIndex] = hit.hit ? (float)objectID : -1.0f;
+
+		if (enabled[(int)aovType::faceID])
+			buffers[(int)aovType::faceID][pixelIndex] = hit.hit ? (float)hit.hitFaceIndex : -1.0f;
+	}
+
+	inline void rtAOVBuffers::copyPixel(int sourceIndex, int targetIndex)
+	{
+		for (int type = 0; type < numTypes; type++)
+		{
+			if (!enabled[type])
+				continue;
+
+			int channels = getChannels((aovType)type);
+
+			for (int channel = 0; channel < channels; channel++)
+				buffers[type][targetIndex * channels + channel] = buffers[type][sourceIndex * channels + channel];
+		}
+	}
+
+	inline int rtAOVBuffers::getChannels(aovType type)
+	{
+		return (type == aovType::normal || type == aovType::albedo) ? 3 : 1;
+	}
+
+	inline string rtAOVBuffers::getName(aovType type)
+	{
+		switch (type)
+		{
+		case aovType::depth: return "depth";
+		case aovType::normal: return "normal";
+		case aovType::albedo: return "albedo";
+		case aovType::objectID: return "object";
+		default: return "face";
+		}
+	}
+
+	inline bool rtAOVBuffers::findType(string name, aovType& type)
+	{
+		for (int typeIndex = 0; typeIndex < numTypes; typeIndex++)
+		{
+			if (getName((aovType)typeIndex) == name)
+			{
+				type = (aovType)typeIndex;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	inline string rtAOVBuffers::getPath(string imagePath, aovType type)
+	{
+		size_t lastDot = imagePath.find_last_of('.');
+		size_t lastSeparator = imagePath.find_last_of("/\\");
+
+		//A dot before the last separator belongs to a folder name
+		if (lastDot != string::npos && (lastSeparator == string::npos || lastDot > lastSeparator))
+			imagePath = imagePath.substr(0, lastDot);
+
+		return imagePath + "." + getName(type) + ".exr";
+	}
+}
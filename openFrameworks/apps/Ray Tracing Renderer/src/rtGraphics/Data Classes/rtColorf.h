@@ -2,7 +2,10 @@
 
 namespace rtGraphics
 {
-	//Represents an RGBA color using integers in the range 0-1
+	/*
+	 * Represents an RGBA color using floats. A value of 1 is the brightest a display shows, but the color channels can go above it,
+	 * so the light reaching a point adds up to high dynamic range radiance that is only clamped when it is tone mapped. The alpha is kept between 0 and 1.
+	 */
 	class rtColorf
 	{
 	private:
@@ -16,9 +19,11 @@ namespace rtGraphics
 		rtColorf(float r, float g, float b, float a = maxValue);
 
 		///Color Methods
-		//Returns the given value clamped between 0 and the maximum
+		//Returns the given value clamped to 0 and above
 		static float clampColor(float value);
-		//Clamp the r, g, b, and a values between 0 and the maximum
+		//Returns the given value clamped between 0 and the maximum
+		static float clampAlpha(float value);
+		//Clamp the r, g and b values to 0 and above, and the a value between 0 and the maximum
 		void clampColors();
 
 		///Getters
@@ -73,21 +78,26 @@ namespace rtGraphics
 	//Color Methods
 	inline float rtColorf::clampColor(float value)
 	{
-		if (value > maxValue)
-			return maxValue;
-
 		if (value < 0.0f)
 			return 0.0f;
 
 		return value;
 	}
 
+	inline float rtColorf::clampAlpha(float value)
+	{
+		if (value > maxValue)
+			return maxValue;
+
+		return clampColor(value);
+	}
+
 	inline void rtColorf::clampColors()
 	{
 		r = clampColor(r);
 		g = clampColor(g);
 		b = clampColor(b);
-		a = clampColor(a);
+		a = clampAlpha(a);
 	}
 
 	//Getters
@@ -100,7 +110,7 @@ namespace rtGraphics
 	inline void rtColorf::setR(float r) { this->r = clampColor(r); }
 	inline void rtColorf::setG(float g) { this->g = clampColor(g); }
 	inline void rtColorf::setB(float b) { this->b = clampColor(b); }
-	inline void rtColorf::setA(float a) { this->a = clampColor(a); }
+	inline void rtColorf::setA(float a) { this->a = clampAlpha(a); }
 
 	inline void rtColorf::setColor(float r, float g, float b, float a)
 	{
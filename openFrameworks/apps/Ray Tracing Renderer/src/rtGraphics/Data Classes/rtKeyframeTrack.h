@@ -0,0 +1,97 @@
+#pragma once
+
+#include <map>
+#include <iterator>
+#include "Data Types.h"
+
+using namespace std;
+
+namespace rtGraphics
+{
+	/*
+	 * A value that changes over the frames of an animation, given by its value at key frames
+	 * Frames between keys are interpolated, and frames before the first key or after the last one hold the value of that key.
+	 * The value type needs addition, subtraction and multiplication by a float, like float and rtVec3f.
+	 */
+	template <typename T>
+	class rtKeyframeTrack
+	{
+	private:
+		//The value of each key by frame
+		map<float, T> keys;
+		interpolation Interpolation;
+
+	public:
+		///Constructors
+		rtKeyframeTrack(interpolation Interpolation = interpolation::smooth) : Interpolation(Interpolation) {}
+
+		//Set the value at the given frame, replacing any key already there
+		void addKey(float frame, const T& value);
+		bool isEmpty() const;
+		void setInterpolation(interpolation Interpolation);
+		//The value at the given frame. The track must have at least one key.
+		T valueAt(float frame) const;
+	};
+
+	///In-line method definitions
+	template <typename T>
+	inline void rtKeyframeTrack<T>::addKey(float frame, const T& value)
+	{
+		keys[frame] = value;
+	}
+
+	template <typename T>
+	inline bool rtKeyframeTrack<T>::isEmpty() const
+	{
+		return keys.empty();
+	}
+
+	template <typename T>
+	inline void rtKeyframeTrack<T>::setInterpolation(interpolation Interpolation)
+	{
+		this->Interpolation = Interpolation;
+	}
+
+	template <typename T>
+	T rtKeyframeTrack<T>::valueAt(float frame) const
+	{
+		//The first key after the frame
+		auto nextKey = keys.upper_bound(frame);
+
+		if (nextKey == keys.begin())
+			return nextKey->second;
+
+		if (nextKey == keys.end())
+			return prev(nextKey)->second;
+
+		auto key = prev(nextKey);
+		float t1 = key->first, t2 = nextKey->first;
+		const T& p1 = key->second;
+		const T& p2 = nextKey->second;
+		//How far the frame is between the two keys
+		float s = (frame - t1) / (t2 - t1);
+
+		if (Interpolation == interpolation::linear)
+			return p1 * (1.0f - s) + p2 * s;
+
+		//The keys on either side of the pair. The first and last keys stand in for the missing ones at the ends of the track.
+		auto before = (key == keys.begin()) ? key : prev(key);
+		auto after = (nextKey == prev(keys.end())) ? nextKey : next(nextKey);
+		float t0 = before->first, t3 = after->first;
+		const T& p0 = before->second;
+		const T& p3 = after->second;
+
+		//Catmull-Rom tangents scaled for the uneven spacing of the keys, so the curve passes through each key without a kink
+		T m1 = (p2 - p0) * ((t2 - t1) / (t2 - t0));
+		T m2 = (p3 - p1) * ((t2 - t1) / (t3 - t1));
+
+		//The cubic Hermite basis functions
+		float s2 = s * s, s3 = s2 * s;
+		float h00 = 2.0f * s3 - 3.0f * s2 + 1.0f;
+		float h10 = s3 - 2.0f * s2 + s;
+		float h01 = -2.0f * s3 + 3.0f * s2;
+		float h11 = s3 - s2;
+
+		return p1 * h00 + m1 * h10 + p2 * h01 + m2 * h11;
+	}
+}
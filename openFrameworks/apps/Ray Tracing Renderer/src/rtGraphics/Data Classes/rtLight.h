@@ -93,19 +93,20 @@ namespace rtGraphics
 	inline bool rtLight::attenuateEnabled() const		{ return attenuate; }
 
 	//Setters
-	inline void rtLight::setPosition(const rtVec3f& position)	{ this->position = position; }
-	inline void rtLight::setAmbient(const rtColorf& ambient)	{ this->ambient = ambient; }
-	inline void rtLight::setDiffuse(const rtColorf& diffuse)	{ this->diffuse = diffuse; }
-	inline void rtLight::setSpecular(const rtColorf& specular)	{ this->specular = specular; }
+	inline void rtLight::setPosition(const rtVec3f& position)	{ this->position = position; markChanged(); }
+	inline void rtLight::setAmbient(const rtColorf& ambient)	{ this->ambient = ambient; markChanged(); }
+	inline void rtLight::setDiffuse(const rtColorf& diffuse)	{ this->diffuse = diffuse; markChanged(); }
+	inline void rtLight::setSpecular(const rtColorf& specular)	{ this->specular = specular; markChanged(); }
 
 	inline void rtLight::setColors(const rtColorf& ambient, const rtColorf& diffuse, const rtColorf& specular)
 	{
 		this->ambient = ambient;
 		this->diffuse = diffuse;
 		this->specular = specular;
+		markChanged();
 	}
 
-	inline void rtLight::setIncidentIntensity(float incidentIntensity)	{ this->incidentIntensity = incidentIntensity; }
-	inline void rtLight::setAmbientIntensity(float ambientIntensity)	{ this->ambientIntensity = ambientIntensity; }
-	inline void rtLight::setAttenuate(bool attenuate)					{ this->attenuate = attenuate; }
+	inline void rtLight::setIncidentIntensity(float incidentIntensity)	{ this->incidentIntensity = incidentIntensity; markChanged(); }
+	inline void rtLight::setAmbientIntensity(float ambientIntensity)	{ this->ambientIntensity = ambientIntensity; markChanged(); }
+	inline void rtLight::setAttenuate(bool attenuate)					{ this->attenuate = attenuate; markChanged(); }
 }
\ No newline at end of file
@@ -16,6 +16,8 @@ namespace rtGraphics
 		float smoothness;
 		//Controls how much light bounces off of the object. Between 0 and 1.
 		float reflectivity;
+		//The number of changes made to the material, so a camera can tell when it changed
+		unsigned long version = 0;
 
 	public:
 		///Constructors
@@ -28,6 +30,8 @@ namespace rtGraphics
 		rtColorf& getSpecular();
 		float getSmoothness();
 		float getReflectivity();
+		//The number of changes recorded. Only compare it to earlier versions of the same material.
+		unsigned long getVersion() const;
 
 		///Setters
 		void setAmbient(const rtColorf& ambient);
@@ -36,6 +40,8 @@ namespace rtGraphics
 		void setColors(const rtColorf& ambient, const rtColorf& diffuse, const rtColorf& specular);
 		void setSmoothness(float smoothness);
 		void setReflectivity(float smoothness);
+		//Record a change. The setters call this themselves, so it is only needed after changing a color through a reference returned by a getter.
+		void markChanged();
 	};
 
 	///Constructors
@@ -62,18 +68,21 @@ namespace rtGraphics
 	inline rtColorf& rtMat::getSpecular()	{ return specular; }
 	inline float rtMat::getSmoothness()		{ return smoothness; }
 	inline float rtMat::getReflectivity()	{ return reflectivity; }
+	inline unsigned long rtMat::getVersion() const { return version; }
 
 	//Setters
-	inline void rtMat::setAmbient(const rtColorf& ambient)		{ this->ambient = ambient; }
-	inline void rtMat::setDiffuse(const rtColorf& diffuse)		{ this->diffuse = diffuse; }
-	inline void rtMat::setSpecular(const rtColorf& specular)	{ this->specular = specular; }
-	inline void rtMat::setSmoothness(float smoothness)			{ this->smoothness = smoothness; }
-	inline void rtMat::setReflectivity(float reflectivity)		{ this->reflectivity = reflectivity; }
+	inline void rtMat::setAmbient(const rtColorf& ambient)		{ this->ambient = ambient; markChanged(); }
+	inline void rtMat::setDiffuse(const rtColorf& diffuse)		{ this->diffuse = diffuse; markChanged(); }
+	inline void rtMat::setSpecular(const rtColorf& specular)	{ this->specular = specular; markChanged(); }
+	inline void rtMat::setSmoothness(float smoothness)			{ this->smoothness = smoothness; markChanged(); }
+	inline void rtMat::setReflectivity(float reflectivity)		{ this->reflectivity = reflectivity; markChanged(); }
+	inline void rtMat::markChanged()							{ version++; }
 
 	inline void rtMat::setColors(const rtColorf& ambient, const  rtColorf& diffuse, const rtColorf& specular)
 	{
 		this->ambient = ambient;
 		this->diffuse = diffuse;
 		this->specular = specular;
+		markChanged();
 	}
 }
\ No newline at end of file
@@ -12,11 +12,11 @@ namespace rtGraphics
 	struct rtRayHit
 	{
 		bool hit = false;
-		rtObject* hitObject;
+		rtObject* hitObject = nullptr;
 		float distance;
 		rtVec3f hitPoint;
 		rtVec3f hitNormal;
 		//Only relevant for mesh objects
-		int hitFaceIndex;
+		int hitFaceIndex = -1;
 	};
 }
\ No newline at end of file
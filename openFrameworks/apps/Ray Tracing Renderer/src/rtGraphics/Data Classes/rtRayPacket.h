@@ -0,0 +1,117 @@
+#pragma once
+
+#include <math.h>
+#include <immintrin.h>
+#include "rtVec3f.h"
+#include "rtAABB.h"
+
+namespace rtGraphics
+{
+	//The number of rays in the largest packet, a block of 8x8 pixels
+	static const int maxPacketSize = 64;
+
+	/*
+	 * A packet of rays sharing an origin, such as the camera rays of a block of pixels
+	 * The rays are split into groups of 4 so each SIMD lane traces one ray. Each group has a bit mask of the rays that are still traced.
+	 * The packet is only traced together when every ray points the same way along each axis, so one slab order works for every lane.
+	 */
+	struct rtRayPacket
+	{
+		static const int maxGroups = maxPacketSize / 4;
+
+		rtVec3f origin;
+		rtVec3f directions[maxPacketSize];
+		//The inverse directions stored as structure of arrays, indexed as [axis][ray]
+		float invDir[3][maxPacketSize];
+		//The rays being traced, as a bit mask per group of 4 rays
+		int activeMasks[maxGroups];
+		int size = 0;
+		int numGroups = 0;
+		//1 if every ray points in the negative direction along the axis
+		int sign[3];
+		//False if the direction signs differ between rays, in which case the rays are traced one at a time
+		bool coherent = false;
+
+		//Set the number of rays. Every ray starts inactive.
+		void setSize(int size);
+		void setRay(int ray, const rtVec3f& direction);
+		//Prepare the inverse directions and check the coherence after the rays are set
+		void update();
+
+		bool isActive(const int* masks, int ray) const;
+		//Slab test between a group of rays and a box. Returns a bit mask of the rays in the given mask that hit within [tMin, tMax].
+		int intersectBox(const rtAABB& box, int group, int mask, float tMin, const float* tMax) const;
+	};
+
+	///In-line method definitions
+	inline void rtRayPacket::setSize(int size)
+	{
+		this->size = size;
+		numGroups = (size + 3) / 4;
+
+		for (int group = 0; group < numGroups; group++)
+			activeMasks[group] = 0;
+	}
+
+	inline void rtRayPacket::setRay(int ray, const rtVec3f& direction)
+	{
+		directions[ray] = direction;
+		activeMasks[ray / 4] |= 1 << (ray % 4);
+	}
+
+	inline void rtRayPacket::update()
+	{
+		int firstRay = -1;
+		coherent = true;
+
+		for (int ray = 0; ray < numGroups * 4; ray++)
+		{
+			//Inactive lanes copy the first active ray so they don't produce NaNs, and are masked out of every result
+			if (!isActive(activeMasks, ray))
+			{
+				for (int axis = 0; axis < 3; axis++)
+					invDir[axis][ray] = (firstRay == -1) ? INFINITY : invDir[axis][firstRay];
+
+				continue;
+			}
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				invDir[axis][ray] = 1.0f / directions[ray].getAxis(axis);
+				int raySign = signbit(invDir[axis][ray]) ? 1 : 0;
+
+				if (firstRay == -1)
+					sign[axis] = raySign;
+				else if (raySign != sign[axis])
+					coherent = false;
+			}
+
+			if (firstRay == -1)
+				firstRay = ray;
+		}
+	}
+
+	inline bool rtRayPacket::isActive(const int* masks, int ray) const
+	{
+		return (masks[ray / 4] & (1 << (ray % 4))) != 0;
+	}
+
+	//A NaN from an origin lying on a slab is discarded, since max and min return their second operand when either is NaN
+	inline int rtRayPacket::intersectBox(const rtAABB& box, int group, int mask, float tMin, const float* tMax) const
+	{
+		__m128 enter = _mm_set1_ps(tMin);
+		__m128 exit = _mm_loadu_ps(tMax + group * 4);
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float nearPlane = sign[axis] ? box.getMax().getAxis(axis) : box.getMin().getAxis(axis);
+			float farPlane = sign[axis] ? box.getMin().getAxis(axis) : box.getMax().getAxis(axis);
+			__m128 invDirGroup = _mm_loadu_ps(&invDir[axis][group * 4]);
+
+			enter = _mm_max_ps(_mm_mul_ps(_mm_set1_ps(nearPlane - origin.getAxis(axis)), invDirGroup), enter);
+			exit = _mm_min_ps(_mm_mul_ps(_mm_set1_ps(farPlane - origin.getAxis(axis)), invDirGroup), exit);
+		}
+
+		return _mm_movemask_ps(_mm_cmple_ps(enter, exit)) & mask;
+	}
+}
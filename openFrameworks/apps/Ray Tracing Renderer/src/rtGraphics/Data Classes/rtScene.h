@@ -19,6 +19,8 @@ namespace rtGraphics
 		//The addresses of the lights and objects are stored in an unordered hash-set
 		lightSet lights;
 		objectSet objects;
+		//The number of times lights or objects were added or removed, so a camera can tell when the contents of the scene changed
+		unsigned long version = 0;
 
 	public:
 		///Constructor
@@ -35,6 +37,12 @@ namespace rtGraphics
 		rtObject* getObject(int objectIndex);
 		void removeObject(int objectIndex);
 		void clearObjects();
+		/*
+		 * The number of times lights or objects were added or removed. Changes to the lights and objects themselves are counted by their own versions.
+		 * Lights and objects added through the sets returned by the getters must be followed by a call to markChanged.
+		 */
+		unsigned long getVersion() const;
+		void markChanged();
 	};
 
 	///Constructor
@@ -51,11 +59,12 @@ namespace rtGraphics
 	inline void rtScene::addLight(rtLight* lightToAdd)
 	{
 		lights->push_back(lightToAdd);
+		markChanged();
 	}
 
 	inline rtLight* rtScene::getLight(int lightIndex)		{ return lights->operator[](lightIndex); }
-	inline void rtScene::removeLight(int lightIndex)		{ lights->erase(lights->begin() + lightIndex); }
-	inline void rtScene::clearLights()						{ lights->clear(); }
+	inline void rtScene::removeLight(int lightIndex)		{ lights->erase(lights->begin() + lightIndex); markChanged(); }
+	inline void rtScene::clearLights()						{ lights->clear(); markChanged(); }
 
 	//Object Methods
 	inline objectSet rtScene::getObjects() const			{ return objects; }
@@ -63,9 +72,14 @@ namespace rtGraphics
 	inline void rtScene::addObject(rtObject* objectToAdd)
 	{
 		objects->push_back(objectToAdd);
+		markChanged();
 	}
 
 	inline rtObject* rtScene::getObject(int objectIndex)	{ return objects->operator[](objectIndex); }
-	inline void rtScene::removeObject(int objectIndex)		{ objects->erase(objects->begin() + objectIndex); }
-	inline void rtScene::clearObjects()						{ objects->clear(); }
+	inline void rtScene::removeObject(int objectIndex)		{ objects->erase(objects->begin() + objectIndex); markChanged(); }
+	inline void rtScene::clearObjects()						{ objects->clear(); markChanged(); }
+
+	//Change tracking
+	inline unsigned long rtScene::getVersion() const		{ return version; }
+	inline void rtScene::markChanged()						{ version++; }
 }
\ No newline at end of file
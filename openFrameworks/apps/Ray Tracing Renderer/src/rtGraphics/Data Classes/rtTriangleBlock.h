@@ -0,0 +1,161 @@
+#pragma once
+
+#include <immintrin.h>
+#include "rtVec3f.h"
+
+namespace rtGraphics
+{
+	//The number of triangles tested at once. Each leaf of a mesh hierarchy is packed into blocks of this size.
+#ifdef __AVX__
+	static const int triangleBlockWidth = 8;
+#else
+	static const int triangleBlockWidth = 4;
+#endif
+
+	/*
+	 * A block of triangles precomputed for the Moller-Trumbore test, stored as structure of arrays
+	 * Each triangle is stored as its first vertex and two edges, indexed as [axis][triangle].
+	 * Each array is 16 or 32 bytes, so a block is read with one load per array. Vectors of blocks are only guaranteed to respect
+	 * the 16 byte alignment on 64-bit platforms, so the loads are unaligned, which costs nothing when the data is aligned.
+	 */
+	template<int width>
+	struct alignas(16) rtTriangleBlock
+	{
+		float vert0[3][width];
+		float edge1[3][width];
+		float edge2[3][width];
+		//The face each triangle came from, or -1 for unused slots
+		int faceIndex[width];
+
+		void setTriangle(int slot, const rtVec3f& p0, const rtVec3f& p1, const rtVec3f& p2, int faceIndex);
+		void setEmpty(int slot);
+	};
+
+	///In-line method definitions
+	template<int width>
+	inline void rtTriangleBlock<width>::setTriangle(int slot, const rtVec3f& p0, const rtVec3f& p1, const rtVec3f& p2, int faceIndex)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			vert0[axis][slot] = p0.getAxis(axis);
+			edge1[axis][slot] = p1.getAxis(axis) - p0.getAxis(axis);
+			edge2[axis][slot] = p2.getAxis(axis) - p0.getAxis(axis);
+		}
+
+		this->faceIndex[slot] = faceIndex;
+	}
+
+	//Unused slots hold a degenerate triangle. Its determinant is 0, so the test produces NaN and never reports a hit.
+	template<int width>
+	inline void rtTriangleBlock<width>::setEmpty(int slot)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			vert0[axis][slot] = 0.0f;
+			edge1[axis][slot] = 0.0f;
+			edge2[axis][slot] = 0.0f;
+		}
+
+		faceIndex[slot] = -1;
+	}
+
+	/*
+	 * Moller-Trumbore test between a ray and every triangle of a block
+	 * Both sides of the triangles are hit. Returns a bit mask of the triangles hit within (tMin, tMax) and stores the distance to each.
+	 */
+	inline int intersectTriangles(const rtTriangleBlock<4>& block, const rtVec3f& P, const rtVec3f& D, float tMin, float tMax, float* t)
+	{
+		__m128 dirX = _mm_set1_ps(D.getX());
+		__m128 dirY = _mm_set1_ps(D.getY());
+		__m128 dirZ = _mm_set1_ps(D.getZ());
+
+		__m128 e1X = _mm_loadu_ps(block.edge1[0]);
+		__m128 e1Y = _mm_loadu_ps(block.edge1[1]);
+		__m128 e1Z = _mm_loadu_ps(block.edge1[2]);
+		__m128 e2X = _mm_loadu_ps(block.edge2[0]);
+		__m128 e2Y = _mm_loadu_ps(block.edge2[1]);
+		__m128 e2Z = _mm_loadu_ps(block.edge2[2]);
+
+		//pVec = D x edge2
+		__m128 pX = _mm_sub_ps(_mm_mul_ps(dirY, e2Z), _mm_mul_ps(dirZ, e2Y));
+		__m128 pY = _mm_sub_ps(_mm_mul_ps(dirZ, e2X), _mm_mul_ps(dirX, e2Z));
+		__m128 pZ = _mm_sub_ps(_mm_mul_ps(dirX, e2Y), _mm_mul_ps(dirY, e2X));
+
+		//A determinant of 0 means the ray is parallel to the triangle
+		__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1X, pX), _mm_mul_ps(e1Y, pY)), _mm_mul_ps(e1Z, pZ));
+		__m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+		//tVec = P - vert0
+		__m128 tX = _mm_sub_ps(_mm_set1_ps(P.getX()), _mm_loadu_ps(block.vert0[0]));
+		__m128 tY = _mm_sub_ps(_mm_set1_ps(P.getY()), _mm_loadu_ps(block.vert0[1]));
+		__m128 tZ = _mm_sub_ps(_mm_set1_ps(P.getZ()), _mm_loadu_ps(block.vert0[2]));
+
+		//The first barycentric coordinate
+		__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tX, pX), _mm_mul_ps(tY, pY)), _mm_mul_ps(tZ, pZ)), invDet);
+
+		//qVec = tVec x edge1
+		__m128 qX = _mm_sub_ps(_mm_mul_ps(tY, e1Z), _mm_mul_ps(tZ, e1Y));
+		__m128 qY = _mm_sub_ps(_mm_mul_ps(tZ, e1X), _mm_mul_ps(tX, e1Z));
+		__m128 qZ = _mm_sub_ps(_mm_mul_ps(tX, e1Y), _mm_mul_ps(tY, e1X));
+
+		//The second barycentric coordinate and the distance along the ray
+		__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dirX, qX), _mm_mul_ps(dirY, qY)), _mm_mul_ps(dirZ, qZ)), invDet);
+		__m128 dist = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2X, qX), _mm_mul_ps(e2Y, qY)), _mm_mul_ps(e2Z, qZ)), invDet);
+
+		//Ordered comparisons are false for NaN, so parallel and degenerate triangles are rejected
+		__m128 hit = _mm_and_ps(_mm_cmpge_ps(u, _mm_setzero_ps()), _mm_cmpge_ps(v, _mm_setzero_ps()));
+		hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+		hit = _mm_and_ps(hit, _mm_cmpgt_ps(dist, _mm_set1_ps(tMin)));
+		hit = _mm_and_ps(hit, _mm_cmplt_ps(dist, _mm_set1_ps(tMax)));
+
+		_mm_storeu_ps(t, dist);
+		return _mm_movemask_ps(hit);
+	}
+
+#ifdef __AVX__
+	inline int intersectTriangles(const rtTriangleBlock<8>& block, const rtVec3f& P, const rtVec3f& D, float tMin, float tMax, float* t)
+	{
+		__m256 dirX = _mm256_set1_ps(D.getX());
+		__m256 dirY = _mm256_set1_ps(D.getY());
+		__m256 dirZ = _mm256_set1_ps(D.getZ());
+
+		__m256 e1X = _mm256_loadu_ps(block.edge1[0]);
+		__m256 e1Y = _mm256_loadu_ps(block.edge1[1]);
+		__m256 e1Z = _mm256_loadu_ps(block.edge1[2]);
+		__m256 e2X = _mm256_loadu_ps(block.edge2[0]);
+		__m256 e2Y = _mm256_loadu_ps(block.edge2[1]);
+		__m256 e2Z = _mm256_loadu_ps(block.edge2[2]);
+
+		//pVec = D x edge2
+		__m256 pX = _mm256_sub_ps(_mm256_mul_ps(dirY, e2Z), _mm256_mul_ps(dirZ, e2Y));
+		__m256 pY = _mm256_sub_ps(_mm256_mul_ps(dirZ, e2X), _mm256_mul_ps(dirX, e2Z));
+		__m256 pZ = _mm256_sub_ps(_mm256_mul_ps(dirX, e2Y), _mm256_mul_ps(dirY, e2X));
+
+		__m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1X, pX), _mm256_mul_ps(e1Y, pY)), _mm256_mul_ps(e1Z, pZ));
+		__m256 invDet = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+
+		//tVec = P - vert0
+		__m256 tX = _mm256_sub_ps(_mm256_set1_ps(P.getX()), _mm256_loadu_ps(block.vert0[0]));
+		__m256 tY = _mm256_sub_ps(_mm256_set1_ps(P.getY()), _mm256_loadu_ps(block.vert0[1]));
+		__m256 tZ = _mm256_sub_ps(_mm256_set1_ps(P.getZ()), _mm256_loadu_ps(block.vert0[2]));
+
+		__m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(tX, pX), _mm256_mul_ps(tY, pY)), _mm256_mul_ps(tZ, pZ)), invDet);
+
+		//qVec = tVec x edge1
+		__m256 qX = _mm256_sub_ps(_mm256_mul_ps(tY, e1Z), _mm256_mul_ps(tZ, e1Y));
+		__m256 qY = _mm256_sub_ps(_mm256_mul_ps(tZ, e1X), _mm256_mul_ps(tX, e1Z));
+		__m256 qZ = _mm256_sub_ps(_mm256_mul_ps(tX, e1Y), _mm256_mul_ps(tY, e1X));
+
+		__m256 v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dirX, qX), _mm256_mul_ps(dirY, qY)), _mm256_mul_ps(dirZ, qZ)), invDet);
+		__m256 dist = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2X, qX), _mm256_mul_ps(e2Y, qY)), _mm256_mul_ps(e2Z, qZ)), invDet);
+
+		__m256 hit = _mm256_and_ps(_mm256_cmp_ps(u, _mm256_setzero_ps(), _CMP_GE_OQ), _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GE_OQ));
+		hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_add_ps(u, v), _mm256_set1_ps(1.0f), _CMP_LE_OQ));
+		hit = _mm256_and_ps(hit, _mm256_cmp_ps(dist, _mm256_set1_ps(tMin), _CMP_GT_OQ));
+		hit = _mm256_and_ps(hit, _mm256_cmp_ps(dist, _mm256_set1_ps(tMax), _CMP_LT_OQ));
+
+		_mm256_storeu_ps(t, dist);
+		return _mm256_movemask_ps(hit);
+	}
+#endif
+}
@@ -29,6 +29,8 @@ namespace rtGraphics
 		float getX() const;
 		float getY() const;
 		float getZ() const;
+		//Returns the x, y, or z component for an axis index of 0, 1, or 2
+		float getAxis(int axis) const;
 
 		///Vector Methods
 		float magnitude() const;
@@ -40,6 +42,9 @@ namespace rtGraphics
 		rtVec3f& reflect(const rtVec3f& rhs);
 		rtVec3f getReflected(const rtVec3f& rhs) const;
 		float dot(const rtVec3f& rhs) const;
+		//Component-wise minimum and maximum
+		rtVec3f getMin(const rtVec3f& rhs) const;
+		rtVec3f getMax(const rtVec3f& rhs) const;
 
 		///Operators
 		//Copy assignment
@@ -125,6 +130,16 @@ namespace rtGraphics
 		return z;
 	}
 
+	inline float rtVec3f::getAxis(int axis) const
+	{
+		if (axis == 0)
+			return x;
+		if (axis == 1)
+			return y;
+
+		return z;
+	}
+
 	//Vector Methods
 	inline float rtVec3f::magnitude() const
 	{
@@ -203,6 +218,16 @@ namespace rtGraphics
 		return (x * rhs.x) + (y * rhs.y) + (z * rhs.z);
 	}
 
+	inline rtVec3f rtVec3f::getMin(const rtVec3f& rhs) const
+	{
+		return rtVec3f((x < rhs.x) ? x : rhs.x, (y < rhs.y) ? y : rhs.y, (z < rhs.z) ? z : rhs.z);
+	}
+
+	inline rtVec3f rtVec3f::getMax(const rtVec3f& rhs) const
+	{
+		return rtVec3f((x > rhs.x) ? x : rhs.x, (y > rhs.y) ? y : rhs.y, (z > rhs.z) ? z : rhs.z);
+	}
+
 	//Operators
 	//Copy Assignment
 	inline rtVec3f& rtVec3f::operator=(const rtVec3f& rhs)
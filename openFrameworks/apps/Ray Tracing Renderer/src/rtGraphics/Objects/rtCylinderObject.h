@@ -66,6 +66,6 @@ namespace rtGraphics
 	inline float rtCylinderObject::getRadius() const { return radius; }
 
 	//Setters
-	inline void rtCylinderObject::setPosition(const rtVec3f& position) { this->position = position; }
-	inline void rtCylinderObject::setRadius(float radius) { this->radius = radius; }
+	inline void rtCylinderObject::setPosition(const rtVec3f& position) { this->position = position; markChanged(); }
+	inline void rtCylinderObject::setRadius(float radius) { this->radius = radius; markChanged(); }
 }
\ No newline at end of file
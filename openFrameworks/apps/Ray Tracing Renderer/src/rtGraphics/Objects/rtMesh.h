@@ -24,7 +24,6 @@ namespace rtGraphics
 		///Normal Methods
 		rtVec3f calculateNormal(rtVec3f vert0, rtVec3f vert1, rtVec3f vert2);
 		rtVec3f calculateNormal(int faceIndex);
-		void updateNormals();
 
 	public:
 		///Constructors
@@ -33,6 +32,8 @@ namespace rtGraphics
 
 		///Vertex Methods
 		void addVert(const rtVec3f& vertex);
+		//Move an existing vertex. The normals are not recalculated until updateNormals() is called.
+		void setVert(int index, const rtVec3f& vertex);
 		vecList getVerts();
 		void clearVerts();
 
@@ -42,6 +43,8 @@ namespace rtGraphics
 		void clearFaces();
 
 		///Normal Methods
+		//Recalculate the normal of every face, such as after the vertices are moved
+		void updateNormals();
 		vecList getNormals();
 	};
 
@@ -132,6 +135,11 @@ namespace rtGraphics
 		vertices->push_back(vertex);
 	}
 
+	inline void rtMesh::setVert(int index, const rtVec3f& vertex)
+	{
+		vertices->at(index) = vertex;
+	}
+
 	inline vecList rtMesh::getVerts()
 	{
 		return vertices;
@@ -2,6 +2,169 @@
 
 namespace rtGraphics
 {
+	//Calculate the bounds of each face
+	void rtMeshObject::updateFaceBounds()
+	{
+		faceBounds.resize(faces->size());
+
+		for (int faceIndex = 0; faceIndex < faces->size(); faceIndex++)
+		{
+			array<int, 3>& face = faces->operator[](faceIndex);
+
+			faceBounds[faceIndex] = rtAABB();
+			faceBounds[faceIndex].expand(vertices->operator[](face[0]));
+			faceBounds[faceIndex].expand(vertices->operator[](face[1]));
+			faceBounds[faceIndex].expand(vertices->operator[](face[2]));
+		}
+	}
+
+	//Build the bounding volume hierarchy from the bounds of each face
+	void rtMeshObject::buildBVH()
+	{
+		updateFaceBounds();
+		//Size the leaves for the blocks of the SIMD intersector
+		bvh.setLeafBlockWidth(triangleBlockWidth);
+		bvh.build(faceBounds);
+		packTriangles();
+	}
+
+	//Copy the faces of each leaf into consecutive triangle blocks, padding the last block of a leaf with empty slots
+	void rtMeshObject::packTriangles()
+	{
+		const int width = triangleBlockWidth;
+
+		triangleBlocks.clear();
+		leafBlocks.assign(faces->size(), -1);
+
+		bvh.forEachLeaf([&](int first, int count) {
+			leafBlocks[first] = triangleBlocks.size();
+
+			for (int blockStart = first; blockStart < first + count; blockStart += width)
+			{
+				rtTriangleBlock<width> block;
+
+				for (int slot = 0; slot < width; slot++)
+				{
+					int position = blockStart + slot;
+
+					if (position < first + count)
+					{
+						int faceIndex = bvh.getPrimIndex(position);
+						array<int, 3>& face = faces->at(faceIndex);
+						block.setTriangle(slot, vertices->at(face[0]), vertices->at(face[1]), vertices->at(face[2]), faceIndex);
+					}
+					else
+						block.setEmpty(slot);
+				}
+
+				triangleBlocks.push_back(block);
+			}
+		});
+	}
+
+	//Refit the hierarchy to the moved vertices, or rebuild it if the tree has degraded
+	bool rtMeshObject::updateMesh()
+	{
+		mesh.updateNormals();
+		updateFaceBounds();
+		bvh.refit(faceBounds);
+
+		bool rebuilt = bvh.isDegraded();
+
+		if (rebuilt)
+			bvh.build(faceBounds);
+
+		//The blocks store copies of the vertices, so they are packed again even if the leaves did not change
+		packTriangles();
+		markChanged();
+		return rebuilt;
+	}
+
+	//Test the triangle blocks of a leaf
+	int rtMeshObject::intersectLeaf(int first, int count, rtVec3f& P, rtVec3f& D, float nearClip, float& tmin, int sourceFace)
+	{
+		const int width = triangleBlockWidth;
+		int closestFace = -1;
+		int firstBlock = leafBlocks[first];
+		int lastBlock = firstBlock + (count + width - 1) / width;
+
+		for (int blockIndex = firstBlock; blockIndex < lastBlock; blockIndex++)
+		{
+			rtTriangleBlock<width>& block = triangleBlocks[blockIndex];
+			float t[width];
+			int hitMask = intersectTriangles(block, P, D, nearClip, tmin, t);
+
+			for (int slot = 0; hitMask != 0; slot++, hitMask >>= 1)
+			{
+				//If the ray origin is on the current face, then it does not intersect
+				if ((hitMask & 1) && t[slot] < tmin && block.faceIndex[slot] != sourceFace)
+				{
+					tmin = t[slot];
+					closestFace = block.faceIndex[slot];
+				}
+			}
+		}
+
+		return closestFace;
+	}
+
+	//Ray-Triangle Intersection distance
+	bool rtMeshObject::intersectFaceDistance(int faceIndex, rtVec3f& P, rtVec3f& D, float nearClip, float tmin, float& t)
+	{
+		//Get the array of vertex indices for the given face
+		array<int, 3>& face = faces->at(faceIndex);
+		//Get the first vertex
+		rtVec3f p0 = vertices->at(face.at(0));
+		//Get the normal using the face index
+		rtVec3f normal = normals->at(faceIndex);
+
+		//Calculate the plane constant
+		float k = p0.dot(normal);
+		//Calculate the distance to the plane intersection point
+		t = (k - P.dot(normal)) / (D.dot(normal));
+
+		//If the ray is not visible, it doesn't hit the triangle
+		if (!(t > nearClip && t < tmin))
+			return false;
+
+		//Calculate the intersection point using t
+		rtVec3f r = P + (D * t);
+
+		//Get the remaining two points
+		rtVec3f p1 = vertices->at(face.at(1));
+		rtVec3f p2 = vertices->at(face.at(2));
+
+		//Find the edge vertices
+		rtVec3f e0 = p1 - p0;
+		rtVec3f e1 = p2 - p1;
+		rtVec3f e2 = p0 - p2;
+
+		//If the hit point is on the inside of each edge vector, it is inside the triangle
+		return ((e0.getCrossed(r - p0)).dot(normal) >= 0 &&
+			(e1.getCrossed(r - p1)).dot(normal) >= 0 &&
+			(e2.getCrossed(r - p2)).dot(normal) >= 0);
+	}
+
+	//Ray-Triangle Intersection
+	void rtMeshObject::intersectFace(int faceIndex, rtVec3f& P, rtVec3f& D, float nearClip, float& tmin, rtRayHit& hitData)
+	{
+		float t;
+
+		if (intersectFaceDistance(faceIndex, P, D, nearClip, tmin, t))
+		{
+			//Update the distance of the closest intersection
+			tmin = t;
+
+			//Store the hit data into the struct
+			hitData.hit = true;
+			hitData.hitObject = this;
+			hitData.distance = tmin;
+			hitData.hitPoint = P + (D * t);
+			hitData.hitNormal = normals->at(faceIndex);
+			hitData.hitFaceIndex = faceIndex;
+		}
+	}
+
 	//Ray-Mesh Intersection
 	rtRayHit rtMeshObject::rayIntersect(rtVec3f P, rtVec3f D, float nearClip, float farClip, rtRayHit originPoint)
 	{
@@ -10,74 +173,132 @@ namespace rtGraphics
 		//By default, set the hit flag to false
 		hitData.hit = false;
 
-		//Determines if the ray origin is on the surface of this mesh
-		bool onSurface = false;
-		//The face that the ray origin is on
-		int sourceFace;
+		//If the ray origin is on the surface of this mesh, the face it starts on is skipped
+		int sourceFace = (originPoint.hitObject == this) ? originPoint.hitFaceIndex : -1;
+
+		//The distance to the closest intersection point
+		float tmin = farClip;
+
+		//The closest face hit
+		int closestFace = -1;
+
+		//Only test the faces in the leaves of the hierarchy that the ray reaches before the closest hit
+		bvh.traverse(P, D, nearClip, tmin, [&](int first, int count, float& tMax) {
+			int leafFace = intersectLeaf(first, count, P, D, nearClip, tMax, sourceFace);
 
-		//If the ray origin is on the surface of this mesh, save the source face index
-		if (originPoint.hitObject == this)
+			if (leafFace != -1)
+				closestFace = leafFace;
+		});
+
+		//Store the hit data of the closest face into the struct
+		if (closestFace != -1)
 		{
-			onSurface = true;
-			sourceFace = originPoint.hitFaceIndex;
+			hitData.hit = true;
+			hitData.hitObject = this;
+			hitData.distance = tmin;
+			hitData.hitPoint = P + (D * tmin);
+			hitData.hitNormal = normals->at(closestFace);
+			hitData.hitFaceIndex = closestFace;
 		}
 
-		//The distance to the closest intersection point
-		float tmin = farClip;
-		//The index of the current triangle
-		int faceIndex;
+		//Return the intersection data
+		return hitData;
+	}
 
-		//Iterate over all the triangles in the mesh
-		for (int faceIndex = 0; faceIndex < faces->size(); faceIndex++)
+	//Ray-Mesh intersection for a packet of camera rays
+	void rtMeshObject::rayIntersectPacket(const rtRayPacket& packet, const int* activeMasks, float nearClip, float* tMax, rtRayHit* hits)
+	{
+		//Rays pointing different ways can't share a traversal order, so trace them one at a time
+		if (!packet.coherent)
 		{
-			//If the ray origin is on the current face, then it does not intersect
-			if (onSurface && sourceFace == faceIndex)
+			rtObject::rayIntersectPacket(packet, activeMasks, nearClip, tMax, hits);
+			return;
+		}
+
+		//The closest face hit by each ray
+		int closestFaces[maxPacketSize];
+		rtVec3f P = packet.origin;
+
+		for (int ray = 0; ray < packet.size; ray++)
+			closestFaces[ray] = -1;
+
+		//Traverse the hierarchy with the whole packet, and test the triangle blocks of each leaf with every ray that reaches it
+		bvh.traversePacket(packet, activeMasks, nearClip, tMax, [&](int first, int count, const int* leafMasks) {
+			for (int ray = 0; ray < packet.size; ray++)
+			{
+				if (!packet.isActive(leafMasks, ray))
+					continue;
+
+				rtVec3f D = packet.directions[ray];
+				int leafFace = intersectLeaf(first, count, P, D, nearClip, tMax[ray], -1);
+
+				if (leafFace != -1)
+					closestFaces[ray] = leafFace;
+			}
+		});
+
+		//Store the hit data of the rays that hit this mesh
+		for (int ray = 0; ray < packet.size; ray++)
+		{
+			if (closestFaces[ray] == -1)
 				continue;
 
-			//Get the array of vertex indices for the given face
-			array<int, 3>& face = faces->at(faceIndex);
-			//Get the first vertex
-			rtVec3f p0 = vertices->at(face.at(0));
-			//Get the normal using the face index
-			rtVec3f normal = normals->at(faceIndex);
+			rtRayHit& hitData = hits[ray];
+			hitData.hit = true;
+			hitData.hitObject = this;
+			hitData.distance = tMax[ray];
+			hitData.hitPoint = P + (packet.directions[ray] * tMax[ray]);
+			hitData.hitNormal = normals->at(closestFaces[ray]);
+			hitData.hitFaceIndex = closestFaces[ray];
+		}
+	}
 
-			//Calculate the plane constant
-			float k = p0.dot(normal);
-			//Calculate the distance to the plane intersection point
-			float t = (k - P.dot(normal)) / (D.dot(normal));
+	//Ray-Mesh occlusion test. Stops at the first face hit closer than maxDist.
+	bool rtMeshObject::occluded(rtVec3f P, rtVec3f D, float nearClip, float maxDist, rtRayHit originPoint)
+	{
+		//If the ray origin is on the surface of this mesh, the face it starts on is skipped
+		int sourceFace = (originPoint.hitObject == this) ? originPoint.hitFaceIndex : -1;
+
+		return bvh.traverseAny(P, D, nearClip, maxDist, [&](int first, int count) {
+			const int width = triangleBlockWidth;
+			int firstBlock = leafBlocks[first];
+			int lastBlock = firstBlock + (count + width - 1) / width;
 
-			//If the ray is visible, determine if the ray hit the triangle
-			if (t > nearClip && t < tmin)
+			for (int blockIndex = firstBlock; blockIndex < lastBlock; blockIndex++)
 			{
-				//Calculate the intersection point using t
-				rtVec3f r = P + (D * t);
-
-				//Get the remaining two points
-				rtVec3f p1 = vertices->at(face.at(1));
-				rtVec3f p2 = vertices->at(face.at(2));
-
-				//Find the edge vertices
-				rtVec3f e0 = p1 - p0;
-				rtVec3f e1 = p2 - p1;
-				rtVec3f e2 = p0 - p2;
-
-				//If the hit point is on the inside of each edge vector, it is inside the triangle
-				if ((e0.getCrossed(r - p0)).dot(normal) >= 0 &&
-					(e1.getCrossed(r - p1)).dot(normal) >= 0 &&
-					(e2.getCrossed(r - p2)).dot(normal) >= 0)
-				{
-					//Update the distance of the closest intersection
-					tmin = t;
-
-					//Store the hit data into the struct
-					hitData.hit = true;
-					hitData.hitObject = this;
-					hitData.distance = tmin;
-					hitData.hitPoint = r;
-					hitData.hitNormal = normal;
-					hitData.hitFaceIndex = faceIndex;
-				}
+				rtTriangleBlock<width>& block = triangleBlocks[blockIndex];
+				float t[width];
+				int hitMask = intersectTriangles(block, P, D, nearClip, maxDist, t);
+
+				for (int slot = 0; hitMask != 0; slot++, hitMask >>= 1)
+					if ((hitMask & 1) && block.faceIndex[slot] != sourceFace)
+						return true;
 			}
+
+			return false;
+		});
+	}
+
+	//Ray-Mesh Intersection without the bounding volume hierarchy
+	rtRayHit rtMeshObject::rayIntersectLinear(rtVec3f P, rtVec3f D, float nearClip, float farClip, rtRayHit originPoint)
+	{
+		//Create a struct to store the ray cast data.
+		rtRayHit hitData;
+		//By default, set the hit flag to false
+		hitData.hit = false;
+
+		//If the ray origin is on the surface of this mesh, the face it starts on is skipped
+		int sourceFace = (originPoint.hitObject == this) ? originPoint.hitFaceIndex : -1;
+
+		//The distance to the closest intersection point
+		float tmin = farClip;
+
+		//Iterate over all the triangles in the mesh
+		for (int faceIndex = 0; faceIndex < faces->size(); faceIndex++)
+		{
+			//If the ray origin is on the current face, then it does not intersect
+			if (faceIndex != sourceFace)
+				intersectFace(faceIndex, P, D, nearClip, tmin, hitData);
 		}
 
 		//Return the intersection data
@@ -95,4 +316,4 @@ namespace rtGraphics
 
 		return distData;
 	}
-}
\ No newline at end of file
+}
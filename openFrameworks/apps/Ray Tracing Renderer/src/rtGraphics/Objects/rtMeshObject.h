@@ -1,6 +1,8 @@
 #pragma once
 #include "rtObject.h"
 #include "rtMesh.h"
+#include "../Data Classes/rtTriangleBlock.h"
+#include "../Acceleration Structures/rtBVH.h"
 
 namespace rtGraphics
 {
@@ -16,6 +18,28 @@ namespace rtGraphics
 		vecList vertices;
 		intList faces;
 		vecList normals;
+		//A bounding volume hierarchy over the faces of the mesh
+		rtBVH bvh;
+
+		//The bounds of each face, kept between updates to avoid reallocating them every frame
+		vector<rtAABB> faceBounds;
+		//The faces of each leaf packed into blocks for the SIMD intersector, in leaf order
+		vector<rtTriangleBlock<triangleBlockWidth>> triangleBlocks;
+		//The first block of the leaf starting at each primitive position of the hierarchy
+		vector<int> leafBlocks;
+
+		//Calculate the bounds of each face from the current vertex positions
+		void updateFaceBounds();
+		//Build the bounding volume hierarchy for the current mesh
+		void buildBVH();
+		//Pack the faces into triangle blocks following the leaves of the hierarchy
+		void packTriangles();
+		//Find the closest face hit by the ray in the blocks of a leaf, lowering tmin. Returns the face index, or -1 if none are hit.
+		int intersectLeaf(int first, int count, rtVec3f& P, rtVec3f& D, float nearClip, float& tmin, int sourceFace);
+		//Find the distance to the intersection of a ray with a single face. Returns false if the ray misses the face or the hit is outside (nearClip, tmin).
+		bool intersectFaceDistance(int faceIndex, rtVec3f& P, rtVec3f& D, float nearClip, float tmin, float& t);
+		//Intersect a ray with a single face, updating the hit data if the face is closer than tmin
+		void intersectFace(int faceIndex, rtVec3f& P, rtVec3f& D, float nearClip, float& tmin, rtRayHit& hitData);
 
 	public:
 		///Constructors
@@ -37,10 +61,22 @@ namespace rtGraphics
 		///Getter & Setter
 		rtMesh& getMesh();
 		void setMesh(rtMesh& mesh);
+		const rtBVH& getBVH() const;
+		/*
+		 * Update the normals and hierarchy after the vertices of the mesh move. The faces must not change.
+		 * The hierarchy is refit, and only rebuilt if refitting degraded it too much. Returns true if it was rebuilt.
+		 */
+		bool updateMesh();
 
 		///Inherited Methods
 		rtRayHit rayIntersect(rtVec3f P, rtVec3f D, float nearClip, float farClip, rtRayHit originPoint);
+		bool occluded(rtVec3f P, rtVec3f D, float nearClip, float maxDist, rtRayHit originPoint);
+		void rayIntersectPacket(const rtRayPacket& packet, const int* activeMasks, float nearClip, float* tMax, rtRayHit* hits);
 		rtRayHit sdf(rtVec3f P);
+		rtAABB getBounds() const;
+
+		//Intersect a ray by testing every face without the bounding volume hierarchy. Used as a reference for benchmarking.
+		rtRayHit rayIntersectLinear(rtVec3f P, rtVec3f D, float nearClip, float farClip, rtRayHit originPoint);
 	};
 
 	///In-line method definitions
@@ -56,5 +92,17 @@ namespace rtGraphics
 		vertices = mesh.getVerts();
 		faces = mesh.getFaces();
 		normals = mesh.getNormals();
+		buildBVH();
+		markChanged();
+	}
+
+	inline const rtBVH& rtMeshObject::getBVH() const
+	{
+		return bvh;
+	}
+
+	inline rtAABB rtMeshObject::getBounds() const
+	{
+		return bvh.getBounds();
 	}
 }
\ No newline at end of file
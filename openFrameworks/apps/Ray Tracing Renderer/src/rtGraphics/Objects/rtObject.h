@@ -6,7 +6,9 @@
 #include "../rtNode.h"
 #include "../Data Classes/rtVec3f.h"
 #include "../Data Classes/rtMat.h"
+#include "../Data Classes/rtAABB.h"
 #include "../Data Classes/rtRayHit.h"
+#include "../Data Classes/rtRayPacket.h"
 
 using namespace std;
 
@@ -21,12 +23,16 @@ namespace rtGraphics
 	{
 	private:
 		rtMat material;
+		//The number of materials replaced by setMat, which moves the material version on even though the new material counts its changes from zero
+		unsigned long materialChanges = 0;
 
 	public:
 		rtObject() : material(rtMat()) {}
 		rtObject(rtMat& material) : material(material) {}
 		rtMat& getMat();
 		void setMat(const rtMat& material);
+		//Changes to the material, kept apart from the node version since they don't move the object. Only compare it to earlier versions of the same object.
+		unsigned long getMaterialVersion();
 
 		/*
 		 * Used for ray tracing
@@ -35,11 +41,31 @@ namespace rtGraphics
 		 */
 		virtual rtRayHit rayIntersect(rtVec3f P, rtVec3f D, float nearClip, float farClip, rtRayHit originPoint) = 0;
 
+		/*
+		 * Used for shadow rays
+		 * Determines if a ray hits this object closer than maxDist, without computing the hit point or normal
+		 * By default this falls back on rayIntersect, so objects only need to override it when they can test for any hit faster
+		 */
+		virtual bool occluded(rtVec3f P, rtVec3f D, float nearClip, float maxDist, rtRayHit originPoint);
+
+		/*
+		 * Used for packets of camera rays
+		 * Intersects the rays in activeMasks, updating the hit data and tMax of each ray that hits this object closer than its tMax
+		 * By default each ray is traced on its own, so objects only need to override it when they can trace the rays together
+		 */
+		virtual void rayIntersectPacket(const rtRayPacket& packet, const int* activeMasks, float nearClip, float* tMax, rtRayHit* hits);
+
 		/*
 		 * Used for ray marching
 		 * Calculates the shortest distance between the given point and the object
 		 */
 		virtual rtRayHit sdf(rtVec3f P) = 0;
+
+		/*
+		 * Used by the scene acceleration structure
+		 * Returns the world space bounds of the object. Objects without finite bounds return an infinite box and are tested by every ray.
+		 */
+		virtual rtAABB getBounds() const;
 	};
 
 	///In-line method definitions
@@ -50,6 +76,44 @@ namespace rtGraphics
 
 	inline void rtObject::setMat(const rtMat& material)
 	{
+		//Count past every change of the old material, so the sum with the new material's count is always higher than before
+		materialChanges += this->material.getVersion() + 1;
 		this->material = material;
 	}
+
+	inline unsigned long rtObject::getMaterialVersion()
+	{
+		return materialChanges + material.getVersion();
+	}
+
+	inline bool rtObject::occluded(rtVec3f P, rtVec3f D, float nearClip, float maxDist, rtRayHit originPoint)
+	{
+		rtRayHit hitData = rayIntersect(P, D, nearClip, maxDist, originPoint);
+		return (hitData.hit && hitData.distance < maxDist);
+	}
+
+	inline void rtObject::rayIntersectPacket(const rtRayPacket& packet, const int* activeMasks, float nearClip, float* tMax, rtRayHit* hits)
+	{
+		//There is no origin point for a camera ray
+		rtRayHit originPoint;
+
+		for (int ray = 0; ray < packet.size; ray++)
+		{
+			if (!packet.isActive(activeMasks, ray))
+				continue;
+
+			rtRayHit hitData = rayIntersect(packet.origin, packet.directions[ray], nearClip, tMax[ray], originPoint);
+
+			if (hitData.hit && hitData.distance < tMax[ray])
+			{
+				hits[ray] = hitData;
+				tMax[ray] = hitData.distance;
+			}
+		}
+	}
+
+	inline rtAABB rtObject::getBounds() const
+	{
+		return rtAABB(rtVec3f(-INFINITY), rtVec3f(INFINITY));
+	}
 }
\ No newline at end of file
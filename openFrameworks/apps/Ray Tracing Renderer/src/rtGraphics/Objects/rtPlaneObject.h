@@ -66,6 +66,6 @@ namespace rtGraphics
 	inline rtVec3f rtPlaneObject::getNormal() const { return normal; }
 
 	//Setters
-	inline void rtPlaneObject::setPosition(const rtVec3f& position) { this->position = position; }
-	inline void rtPlaneObject::setNormal(const rtVec3f& normal) { this->normal = normal.getNormalized(); }
+	inline void rtPlaneObject::setPosition(const rtVec3f& position) { this->position = position; markChanged(); }
+	inline void rtPlaneObject::setNormal(const rtVec3f& normal) { this->normal = normal.getNormalized(); markChanged(); }
 }
\ No newline at end of file
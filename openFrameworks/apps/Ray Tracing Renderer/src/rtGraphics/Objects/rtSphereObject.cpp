@@ -2,14 +2,9 @@
 
 namespace rtGraphics
 {
-	//Ray-Sphere Intersection
-	rtRayHit rtSphereObject::rayIntersect(rtVec3f P, rtVec3f D, float nearClip, float farClip, rtRayHit originPoint)
+	//Ray-Sphere Intersection distance
+	bool rtSphereObject::intersectDistance(rtVec3f& P, rtVec3f& D, rtRayHit& originPoint, float& t)
 	{
-		//Create a struct to store the ray cast data.
-		rtRayHit hitData;
-		//By default, set the hit flag to false
-		hitData.hit = false;
-
 		//Define an intermediate variable M as the vector from the sphere center to the ray origin
 		rtVec3f M = P - center;
 
@@ -27,16 +22,13 @@ namespace rtGraphics
 
 		//If the discriminant is less than 0, then the ray doesn't intersect the sphere
 		if (discriminant < 0.0f)
-			return hitData;
+			return false;
 
 		//Compute the rest of the quadratic formula to find the intersection distance
 		float sqrtDisc = sqrt(discriminant);
 		float tSub = -dotProd - sqrtDisc;
 		float tAdd = -dotProd + sqrtDisc;
 
-		//The minimum positive intersection distance
-		float t;
-
 		//If the ray is on the object surface, ignore the intersection at that point
 		if (originPoint.hitObject == this)
 		{
@@ -46,7 +38,7 @@ namespace rtGraphics
 
 			//If the ray it pointing outwards from the sphere, then it does not intersect
 			if (tSubAbs > tAddAbs)
-				return hitData;
+				return false;
 			//If the ray is pointing in towards the sphere, use the intersection point on the other side
 			else
 				t = tAdd;
@@ -62,7 +54,21 @@ namespace rtGraphics
 		}
 
 		//If the  intersection point is still behind the ray origin, then the ray does not intersect
-		if (t < 0.0f)
+		return (t >= 0.0f);
+	}
+
+	//Ray-Sphere Intersection
+	rtRayHit rtSphereObject::rayIntersect(rtVec3f P, rtVec3f D, float nearClip, float farClip, rtRayHit originPoint)
+	{
+		//Create a struct to store the ray cast data.
+		rtRayHit hitData;
+		//By default, set the hit flag to false
+		hitData.hit = false;
+
+		//The minimum positive intersection distance
+		float t;
+
+		if (!intersectDistance(P, D, originPoint, t))
 			return hitData;
 
 		//Calculate the point of intersection and the normal at that point
@@ -81,6 +87,13 @@ namespace rtGraphics
 		return hitData;
 	}
 
+	//Ray-Sphere occlusion test, which skips calculating the hit point and normal
+	bool rtSphereObject::occluded(rtVec3f P, rtVec3f D, float nearClip, float maxDist, rtRayHit originPoint)
+	{
+		float t;
+		return (intersectDistance(P, D, originPoint, t) && t < maxDist);
+	}
+
 
 	//Sphere signed distance function
 	rtRayHit rtSphereObject::sdf(rtVec3f P)
@@ -14,6 +14,9 @@ namespace rtGraphics
 		rtVec3f center;
 		float radius;
 
+		//Find the distance to the visible intersection of the ray with the sphere. Returns false if there is none.
+		bool intersectDistance(rtVec3f& P, rtVec3f& D, rtRayHit& originPoint, float& t);
+
 	public:
 		///Constructors
 		rtSphereObject();
@@ -31,7 +34,9 @@ namespace rtGraphics
 
 		///Inherited Methods
 		rtRayHit rayIntersect(rtVec3f P, rtVec3f D, float nearClip, float farClip, rtRayHit originPoint);
+		bool occluded(rtVec3f P, rtVec3f D, float nearClip, float maxDist, rtRayHit originPoint);
 		rtRayHit sdf(rtVec3f P);
+		rtAABB getBounds() const;
 	};
 
 	///Constructors
@@ -65,6 +70,11 @@ namespace rtGraphics
 	inline float rtSphereObject::getRadius() const { return radius; }
 
 	//Setters
-	inline void rtSphereObject::setCenter(const rtVec3f& center) { this->center = center; }
-	inline void rtSphereObject::setRadius(float radius) { this->radius = radius; }
+	inline void rtSphereObject::setCenter(const rtVec3f& center) { this->center = center; markChanged(); }
+	inline void rtSphereObject::setRadius(float radius) { this->radius = radius; markChanged(); }
+
+	inline rtAABB rtSphereObject::getBounds() const
+	{
+		return rtAABB(center - radius, center + radius);
+	}
 }
\ No newline at end of file
@@ -35,6 +35,7 @@ namespace rtGraphics
 		///Inherited Methods
 		rtRayHit rayIntersect(rtVec3f P, rtVec3f D, float nearClip, float farClip, rtRayHit originPoint);
 		rtRayHit sdf(rtVec3f P);
+		rtAABB getBounds() const;
 	};
 
 	///Constructors
@@ -75,7 +76,14 @@ namespace rtGraphics
 	inline float rtTorusObject::getTubeRadius() const { return minorRadius; }
 
 	//Setters
-	inline void rtTorusObject::setCenter(const rtVec3f& center) { this->center = center; }
-	inline void rtTorusObject::setCircleRadius(float radius) { this->majorRadius = radius; }
-	inline void rtTorusObject::setTubeRadius(float radius) { this->minorRadius = minorRadius; }
+	inline void rtTorusObject::setCenter(const rtVec3f& center) { this->center = center; markChanged(); }
+	inline void rtTorusObject::setCircleRadius(float radius) { this->majorRadius = radius; markChanged(); }
+	inline void rtTorusObject::setTubeRadius(float radius) { this->minorRadius = radius; markChanged(); }
+
+	inline rtAABB rtTorusObject::getBounds() const
+	{
+		//The torus lies flat in the xz plane
+		rtVec3f halfExtent(majorRadius + minorRadius, minorRadius, majorRadius + minorRadius);
+		return rtAABB(center - halfExtent, center + halfExtent);
+	}
 }
\ No newline at end of file
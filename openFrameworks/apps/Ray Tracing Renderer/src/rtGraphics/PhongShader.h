@@ -1,3 +1,5 @@
+#pragma once
+
 #include "Data Classes/rtVec3f.h"
 #include "Data Classes/rtColorf.h"
 
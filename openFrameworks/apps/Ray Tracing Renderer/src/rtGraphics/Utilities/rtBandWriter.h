@@ -0,0 +1,125 @@
+#pragma once
+#include <string>
+#include <fstream>
+#include <memory>
+#include "ofPixels.h"
+#include "rtImageWriter.h"
+
+namespace rtGraphics
+{
+	/*
+	 * Writes an image to a file one band of rows at a time, for images too large to hold in memory
+	 * The file is created at its full size when it is opened, and each band is written in place as it is rendered.
+	 */
+	class rtBandWriter
+	{
+	protected:
+		ofstream imageFile;
+		string filePath;
+		int width, height;
+		//The size of the header before the first row, and of each row
+		streamoff headerSize, rowSize;
+
+		//Create the file at its full size, so running out of disk space fails before rendering starts
+		void createFile(string header, int bytesPerPixel)
+		{
+			imageFile.open(filePath, ios::binary | ios::out | ios::trunc);
+
+			if (!imageFile.is_open())
+				throw "Unable to open file: '" + filePath + "'";
+
+			headerSize = header.size();
+			rowSize = (streamoff)width * bytesPerPixel;
+			imageFile << header;
+
+			//Writing the last byte extends the file to its full size
+			imageFile.seekp(headerSize + rowSize * height - 1);
+			imageFile.put(0);
+
+			if (!imageFile)
+				throw "Unable to write file: '" + filePath + "'";
+		}
+
+		//Write a row of the image at its place in the file
+		void writeRow(streamoff rowIndex, const void* data)
+		{
+			imageFile.seekp(headerSize + rowSize * rowIndex);
+			imageFile.write((const char*)data, rowSize);
+
+			if (!imageFile)
+				throw "Unable to write file: '" + filePath + "'";
+		}
+
+	public:
+		virtual ~rtBandWriter() {}
+
+		//Create the file for an image of the given dimensions. Throws a string describing the problem if the file can't be created.
+		virtual void open(string filePath, int width, int height) = 0;
+		//Write rows of the band buffers, starting at the given row of the buffers, to the image starting at its first row
+		virtual void writeBand(int firstRow, int numRows, const ofPixels& pixels, const ofFloatPixels& radiance, int bufferRow) = 0;
+
+		void close()
+		{
+			imageFile.close();
+		}
+
+		//Make a band writer for the extension of the file, or return null if the format can't be written a band at a time
+		static unique_ptr<rtBandWriter> forFile(string filePath);
+	};
+
+
+	//Writes the 8-bit pixels as a binary PPM file, whose rows are stored from top to bottom
+	class rtPPMBandWriter : public rtBandWriter
+	{
+	public:
+		void open(string filePath, int width, int height)
+		{
+			this->filePath = filePath;
+			this->width = width;
+			this->height = height;
+			createFile("P6\n" + to_string(width) + " " + to_string(height) + "\n255\n", 3);
+		}
+
+		void writeBand(int firstRow, int numRows, const ofPixels& pixels, const ofFloatPixels& radiance, int bufferRow)
+		{
+			for (int row = 0; row < numRows; row++)
+				writeRow(firstRow + row, pixels.getData() + (size_t)(bufferRow + row) * width * 3);
+		}
+	};
+
+
+	//Writes the float radiance as a PFM file, whose rows are stored from bottom to top
+	class rtPFMBandWriter : public rtBandWriter
+	{
+	public:
+		void open(string filePath, int width, int height)
+		{
+			this->filePath = filePath;
+			this->width = width;
+			this->height = height;
+			//A negative scale marks the floats as little endian
+			createFile("PF\n" + to_string(width) + " " + to_string(height) + "\n-1.0\n", 3 * sizeof(float));
+		}
+
+		void writeBand(int firstRow, int numRows, const ofPixels& pixels, const ofFloatPixels& radiance, int bufferRow)
+		{
+			for (int row = 0; row < numRows; row++)
+				writeRow(height - 1 - (firstRow + row), radiance.getData() + (size_t)(bufferRow + row) * width * 3);
+		}
+	};
+
+
+	///In-line method definitions
+	inline unique_ptr<rtBandWriter> rtBandWriter::forFile(string filePath)
+	{
+		string extension = rtImageWriter::getExtension(filePath);
+
+		if (extension == "ppm")
+			return unique_ptr<rtBandWriter>(new rtPPMBandWriter());
+
+		if (extension == "pfm")
+			return unique_ptr<rtBandWriter>(new rtPFMBandWriter());
+
+		return nullptr;
+	}
+}
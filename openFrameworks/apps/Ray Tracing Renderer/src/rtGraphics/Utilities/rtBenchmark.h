@@ -0,0 +1,441 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include "../Objects/rtMeshObject.h"
+#include "../Acceleration Structures/rtSceneBVH.h"
+#include "../rtRenderer.h"
+#include "../rtWavefrontRenderer.h"
+
+namespace rtGraphics
+{
+	//The throughput measured by a benchmark run
+	struct rtBenchmarkResult
+	{
+		string name;
+		int numRays = 0;
+		int numHits = 0;
+		double seconds = 0.0;
+
+		double raysPerSecond() const { return (seconds > 0.0) ? numRays / seconds : 0.0; }
+	};
+
+
+	class rtBenchmark
+	{
+	private:
+		//Generate rays starting on a sphere around the bounds and aimed at random points inside them. A fixed seed keeps runs comparable.
+		static void generateRays(const rtAABB& bounds, int numRays, vector<rtVec3f>& origins, vector<rtVec3f>& directions)
+		{
+			mt19937 generator(12345);
+			uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+			rtVec3f center = bounds.getCentroid();
+			rtVec3f extent = bounds.getExtent();
+			float radius = extent.magnitude();
+
+			origins.resize(numRays);
+			directions.resize(numRays);
+
+			for (int rayIndex = 0; rayIndex < numRays; rayIndex++)
+			{
+				//Pick a random direction from the center to place the origin
+				rtVec3f offset;
+
+				do
+					offset = rtVec3f(unit(generator) * 2.0f - 1.0f, unit(generator) * 2.0f - 1.0f, unit(generator) * 2.0f - 1.0f);
+				while (offset.magnitudeSquared() > 1.0f || offset.magnitudeSquared() < 0.0001f);
+
+				origins[rayIndex] = center + offset.normalize() * radius;
+
+				//Aim at a random point within the bounds
+				rtVec3f target = bounds.getMin() + extent * rtVec3f(unit(generator), unit(generator), unit(generator));
+				directions[rayIndex] = (target - origins[rayIndex]).normalize();
+			}
+		}
+
+		//Generate the directions of the camera rays of an image in row order, using the same grid as the renderer
+		static void generateCameraRays(const rtVec3f& lookVector, const rtVec3f& upVector, float hFov, int width, int height, vector<rtVec3f>& directions)
+		{
+			//Calculate the viewing axes the same way as the camera
+			rtVec3f n = -lookVector;
+			n.normalize();
+			rtVec3f u = upVector.getCrossed(n);
+			u.normalize();
+			rtVec3f v = n.getCrossed(u);
+			v.normalize();
+
+			//Only the directions are needed, so the grid is placed at a distance of 1 from the camera
+			float halfClipWidth = sin(hFov / 2.0f * 3.14159265f / 180.0f);
+			float halfClipHeight = halfClipWidth * ((float)height / (float)width);
+			rtVec3f widthVector = u * halfClipWidth;
+			rtVec3f heightVector = v * halfClipHeight;
+			rtVec3f hStep = (widthVector * -2) / (float)width;
+			rtVec3f vStep = (heightVector * -2) / (float)height;
+			rtVec3f firstPoint = -n + widthVector + heightVector;
+
+			directions.resize(width * height);
+
+			for (int row = 0; row < height; row++)
+				for (int col = 0; col < width; col++)
+					directions[row * width + col] = (firstPoint + (hStep * col) + (vStep * row)).normalize();
+		}
+
+		//Time how long the tracer takes to intersect all the rays
+		template<typename Tracer>
+		static rtBenchmarkResult timeRays(const string& name, vector<rtVec3f>& origins, vector<rtVec3f>& directions, Tracer trace)
+		{
+			rtBenchmarkResult result;
+			result.name = name;
+			result.numRays = origins.size();
+
+			chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+			for (int rayIndex = 0; rayIndex < origins.size(); rayIndex++)
+				if (trace(origins[rayIndex], directions[rayIndex]).hit)
+					result.numHits++;
+
+			result.seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+			return result;
+		}
+
+		//Rebuild the hierarchies of every mesh in the list
+		static void rebuildMeshes(objectSet objects)
+		{
+			for (int objectIndex = 0; objectIndex < objects->size(); objectIndex++)
+			{
+				rtMeshObject* meshObject = dynamic_cast<rtMeshObject*>(objects->at(objectIndex));
+
+				if (meshObject != nullptr)
+					meshObject->setMesh(meshObject->getMesh());
+			}
+		}
+
+		//The node layouts compared by the layout benchmarks
+		static const int numLayouts = 3;
+
+		static bvhLayout getLayout(int layoutIndex)
+		{
+			bvhLayout layouts[] = { bvhLayout::binary, bvhLayout::wide4, bvhLayout::wide8 };
+			return layouts[layoutIndex];
+		}
+
+		static string getLayoutName(int layoutIndex)
+		{
+			string layoutNames[] = { "  Binary", "  BVH4  ", "  BVH8  " };
+			return layoutNames[layoutIndex];
+		}
+
+	public:
+		static void printResult(const rtBenchmarkResult& result)
+		{
+			cout << result.name << ": " << (result.raysPerSecond() / 1000000.0) << " Mrays/s ("
+				<< result.numRays << " rays, " << result.numHits << " hits, " << (result.seconds * 1000.0) << " ms)" << endl;
+		}
+
+		//Compare the rays per second of the mesh hierarchy against testing every face
+		static void compareMeshIntersection(rtMeshObject& meshObject, int numRays = 100000)
+		{
+			vector<rtVec3f> origins;
+			vector<rtVec3f> directions;
+			generateRays(meshObject.getBounds(), numRays, origins, directions);
+
+			//There is no origin point for the benchmark rays
+			rtRayHit originPoint;
+			float farClip = INFINITY;
+
+			cout << "Mesh intersection benchmark (" << meshObject.getMesh().getFaces()->size() << " faces)" << endl;
+
+			rtBenchmarkResult linear = timeRays("  Linear", origins, directions, [&](rtVec3f& P, rtVec3f& D) {
+				return meshObject.rayIntersectLinear(P, D, 0.0f, farClip, originPoint);
+			});
+
+			rtBenchmarkResult bvh = timeRays("  BVH   ", origins, directions, [&](rtVec3f& P, rtVec3f& D) {
+				return meshObject.rayIntersect(P, D, 0.0f, farClip, originPoint);
+			});
+
+			printResult(linear);
+			printResult(bvh);
+
+			if (linear.seconds > 0.0 && bvh.seconds > 0.0)
+				cout << "  Speedup: " << (linear.seconds / bvh.seconds) << "x" << endl;
+		}
+
+		//Rebuild the mesh hierarchy with each build method and compare the build time, tree quality and rays per second
+		static void compareBuildMethods(rtMeshObject& meshObject, int numRays = 100000)
+		{
+			vector<rtVec3f> origins;
+			vector<rtVec3f> directions;
+			generateRays(meshObject.getBounds(), numRays, origins, directions);
+
+			rtRayHit originPoint;
+			float farClip = INFINITY;
+
+			bvhBuildMethod originalMethod = rtBVH::getBuildMethod();
+			bvhBuildMethod methods[] = { bvhBuildMethod::sweepSAH, bvhBuildMethod::binnedSAH };
+			string methodNames[] = { "  Sweep SAH ", "  Binned SAH" };
+
+			cout << "BVH build benchmark (" << meshObject.getMesh().getFaces()->size() << " faces, "
+				<< rtBVH::getNumBuildThreads() << " build threads)" << endl;
+
+			for (int methodIndex = 0; methodIndex < 2; methodIndex++)
+			{
+				//Setting the mesh rebuilds the hierarchy
+				rtBVH::setBuildMethod(methods[methodIndex]);
+				meshObject.setMesh(meshObject.getMesh());
+				const rtBVHBuildStats& stats = meshObject.getBVH().getBuildStats();
+
+				cout << methodNames[methodIndex] << ": built in " << stats.buildTime << " ms, SAH cost " << stats.sahCost
+					<< ", " << stats.nodeCount << " nodes, " << stats.leafCount << " leaves" << endl;
+
+				printResult(timeRays(methodNames[methodIndex], origins, directions, [&](rtVec3f& P, rtVec3f& D) {
+					return meshObject.rayIntersect(P, D, 0.0f, farClip, originPoint);
+				}));
+			}
+
+			//Restore the original build method
+			rtBVH::setBuildMethod(originalMethod);
+			meshObject.setMesh(meshObject.getMesh());
+		}
+
+		//Rebuild the mesh hierarchy with each node layout and compare the rays per second
+		static void compareMeshLayouts(rtMeshObject& meshObject, int numRays = 100000)
+		{
+			vector<rtVec3f> origins;
+			vector<rtVec3f> directions;
+			generateRays(meshObject.getBounds(), numRays, origins, directions);
+
+			rtRayHit originPoint;
+			float farClip = INFINITY;
+			bvhLayout originalLayout = rtBVH::getLayout();
+
+			cout << "BVH layout benchmark (" << meshObject.getMesh().getFaces()->size() << " faces)" << endl;
+
+			for (int layoutIndex = 0; layoutIndex < numLayouts; layoutIndex++)
+			{
+				rtBVH::setLayout(getLayout(layoutIndex));
+				meshObject.setMesh(meshObject.getMesh());
+
+				printResult(timeRays(getLayoutName(layoutIndex), origins, directions, [&](rtVec3f& P, rtVec3f& D) {
+					return meshObject.rayIntersect(P, D, 0.0f, farClip, originPoint);
+				}));
+			}
+
+			rtBVH::setLayout(originalLayout);
+			meshObject.setMesh(meshObject.getMesh());
+		}
+
+		//Rebuild the scene and mesh hierarchies with each node layout and compare the rays per second
+		static void compareSceneLayouts(objectSet objects, int numRays = 100000)
+		{
+			bvhLayout originalLayout = rtBVH::getLayout();
+			vector<rtVec3f> origins;
+			vector<rtVec3f> directions;
+
+			rtRayHit originPoint;
+			float farClip = INFINITY;
+
+			cout << "Scene layout benchmark (" << objects->size() << " objects)" << endl;
+
+			for (int layoutIndex = 0; layoutIndex < numLayouts; layoutIndex++)
+			{
+				rtBVH::setLayout(getLayout(layoutIndex));
+				rebuildMeshes(objects);
+				rtSceneBVH sceneBVH(objects);
+
+				if (origins.empty())
+					generateRays(sceneBVH.getBounds(), numRays, origins, directions);
+
+				printResult(timeRays(getLayoutName(layoutIndex), origins, directions, [&](rtVec3f& P, rtVec3f& D) {
+					return sceneBVH.rayIntersect(P, D, 0.0f, farClip, originPoint);
+				}));
+			}
+
+			rtBVH::setLayout(originalLayout);
+			rebuildMeshes(objects);
+		}
+
+		//Trace the camera rays of an image one at a time and in packets of each size, and compare the rays per second
+		static void comparePacketSizes(objectSet objects, rtVec3f camPos, const rtVec3f& lookVector, const rtVec3f& upVector, float hFov,
+			int width, int height, float nearClip = 0.1f, float farClip = 1000.0f)
+		{
+			rtSceneBVH sceneBVH(objects);
+
+			vector<rtVec3f> directions;
+			generateCameraRays(lookVector, upVector, hFov, width, height, directions);
+
+			//There is no origin point for a camera ray
+			rtRayHit originPoint;
+			vector<rtVec3f> origins(directions.size(), camPos);
+			vector<rtRayHit> singleHits(directions.size());
+			int rayIndex = 0;
+
+			cout << "Packet tracing benchmark (" << width << "x" << height << " camera rays)" << endl;
+
+			//Trace every ray on its own as a reference
+			rtBenchmarkResult single = timeRays("  Single", origins, directions, [&](rtVec3f& P, rtVec3f& D) {
+				singleHits[rayIndex] = sceneBVH.rayIntersect(P, D, nearClip, farClip, originPoint);
+				return singleHits[rayIndex++];
+			});
+
+			printResult(single);
+
+			rayPacketSize packetSizes[] = { rayPacketSize::packet2x2, rayPacketSize::packet4x4, rayPacketSize::packet8x8 };
+			string packetNames[] = { "  2x2   ", "  4x4   ", "  8x8   " };
+
+			for (int sizeIndex = 0; sizeIndex < 3; sizeIndex++)
+			{
+				int packetWidth = (int)packetSizes[sizeIndex];
+				vector<rtRayHit> packetHits(directions.size());
+
+				rtBenchmarkResult result;
+				result.name = packetNames[sizeIndex];
+				result.numRays = directions.size();
+
+				rtRayPacket packet;
+				packet.origin = camPos;
+				rtRayHit hits[maxPacketSize];
+
+				chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+				//Trace the image in blocks the same way as the render threads
+				for (int blockRow = 0; blockRow < height; blockRow += packetWidth)
+				{
+					for (int blockCol = 0; blockCol < width; blockCol += packetWidth)
+					{
+						packet.setSize(packetWidth * packetWidth);
+
+						for (int ray = 0; ray < packet.size; ray++)
+						{
+							int row = blockRow + ray / packetWidth;
+							int col = blockCol + ray % packetWidth;
+
+							if (row < height && col < width)
+								packet.setRay(ray, directions[row * width + col]);
+						}
+
+						packet.update();
+						sceneBVH.rayIntersectPacket(packet, nearClip, farClip, hits);
+
+						for (int ray = 0; ray < packet.size; ray++)
+							if (packet.isActive(packet.activeMasks, ray))
+								packetHits[(blockRow + ray / packetWidth) * width + blockCol + ray % packetWidth] = hits[ray];
+					}
+				}
+
+				result.seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+				//Compare the hits against the rays traced on their own
+				int mismatches = 0;
+
+				for (int pixel = 0; pixel < packetHits.size(); pixel++)
+				{
+					if (packetHits[pixel].hit)
+						result.numHits++;
+
+					if (packetHits[pixel].hit != singleHits[pixel].hit ||
+						(packetHits[pixel].hit && fabsf(packetHits[pixel].distance - singleHits[pixel].distance) > 0.0001f * singleHits[pixel].distance))
+						mismatches++;
+				}
+
+				printResult(result);
+
+				if (single.seconds > 0.0 && result.seconds > 0.0)
+					cout << "  Speedup: " << (single.seconds / result.seconds) << "x, " << mismatches << " rays differ from single rays" << endl;
+			}
+		}
+
+		//Render the camera's image with the recursive tracer and the wavefront pipeline, and compare the time taken and the colors
+		static void comparePipelines(shared_ptr<rtScene> scene, rtVec3f camPos, const rtVec3f& lookVector, const rtVec3f& upVector, float hFov,
+			int width, int height, float nearClip, float farClip, int maxBounces, int tileSize = 32)
+		{
+			rtSceneBVH sceneBVH(scene->getObjects());
+			lightSet lights = scene->getLights();
+
+			vector<rtVec3f> directions;
+			generateCameraRays(lookVector, upVector, hFov, width, height, directions);
+
+			//There is no origin point for a camera ray
+			rtRayHit originPoint;
+			vector<rtColorf> recursiveColors(directions.size());
+
+			cout << "Render pipeline benchmark (" << width << "x" << height << ", " << lights->size() << " lights, " << maxBounces << " bounces)" << endl;
+
+			//Trace every pixel depth-first
+			chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+			for (int pixel = 0; pixel < directions.size(); pixel++)
+				recursiveColors[pixel] = rtRenderer::rayTrace(sceneBVH, lights, camPos, directions[pixel], nearClip, farClip, 0, maxBounces, originPoint);
+
+			double recursiveSeconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+			//Trace the image a tile at a time, one bounce after another
+			rtWavefrontRenderer wavefront;
+			vector<rtVec3f> tileDirections;
+			vector<rtColorf> tileColors;
+			int differentPixels = 0;
+			double wavefrontSeconds = 0.0;
+
+			for (int tileRow = 0; tileRow < height; tileRow += tileSize)
+			{
+				for (int tileCol = 0; tileCol < width; tileCol += tileSize)
+				{
+					int tileWidth = min(tileSize, width - tileCol);
+					int tileHeight = min(tileSize, height - tileRow);
+					tileDirections.resize(tileWidth * tileHeight);
+
+					for (int row = 0; row < tileHeight; row++)
+						for (int col = 0; col < tileWidth; col++)
+							tileDirections[row * tileWidth + col] = directions[(tileRow + row) * width + tileCol + col];
+
+					startTime = chrono::steady_clock::now();
+					wavefront.render(sceneBVH, lights, camPos, tileDirections, tileWidth, tileHeight, nearClip, farClip, maxBounces, 1, tileColors);
+					wavefrontSeconds += chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+					for (int row = 0; row < tileHeight; row++)
+						for (int col = 0; col < tileWidth; col++)
+							if (tileColors[row * tileWidth + col] != recursiveColors[(tileRow + row) * width + tileCol + col])
+								differentPixels++;
+				}
+			}
+
+			cout << "  Recursive: " << (recursiveSeconds * 1000.0) << " ms" << endl;
+			cout << "  Wavefront: " << (wavefrontSeconds * 1000.0) << " ms" << endl;
+
+			if (recursiveSeconds > 0.0 && wavefrontSeconds > 0.0)
+				cout << "  Speedup: " << (recursiveSeconds / wavefrontSeconds) << "x, " << differentPixels << " pixels differ" << endl;
+		}
+
+		//Compare the rays per second of the scene hierarchy against testing every object
+		static void compareSceneIntersection(objectSet objects, int numRays = 100000)
+		{
+			rtSceneBVH sceneBVH(objects);
+
+			vector<rtVec3f> origins;
+			vector<rtVec3f> directions;
+			generateRays(sceneBVH.getBounds(), numRays, origins, directions);
+
+			//There is no origin point for the benchmark rays
+			rtRayHit originPoint;
+			float farClip = INFINITY;
+
+			cout << "Scene intersection benchmark (" << objects->size() << " objects)" << endl;
+
+			rtBenchmarkResult linear = timeRays("  Linear", origins, directions, [&](rtVec3f& P, rtVec3f& D) {
+				return sceneBVH.rayIntersectLinear(P, D, 0.0f, farClip, originPoint);
+			});
+
+			rtBenchmarkResult bvh = timeRays("  BVH   ", origins, directions, [&](rtVec3f& P, rtVec3f& D) {
+				return sceneBVH.rayIntersect(P, D, 0.0f, farClip, originPoint);
+			});
+
+			printResult(linear);
+			printResult(bvh);
+
+			if (linear.seconds > 0.0 && bvh.seconds > 0.0)
+				cout << "  Speedup: " << (linear.seconds / bvh.seconds) << "x" << endl;
+		}
+	};
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <string>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include "ofPixels.h"
+#include "ofImage.h"
+#include "ofFileUtils.h"
+
+namespace rtGraphics
+{
+	/*
+	 * Writes rendered frames to image files
+	 * Each writer is given both the tone mapped 8-bit pixels and the float radiance, and writes whichever its format stores.
+	 * Writers are chosen by file extension. More formats can be added with addWriter.
+	 */
+	class rtImageWriter
+	{
+	public:
+		typedef function<unique_ptr<rtImageWriter>()> writerFactory;
+
+	private:
+		//The writer factories by lower case file extension
+		static map<string, writerFactory>& writers();
+
+	public:
+		virtual ~rtImageWriter() {}
+
+		//Write the frame to the given file. Throws a string describing the problem if the file can't be written.
+		virtual void write(string filePath, const ofPixels& pixels, const ofFloatPixels& radiance) = 0;
+
+		//Use the writer made by the factory for files with the given extension, replacing any writer it had
+		static void addWriter(string extension, writerFactory factory);
+		//Make a writer for the extension of the file. Throws a string if no writer handles the extension.
+		static unique_ptr<rtImageWriter> forFile(string filePath);
+		//The lower case extension of the file, without the dot
+		static string getExtension(string filePath);
+	};
+
+
+	//Writes the 8-bit pixels as a binary PPM file, which needs no image library
+	class rtPPMWriter : public rtImageWriter
+	{
+	public:
+		void write(string filePath, const ofPixels& pixels, const ofFloatPixels& radiance)
+		{
+			ofstream imageFile(filePath, ios::binary);
+
+			if (!imageFile.is_open())
+				throw "Unable to open file: '" + filePath + "'";
+
+			imageFile << "P6\n" << pixels.getWidth() << " " << pixels.getHeight() << "\n255\n";
+			imageFile.write((const char*)pixels.getData(), pixels.getWidth() * pixels.getHeight() * 3);
+
+			if (!imageFile)
+				throw "Unable to write file: '" + filePath + "'";
+		}
+	};
+
+
+	//Writes the 8-bit pixels in any format FreeImage saves from its extension, such as PNG
+	class rtFreeImageWriter : public rtImageWriter
+	{
+	public:
+		void write(string filePath, const ofPixels& pixels, const ofFloatPixels& radiance)
+		{
+			//openFrameworks treats relative paths as relative to the data folder, while command line paths are relative to the working directory
+			if (!ofSaveImage(pixels, ofFilePath::getAbsolutePath(filePath, false)))
+				throw "Unable to write file: '" + filePath + "'";
+		}
+	};
+
+
+	//Writes the float radiance before tone mapping as an OpenEXR file
+	class rtEXRWriter : public rtImageWriter
+	{
+	public:
+		void write(string filePath, const ofPixels& pixels, const ofFloatPixels& radiance)
+		{
+			if (!ofSaveImage(radiance, ofFilePath::getAbsolutePath(filePath, false)))
+				throw "Unable to write file: '" + filePath + "'";
+		}
+	};
+
+
+	///In-line method definitions
+	//The built in writers are added the first time a writer is looked up
+	inline map<string, rtImageWriter::writerFactory>& rtImageWriter::writers()
+	{
+		static map<string, writerFactory> factories = {
+			{ "ppm", [] { return unique_ptr<rtImageWriter>(new rtPPMWriter()); } },
+			{ "png", [] { return unique_ptr<rtImageWriter>(new rtFreeImageWriter()); } },
+			{ "jpg", [] { return unique_ptr<rtImageWriter>(new rtFreeImageWriter()); } },
+			{ "bmp", [] { return unique_ptr<rtImageWriter>(new rtFreeImageWriter()); } },
+			{ "exr", [] { return unique_ptr<rtImageWriter>(new rtEXRWriter()); } }
+		};
+
+		return factories;
+	}
+
+	inline void rtImageWriter::addWriter(string extension, writerFactory factory)
+	{
+		transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+		writers()[extension] = factory;
+	}
+
+	inline unique_ptr<rtImageWriter> rtImageWriter::forFile(string filePath)
+	{
+		string extension = getExtension(filePath);
+		auto factory = writers().find(extension);
+
+		if (factory == writers().end())
+			throw "Cannot write images with extension '" + extension + "'";
+
+		return factory->second();
+	}
+
+	inline string rtImageWriter::getExtension(string filePath)
+	{
+		size_t lastDot = filePath.find_last_of('.');
+		size_t lastSeparator = filePath.find_last_of("/\\");
+
+		//A dot before the last separator belongs to a folder name
+		if (lastDot == string::npos || (lastSeparator != string::npos && lastDot < lastSeparator))
+			return "";
+
+		string extension = filePath.substr(lastDot + 1);
+		transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+		return extension;
+	}
+}
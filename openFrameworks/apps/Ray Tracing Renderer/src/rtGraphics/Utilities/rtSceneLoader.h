@@ -0,0 +1,235 @@
+#pragma once
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <vector>
+#include "ObjImporter.h"
+#include "../Data Classes/rtScene.h"
+#include "../Objects/rtMeshObject.h"
+#include "../Objects/rtSphereObject.h"
+#include "../Objects/rtPlaneObject.h"
+
+namespace rtGraphics
+{
+	//The camera view at a frame of an animation
+	struct rtCameraKey
+	{
+		float frame;
+		rtVec3f position, lookAt, up;
+		float fov;
+	};
+
+	//A scene loaded from a scene file, along with the camera it is viewed from
+	struct rtSceneDescription
+	{
+		shared_ptr<rtScene> scene;
+		//The camera defaults to the same view as a default rtCam
+		rtVec3f camPosition = rtVec3f::zero;
+		rtVec3f camLookAt = rtVec3f::forward;
+		rtVec3f camUp = rtVec3f::up;
+		float fov = 90.0f;
+		//The camera views at the key frames of an animation of the scene, in the order they appear in the file
+		vector<rtCameraKey> cameraKeys;
+	};
+
+
+	/*
+	 * Loads scenes from text files with one statement per line. Blank lines and lines starting with '#' are ignored.
+	 *   material <name> <ambient r g b> <diffuse r g b> <specular r g b> [smoothness] [reflectivity]
+	 *   mesh <OBJ file> <material>
+	 *   box <min x y z> <max x y z> <material>
+	 *   sphere <center x y z> <radius> <material>
+	 *   plane <point x y z> <normal x y z> <material>
+	 *   light <position x y z> <ambient r g b> <diffuse r g b> <specular r g b> [incident intensity] [ambient intensity]
+	 *   camera <position x y z> <look-at point x y z> <up vector x y z> [fov]
+	 *   camera-key <frame> <position x y z> <look-at point x y z> <up vector x y z> [fov]
+	 * OBJ files are found relative to the folder of the scene file. Materials must be defined before they are used.
+	 * Camera keys set the view at frames of an animation. Animations without any use the view of the camera statement for every frame.
+	 */
+	class rtSceneLoader
+	{
+	private:
+		static rtVec3f readVector(stringstream& sstream)
+		{
+			float x, y, z;
+			sstream >> x >> y >> z;
+			return rtVec3f(x, y, z);
+		}
+
+		static rtColorf readColor(stringstream& sstream)
+		{
+			float r, g, b;
+			sstream >> r >> g >> b;
+			return rtColorf(r, g, b);
+		}
+
+		//Throw if any of the values a statement requires were missing or not numbers
+		static void checkRead(stringstream& sstream, string statement, int lineNumber)
+		{
+			if (sstream.fail())
+				throw "Line " + to_string(lineNumber) + ": Unable to read '" + statement + "' statement";
+		}
+
+		//Read an optional value, keeping the default if the line ends first
+		static float readOptional(stringstream& sstream, float defaultValue)
+		{
+			float value;
+			return (sstream >> value) ? value : defaultValue;
+		}
+
+		static rtMat& findMaterial(map<string, rtMat>& materials, string name, int lineNumber)
+		{
+			auto material = materials.find(name);
+
+			if (material == materials.end())
+				throw "Line " + to_string(lineNumber) + ": Unknown material '" + name + "'";
+
+			return material->second;
+		}
+
+		//Build a box whose faces point inwards, so that it can surround the scene
+		static rtMesh makeBox(const rtVec3f& min, const rtVec3f& max)
+		{
+			rtMesh boxMesh;
+
+			for (int corner = 0; corner < 8; corner++)
+				boxMesh.addVert(rtVec3f((corner & 4) ? max.getX() : min.getX(), (corner & 2) ? max.getY() : min.getY(), (corner & 1) ? max.getZ() : min.getZ()));
+
+			boxMesh.addFace(1, 0, 2); boxMesh.addFace(2, 3, 1);		//Left Wall
+			boxMesh.addFace(4, 5, 7); boxMesh.addFace(7, 6, 4);		//Right Wall
+			boxMesh.addFace(0, 4, 6); boxMesh.addFace(6, 2, 0);		//Back Wall
+			boxMesh.addFace(5, 1, 3); boxMesh.addFace(3, 7, 5);		//Front Wall
+			boxMesh.addFace(2, 6, 7); boxMesh.addFace(7, 3, 2);		//Top Wall
+			boxMesh.addFace(4, 0, 1); boxMesh.addFace(1, 5, 4);		//Bottom Wall
+
+			return boxMesh;
+		}
+
+	public:
+		//Loads a scene file. Throws a string describing the problem if the file can't be read.
+		static rtSceneDescription loadScene(string filePath)
+		{
+			ifstream sceneFile(filePath);
+
+			if (!sceneFile.is_open())
+				throw "Unable to open file: '" + filePath + "'";
+
+			//Paths in the scene file are relative to its folder
+			size_t lastSeparator = filePath.find_last_of("/\\");
+			string folder = (lastSeparator == string::npos) ? "" : filePath.substr(0, lastSeparator + 1);
+
+			rtSceneDescription description;
+			description.scene = make_shared<rtScene>();
+			map<string, rtMat> materials;
+			string line;
+			int lineNumber = 0;
+
+			while (getline(sceneFile, line))
+			{
+				lineNumber++;
+				stringstream sstream(line);
+				string statement;
+
+				//Skip blank lines and comments
+				if (!(sstream >> statement) || statement[0] == '#')
+					continue;
+
+				if (statement == "material")
+				{
+					string name;
+					sstream >> name;
+					rtColorf ambient = readColor(sstream);
+					rtColorf diffuse = readColor(sstream);
+					rtColorf specular = readColor(sstream);
+					checkRead(sstream, statement, lineNumber);
+					float smoothness = readOptional(sstream, 20.0f);
+					float reflectivity = readOptional(sstream, 0.0f);
+
+					materials[name] = rtMat(ambient, diffuse, specular, smoothness, reflectivity);
+				}
+				else if (statement == "mesh")
+				{
+					string objPath, material;
+					sstream >> objPath >> material;
+					checkRead(sstream, statement, lineNumber);
+					rtMesh mesh = ObjImoprter::loadOBJ(folder + objPath);
+
+					description.scene->addObject(new rtMeshObject(mesh, findMaterial(materials, material, lineNumber)));
+				}
+				else if (statement == "box")
+				{
+					rtVec3f min = readVector(sstream);
+					rtVec3f max = readVector(sstream);
+					string material;
+					sstream >> material;
+					checkRead(sstream, statement, lineNumber);
+					rtMesh mesh = makeBox(min, max);
+
+					description.scene->addObject(new rtMeshObject(mesh, findMaterial(materials, material, lineNumber)));
+				}
+				else if (statement == "sphere")
+				{
+					rtVec3f center = readVector(sstream);
+					float radius;
+					string material;
+					sstream >> radius >> material;
+					checkRead(sstream, statement, lineNumber);
+
+					description.scene->addObject(new rtSphereObject(center, radius, findMaterial(materials, material, lineNumber)));
+				}
+				else if (statement == "plane")
+				{
+					rtVec3f point = readVector(sstream);
+					rtVec3f normal = readVector(sstream);
+					string material;
+					sstream >> material;
+					checkRead(sstream, statement, lineNumber);
+
+					description.scene->addObject(new rtPlaneObject(point, normal, findMaterial(materials, material, lineNumber)));
+				}
+				else if (statement == "light")
+				{
+					rtVec3f position = readVector(sstream);
+					rtColorf ambient = readColor(sstream);
+					rtColorf diffuse = readColor(sstream);
+					rtColorf specular = readColor(sstream);
+					checkRead(sstream, statement, lineNumber);
+					float incidentIntensity = readOptional(sstream, 1.0f);
+					float ambientIntensity = readOptional(sstream, 1.0f);
+
+					description.scene->addLight(new rtLight(position, ambient, diffuse, specular, incidentIntensity, ambientIntensity));
+				}
+				else if (statement == "camera")
+				{
+					description.camPosition = readVector(sstream);
+					description.camLookAt = readVector(sstream);
+					description.camUp = readVector(sstream);
+					checkRead(sstream, statement, lineNumber);
+					description.fov = readOptional(sstream, description.fov);
+				}
+				else if (statement == "camera-key")
+				{
+					rtCameraKey key;
+					sstream >> key.frame;
+					key.position = readVector(sstream);
+					key.lookAt = readVector(sstream);
+					key.up = readVector(sstream);
+					checkRead(sstream, statement, lineNumber);
+					key.fov = readOptional(sstream, 90.0f);
+
+					description.cameraKeys.push_back(key);
+				}
+				else
+				{
+					throw "Line " + to_string(lineNumber) + ": Unknown statement '" + statement + "'";
+				}
+			}
+
+			sceneFile.close();
+
+			return description;
+		}
+	};
+}
@@ -0,0 +1,241 @@
+#include "rtAnimationJob.h"
+
+namespace rtGraphics
+{
+	///Constructors
+	rtAnimationJob::rtAnimationJob(sceneFactory makeScene, int width, int height, int firstFrame, int lastFrame, string outputPattern) :
+		makeScene(makeScene), width(width), height(height), firstFrame(firstFrame), lastFrame(lastFrame), outputPattern(outputPattern) {}
+
+	///Keyframe methods
+	void rtAnimationJob::addCameraKey(float frame, const rtVec3f& position, const rtVec3f& lookAtPoint, const rtVec3f& upVector, float fov)
+	{
+		positionTrack.addKey(frame, position);
+		lookAtTrack.addKey(frame, lookAtPoint);
+		upTrack.addKey(frame, upVector);
+		fovTrack.addKey(frame, fov);
+	}
+
+	void rtAnimationJob::setCameraInterpolation(interpolation Interpolation)
+	{
+		positionTrack.setInterpolation(Interpolation);
+		lookAtTrack.setInterpolation(Interpolation);
+		upTrack.setInterpolation(Interpolation);
+		fovTrack.setInterpolation(Interpolation);
+	}
+
+	///Render methods
+	//Render every frame and wait for the last one to be written
+	void rtAnimationJob::run()
+	{
+		if (firstFrame < 0 || lastFrame < firstFrame)
+			throw "Invalid frame range: " + to_string(firstFrame) + " to " + to_string(lastFrame);
+
+		//Find the writer first, so an unsupported format fails before rendering
+		unique_ptr<rtImageWriter> writer = rtImageWriter::forFile(getFramePath(firstFrame));
+
+		int numSlots = min(getConcurrentFrames(), lastFrame - firstFrame + 1);
+		int numCores = rtRenderThreadPool::getDefaultThreads();
+		vector<unique_ptr<rtCam>> cameras;
+
+		//Set up every frame slot before rendering starts, so a scene that fails to build stops the job before any frame is written
+		for (int slot = 0; slot < numSlots; slot++)
+		{
+			//Split the cores as evenly as possible between the slots
+			int slotThreads = max(numCores / numSlots + ((slot < numCores % numSlots) ? 1 : 0), 1);
+
+			cameras.push_back(make_unique<rtCam>(width, height, rtVec3f::zero, rtVec3f::forward, rtVec3f::up, slotThreads));
+			rtCam& camera = *cameras.back();
+			camera.setScene(makeScene());
+			camera.setMaxBounces(maxBounces);
+			camera.setMaxSamples(maxSamples);
+			camera.setTileSize(tileSize);
+			camera.setRenderPipeline(pipeline);
+			camera.setToneMapping(ToneMapping);
+			camera.setExposure(exposure);
+			camera.setDenoisePasses(denoisePasses);
+
+			for (int aovIndex = 0; aovIndex < aovTypes.size(); aovIndex++)
+				camera.enableAOV(aovTypes[aovIndex]);
+		}
+
+		nextFrame = firstFrame;
+		writeQueue.clear();
+		rendersFinished = false;
+		writeError.clear();
+
+		thread writerThread(&rtAnimationJob::writeFrames, this, writer.get());
+		vector<thread> slotThreads;
+
+		for (int slot = 0; slot < numSlots; slot++)
+			slotThreads.emplace_back(&rtAnimationJob::renderFrames, this, cameras[slot].get());
+
+		for (int slot = 0; slot < numSlots; slot++)
+			slotThreads[slot].join();
+
+		//Let the writer finish the queue and stop
+		{
+			lock_guard<mutex> lock(queueLock);
+			rendersFinished = true;
+		}
+
+		frameQueued.notify_all();
+		writerThread.join();
+
+		if (!writeError.empty())
+			throw writeError;
+	}
+
+	//The file the given frame is written to
+	string rtAnimationJob::getFramePath(int frame) const
+	{
+		string number = to_string(frame);
+		size_t lastHash = outputPattern.find_last_of('#');
+
+		//Without a run of '#', a four digit frame number goes before the extension
+		if (lastHash == string::npos)
+		{
+			string extension = rtImageWriter::getExtension(outputPattern);
+			size_t numberStart = extension.empty() ? outputPattern.size() : outputPattern.size() - extension.size() - 1;
+
+			if (number.size() < 4)
+				number.insert(0, 4 - number.size(), '0');
+
+			return outputPattern.substr(0, numberStart) + "_" + number + outputPattern.substr(numberStart);
+		}
+
+		size_t beforeHashes = outputPattern.find_last_not_of('#', lastHash);
+		size_t firstHash = (beforeHashes == string::npos) ? 0 : beforeHashes + 1;
+		size_t digits = lastHash - firstHash + 1;
+
+		//The number is padded to the length of the run, and longer numbers are written in full
+		if (number.size() < digits)
+			number.insert(0, digits - number.size(), '0');
+
+		return outputPattern.substr(0, firstHash) + number + outputPattern.substr(lastHash + 1);
+	}
+
+	//The number of frames rendered at a time
+	int rtAnimationJob::getConcurrentFrames() const
+	{
+		if (concurrentFrames > 0)
+			return concurrentFrames;
+
+		int numCores = rtRenderThreadPool::getDefaultThreads();
+		int numTiles = ((width + tileSize - 1) / tileSize) * ((height + tileSize - 1) / tileSize);
+		//Give each frame only as many threads as its tiles keep busy, and the rest of the cores to other frames
+		int frameThreads = min(max(numTiles / minTilesPerThread, 1), numCores);
+
+		return numCores / frameThreads;
+	}
+
+	//Render frames on the camera until there are none left
+	void rtAnimationJob::renderFrames(rtCam* camera)
+	{
+		while (true)
+		{
+			int frame = nextFrame++;
+
+			if (frame > lastFrame)
+				return;
+
+			//Stop rendering once a frame fails to write
+			{
+				lock_guard<mutex> lock(queueLock);
+
+				if (!writeError.empty())
+					return;
+			}
+
+			applyFrame(*camera, *camera->getScene(), frame);
+			camera->render(true);
+
+			rtFrameImage image;
+			image.frame = frame;
+			image.pixels = camera->getLatestFrame();
+			image.radiance = camera->getRadiance();
+			image.aovs = camera->getAOVs();
+			queueFrame(image);
+		}
+	}
+
+	//Set the camera and scene to their values at the given frame
+	void rtAnimationJob::applyFrame(rtCam& camera, rtScene& scene, int frame)
+	{
+		//Every tracked value is set for every frame, since the slot's last frame could be any earlier or later frame
+		for (int track = 0; track < objectTracks.size(); track++)
+			objectTracks[track](scene, frame);
+
+		if (!positionTrack.isEmpty())
+		{
+			//The position is set before the orientation, which calculates the view axes from it
+			camera.setPosition(positionTrack.valueAt(frame));
+			camera.setOrientation(lookAtTrack.valueAt(frame), upTrack.valueAt(frame));
+			camera.setFov(fovTrack.valueAt(frame));
+		}
+	}
+
+	//Add a completed frame to the write queue, waiting while the queue is full
+	void rtAnimationJob::queueFrame(rtFrameImage& image)
+	{
+		unique_lock<mutex> lock(queueLock);
+		frameWritten.wait(lock, [&] { return (int)writeQueue.size() < maxQueuedFrames || !writeError.empty(); });
+
+		//Frames after a failed write are dropped
+		if (!writeError.empty())
+			return;
+
+		writeQueue.push_back(move(image));
+		frameQueued.notify_one();
+	}
+
+	//Write the queued frames until every frame slot has finished
+	void rtAnimationJob::writeFrames(rtImageWriter* writer)
+	{
+		//The AOVs are written as float images
+		rtEXRWriter aovWriter;
+
+		while (true)
+		{
+			rtFrameImage image;
+
+			{
+				unique_lock<mutex> lock(queueLock);
+				frameQueued.wait(lock, [&] { return !writeQueue.empty() || rendersFinished; });
+
+				//The queue is only empty here once every frame slot has finished
+				if (writeQueue.empty())
+					return;
+
+				image = move(writeQueue.front());
+				writeQueue.pop_front();
+			}
+
+			//Make room for a frame slot waiting on a full queue
+			frameWritten.notify_all();
+
+			try
+			{
+				string framePath = getFramePath(image.frame);
+				writer->write(framePath, image.pixels, image.radiance);
+
+				for (int aovIndex = 0; aovIndex < aovTypes.size(); aovIndex++)
+					aovWriter.write(rtAOVBuffers::getPath(framePath, aovTypes[aovIndex]), image.pixels, image.aovs.getBuffer(aovTypes[aovIndex]));
+			}
+			catch (const string& error)
+			{
+				//Keep the error for run to throw, and wake the frame slots so they stop
+				{
+					lock_guard<mutex> lock(queueLock);
+					writeError = error;
+					writeQueue.clear();
+				}
+
+				frameWritten.notify_all();
+				return;
+			}
+
+			if (onFrameWritten)
+				onFrameWritten(image.frame);
+		}
+	}
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+#include "ofPixels.h"
+#include "rtCam.h"
+#include "Data Classes/rtScene.h"
+#include "Data Classes/rtKeyframeTrack.h"
+#include "Data Classes/rtAOVBuffers.h"
+#include "Utilities/rtImageWriter.h"
+
+using namespace std;
+
+namespace rtGraphics
+{
+	/*
+	 * Renders a range of frames of an animation, writing each frame to its own image file
+	 * The camera and any object parameters are keyframed. Frames are handed out to frame slots, each a headless camera with its own
+	 * copy of the scene and a share of the cores, whose threads split the tiles of the frame between them. Frames with too few tiles
+	 * to keep every core busy run several at a time, and completed frames are written on a separate thread while the next ones render.
+	 */
+	class rtAnimationJob
+	{
+	public:
+		//Builds a copy of the scene. Each frame slot animates its own copy, so the frames rendering at the same time don't interfere.
+		typedef function<shared_ptr<rtScene>()> sceneFactory;
+		//Called on the writing thread with the number of each frame once it is written
+		typedef function<void(int frame)> frameCallback;
+
+	private:
+		//A completed frame waiting to be written
+		struct rtFrameImage
+		{
+			int frame;
+			ofPixels pixels;
+			ofFloatPixels radiance;
+			rtAOVBuffers aovs;
+		};
+
+		//Frames need at least this many tiles per thread to keep the threads busy until the end of the frame
+		static const int minTilesPerThread = 8;
+		//The most completed frames held in memory waiting to be written. The frame slots wait for the writer beyond this.
+		static const int maxQueuedFrames = 4;
+
+		sceneFactory makeScene;
+		int width, height;
+		int firstFrame, lastFrame;
+		//The output path, where a run of '#' is replaced by the zero padded frame number
+		string outputPattern;
+		frameCallback onFrameWritten;
+
+		//The camera tracks. Without keys the camera keeps the default view.
+		rtKeyframeTrack<rtVec3f> positionTrack, lookAtTrack, upTrack;
+		rtKeyframeTrack<float> fovTrack;
+		//The object tracks, each setting its value at a frame on a copy of the scene
+		vector<function<void(rtScene&, float)>> objectTracks;
+
+		//The render settings of every frame
+		int maxBounces = 3;
+		int maxSamples = 1;
+		int tileSize = 32;
+		renderPipeline pipeline = renderPipeline::recursive;
+		toneMapping ToneMapping = toneMapping::none;
+		float exposure = 1.0f;
+		int denoisePasses = 0;
+		//The number of frames rendered at a time, or zero to choose it from the frame size
+		int concurrentFrames = 0;
+		//The AOVs written next to each frame
+		vector<aovType> aovTypes;
+
+		//The next frame to hand out to a frame slot
+		atomic<int> nextFrame;
+		//The completed frames waiting to be written, and the signals between the frame slots and the writing thread
+		mutex queueLock;
+		condition_variable frameQueued, frameWritten;
+		deque<rtFrameImage> writeQueue;
+		bool rendersFinished;
+		//The first error writing a frame. Once set, no more frames are started.
+		string writeError;
+
+		//Render frames on the camera until there are none left
+		void renderFrames(rtCam* camera);
+		//Set the camera and scene to their values at the given frame
+		void applyFrame(rtCam& camera, rtScene& scene, int frame);
+		//Add a completed frame to the write queue, waiting while the queue is full
+		void queueFrame(rtFrameImage& image);
+		//Write the queued frames until every frame slot has finished
+		void writeFrames(rtImageWriter* writer);
+
+	public:
+		///Constructors
+		//The frames from first to last, both included, are rendered at the given resolution to files named by the output pattern
+		rtAnimationJob(sceneFactory makeScene, int width, int height, int firstFrame, int lastFrame, string outputPattern);
+
+		///Keyframe methods
+		//Set the camera view at the given frame
+		void addCameraKey(float frame, const rtVec3f& position, const rtVec3f& lookAtPoint, const rtVec3f& upVector, float fov = 90.0f);
+		void setCameraInterpolation(interpolation Interpolation);
+		/*
+		 * Animate a parameter of the scene. Before each frame the setter is given the scene copy of the frame slot and the value of the track.
+		 * Setters that move the vertices of a mesh must call updateMesh on it.
+		 */
+		template <typename T>
+		void addObjectTrack(const rtKeyframeTrack<T>& track, function<void(rtScene&, const T&)> setter);
+
+		///Render methods
+		//Render every frame and wait for the last one to be written. Throws a string describing the problem if a frame can't be written.
+		void run();
+		//The file the given frame is written to
+		string getFramePath(int frame) const;
+		//The number of frames rendered at a time. Small frames share the cores with other frames, large frames get every core.
+		int getConcurrentFrames() const;
+
+		///Setters
+		void setMaxBounces(int maxBounces);
+		void setMaxSamples(int maxSamples);
+		void setTileSize(int tileSize);
+		void setRenderPipeline(renderPipeline pipeline);
+		void setToneMapping(toneMapping ToneMapping);
+		void setExposure(float exposure);
+		//Denoise each frame with the given number of filter passes before it is written, or zero to leave it as rendered
+		void setDenoisePasses(int denoisePasses);
+		//Render the given number of frames at a time, or zero to choose it from the frame size
+		void setConcurrentFrames(int concurrentFrames);
+		//Write the given output of each frame next to the frame's image, to the file named by rtAOVBuffers::getPath
+		void enableAOV(aovType type);
+		void setFrameCallback(frameCallback onFrameWritten);
+	};
+
+	///In-line method definitions
+	template <typename T>
+	inline void rtAnimationJob::addObjectTrack(const rtKeyframeTrack<T>& track, function<void(rtScene&, const T&)> setter)
+	{
+		objectTracks.push_back([track, setter](rtScene& scene, float frame) { setter(scene, track.valueAt(frame)); });
+	}
+
+	//Setters
+	inline void rtAnimationJob::setMaxBounces(int maxBounces) { this->maxBounces = maxBounces; }
+	inline void rtAnimationJob::setMaxSamples(int maxSamples) { this->maxSamples = maxSamples; }
+	inline void rtAnimationJob::setTileSize(int tileSize) { this->tileSize = max(tileSize, 1); }
+	inline void rtAnimationJob::setRenderPipeline(renderPipeline pipeline) { this->pipeline = pipeline; }
+	inline void rtAnimationJob::setToneMapping(toneMapping ToneMapping) { this->ToneMapping = ToneMapping; }
+	inline void rtAnimationJob::setExposure(float exposure) { this->exposure = exposure; }
+	inline void rtAnimationJob::setDenoisePasses(int denoisePasses) { this->denoisePasses = max(denoisePasses, 0); }
+	inline void rtAnimationJob::setConcurrentFrames(int concurrentFrames) { this->concurrentFrames = max(concurrentFrames, 0); }
+	inline void rtAnimationJob::setFrameCallback(frameCallback onFrameWritten) { this->onFrameWritten = onFrameWritten; }
+	inline void rtAnimationJob::enableAOV(aovType type) { aovTypes.push_back(type); }
+}
@@ -16,12 +16,35 @@ namespace rtGraphics
 			enable();
 	}
 
+	rtCam::rtCam(int width, int height, const rtVec3f& position, const rtVec3f& lookAtPoint, const rtVec3f& appoxUpVector, int numThreads) :
+		position(position), enabled(false), headless(true), renderer(numThreads)
+	{
+		setOrientation(lookAtPoint, appoxUpVector);
+		displayWidth = width;
+		displayHeight = height;
+		createFrameBuffer(width, height);
+	}
+
 	///In-line method definitions
 	//Event Lister
 	void rtCam::draw(ofEventArgs& event)
 	{
-		//Start the render and wait for it to complete
-		render(true);
+		//An idle camera keeps showing the latest frame instead of rendering the same image again
+		//With a single buffer, start the render and wait for it to complete
+		if (buffering == frameBuffering::single)
+		{
+			if (frameDue())
+				render(true);
+		}
+		//Otherwise start the next frame as soon as the previous one completes, and keep showing the latest completed frame meanwhile
+		else
+		{
+			pollFrame();
+
+			if (!frameInFlight && frameDue())
+				render(false);
+		}
+
 		//Draw the rendered image to the screen
 		draw();
 	}
@@ -33,30 +56,139 @@ namespace rtGraphics
 	float rtCam::getFarClip() const { return farClip; }
 	int rtCam::getMaxBounces() const { return maxBounces; }
 	int rtCam::getFps() const { return fps; }
+	float rtCam::getFrameTime() const { return frameTime; }
+	float rtCam::getTargetFrameTime() const { return targetFrameTime; }
+	float rtCam::getRenderScale() const { return renderScale; }
+	float rtCam::getMinRenderScale() const { return minRenderScale; }
 	renderMode rtCam::getRenderMode() const { return RenderMode; }
+	rayPacketSize rtCam::getPacketSize() const { return packetSize; }
+	renderPipeline rtCam::getRenderPipeline() const { return pipeline; }
+	int rtCam::getTileSize() const { return tileSize; }
+	frameBuffering rtCam::getFrameBuffering() const { return buffering; }
+	bool rtCam::isProgressive() const { return progressive; }
+	float rtCam::getRefineThreshold() const { return refineThreshold; }
+	int rtCam::getMaxSamples() const { return maxSamples; }
+	float rtCam::getAntiAliasThreshold() const { return antiAliasThreshold; }
+	toneMapping rtCam::getToneMapping() const { return ToneMapping; }
+	float rtCam::getExposure() const { return exposure; }
+	int rtCam::getDenoisePasses() const { return denoiser.getPasses(); }
+	bool rtCam::isReprojecting() const { return reprojection; }
+	bool rtCam::isTemporalAntiAliasing() const { return reprojectionCache.isTemporalAntiAliasing(); }
+	bool rtCam::isCachingHits() const { return hitCaching; }
 	shared_ptr<rtScene> rtCam::getScene() const { return scene; }
-	ofPixels* rtCam::getBufferPixels() { return bufferPixels; }
+	ofPixels* rtCam::getBufferPixels() { return &frameBuffers[latestIndex]->getPixels(); }
+	const ofPixels& rtCam::getLatestFrame() const { return frameBuffers[latestIndex]->getPixels(); }
+	unsigned long rtCam::getFrameNumber() const { return frameNumber; }
+	const ofFloatPixels& rtCam::getRadiance() const { return radiance; }
+	const rtAOVBuffers& rtCam::getAOVs() const { return aovs; }
 	rtVec3f rtCam::getPosition() const { return position; }
 	rtVec3f rtCam::getLookVector() const { return n; }
 	rtVec3f rtCam::getUpVector() const { return V; }
 	rtVec3f rtCam::getPerpVector() const { return u; }
 
-	//Setters
-	void rtCam::setFov(float fov) { this->fov = fov; }
-	void rtCam::setNearClip(float nearClip) { this->nearClip = nearClip; }
-	void rtCam::setFarClip(float farClip) { this->farClip = farClip; }
-	void rtCam::setMaxBounces(int maxBounces) { this->maxBounces = maxBounces; }
-	void rtCam::setRenderMode(renderMode RenderMode) { this->RenderMode = RenderMode; }
-	void rtCam::setScene(const shared_ptr<rtScene> scene) { this->scene = scene; }
-	void rtCam::setPosition(const rtVec3f& position) { this->position = position; }
-	void rtCam::setLookAtPoint(const rtVec3f& lookAtPoint) { pref = lookAtPoint; calcAxes(); }
-	void rtCam::setUpVector(const rtVec3f& appoxUpVector) { V = appoxUpVector; calcAxes(); }
+	//Setters. Settings that change the image restart the frame in flight.
+	void rtCam::setFov(float fov) { this->fov = fov; restartRender(); }
+	void rtCam::setNearClip(float nearClip) { this->nearClip = nearClip; restartRender(); }
+	void rtCam::setFarClip(float farClip) { this->farClip = farClip; restartRender(); }
+	void rtCam::setMaxBounces(int maxBounces) { this->maxBounces = maxBounces; clearReprojection(); }
+	void rtCam::setRenderMode(renderMode RenderMode) { this->RenderMode = RenderMode; clearReprojection(); }
+	void rtCam::setPacketSize(rayPacketSize packetSize) { this->packetSize = packetSize; }
+	void rtCam::setRenderPipeline(renderPipeline pipeline) { this->pipeline = pipeline; }
+	//Tiles are at least one pixel wide
+	void rtCam::setTileSize(int tileSize) { this->tileSize = max(tileSize, 1); }
+	void rtCam::setProgressive(bool progressive) { this->progressive = progressive; restartRender(); }
+	void rtCam::setRefineThreshold(float refineThreshold) { this->refineThreshold = refineThreshold; restartRender(); }
+	//Every pixel takes at least one sample
+	void rtCam::setMaxSamples(int maxSamples) { this->maxSamples = max(maxSamples, 1); restartRender(); }
+	void rtCam::setAntiAliasThreshold(float antiAliasThreshold) { this->antiAliasThreshold = antiAliasThreshold; restartRender(); }
+	void rtCam::setToneMapping(toneMapping ToneMapping) { this->ToneMapping = ToneMapping; restartRender(); }
+	//Negative exposures are treated as black
+	void rtCam::setExposure(float exposure) { this->exposure = max(exposure, 0.0f); restartRender(); }
+	void rtCam::setScene(const shared_ptr<rtScene> scene) { this->scene = scene; clearReprojection(); }
+	void rtCam::setReprojection(bool reprojection) { this->reprojection = reprojection; restartRender(); }
+	void rtCam::setHitCaching(bool hitCaching) { this->hitCaching = hitCaching; restartRender(); }
+	void rtCam::setPosition(const rtVec3f& position) { this->position = position; restartRender(); }
+	void rtCam::setLookAtPoint(const rtVec3f& lookAtPoint) { pref = lookAtPoint; calcAxes(); restartRender(); }
+	void rtCam::setUpVector(const rtVec3f& appoxUpVector) { V = appoxUpVector; calcAxes(); restartRender(); }
 
 	void rtCam::setOrientation(const rtVec3f& lookAtPoint, const rtVec3f& appoxUpVector)
 	{
 		pref = lookAtPoint;
 		V = appoxUpVector;
 		calcAxes();
+		restartRender();
+	}
+
+	void rtCam::setFrameBuffering(frameBuffering buffering)
+	{
+		//Finish the frame in flight before its buffer is replaced
+		finishFrame();
+		this->buffering = buffering;
+		createFrameBuffer(bufferWidth, bufferHeight);
+	}
+
+	void rtCam::enableAOV(aovType type, bool enable)
+	{
+		//Finish the frame in flight before the buffers are replaced
+		finishFrame();
+		aovs.enable(type, enable);
+		aovs.allocate(bufferWidth, bufferHeight);
+		//The new buffer has none of the pixels of the latest frame
+		settingsChanged = true;
+	}
+
+	void rtCam::setDenoisePasses(int passes)
+	{
+		//Finish the frame in flight before the buffers it writes are replaced
+		finishFrame();
+		denoiser.setPasses(passes);
+		settingsChanged = true;
+
+		if (passes > 0)
+		{
+			aovs.enable(aovType::normal);
+			aovs.enable(aovType::depth);
+			aovs.enable(aovType::albedo);
+			aovs.allocate(bufferWidth, bufferHeight);
+		}
+	}
+
+	void rtCam::setTemporalAntiAliasing(bool temporalAntiAliasing)
+	{
+		//Drop the frame in flight before the cache it renders through changes
+		restartRender();
+		reprojectionCache.setTemporalAntiAliasing(temporalAntiAliasing);
+	}
+
+	void rtCam::clearReprojection()
+	{
+		//The frame in flight reuses the old colors, so it is started again
+		restartRender();
+		reprojectionCache.clear();
+	}
+
+	void rtCam::setResolution(int width, int height)
+	{
+		//Finish the frame in flight before its buffer is replaced
+		finishFrame();
+		displayWidth = width;
+		displayHeight = height;
+		createFrameBuffer(renderSize(width), renderSize(height));
+	}
+
+	void rtCam::setTargetFrameTime(float targetFrameTime)
+	{
+		this->targetFrameTime = max(targetFrameTime, 0.0f);
+		//Start estimating the frame time again, and go back to the display resolution until the estimate says otherwise
+		displayFrameTime = 0.0f;
+		setRenderScale(1.0f);
+	}
+
+	//The scale can't reach zero, since the frames need at least a pixel
+	void rtCam::setMinRenderScale(float minRenderScale)
+	{
+		this->minRenderScale = fminf(fmaxf(minRenderScale, renderScaleStep), 1.0f);
+		setRenderScale(fmaxf(renderScale, this->minRenderScale));
 	}
 
 	//Camera Methods
@@ -76,24 +208,218 @@ namespace rtGraphics
 	//Render the scene
 	void rtCam::render(bool waitForRender)
 	{
-		renderer.render(RenderMode, scene, position, u, v, n, fov, nearClip, farClip, maxBounces, bufferPixels);
+		//Finish the frame in flight first, so each frame starts with every thread free
+		finishFrame();
+
+		//Follow the render scale the frame time target settled on
+		int renderWidth = renderSize(displayWidth);
+		int renderHeight = renderSize(displayHeight);
+
+		if (renderWidth != bufferWidth || renderHeight != bufferHeight)
+			resizeFrameBuffer(renderWidth, renderHeight);
+
+		//Render into the buffer after the latest frame, which is neither the latest frame nor, with triple buffering, the one before it
+		renderIndex = (latestIndex + 1) % frameBuffers.size();
+		frameCached = reprojection && !progressive;
+		bool sceneChanged = !scene || sceneChanges.hasChanged(*scene);
+		stillFrames = (settingsChanged || sceneChanged) ? 0 : stillFrames + 1;
+
+		//A still camera reuses every pixel it doesn't refresh, so the edits would only show in the refreshed share before the frames stop being due
+		if (sceneChanged)
+			reprojectionCache.clear();
+
+		//Only the tiles the changes can reach are rendered, on top of the latest frame. The radiance and AOV buffers already hold it.
+		vector<rtTile> dirtyRegions;
+		bool partial = findDirtyRegions(dirtyRegions);
+
+		if (partial && renderIndex != latestIndex)
+			frameBuffers[renderIndex]->getPixels() = frameBuffers[latestIndex]->getPixels();
+
+		//The hits stay where they are until the camera or an object moves, so only changes to lights and materials are reshaded
+		frameHitsKept = hitCaching && !progressive && !reprojection;
+		bool reshade = frameHitsKept && !settingsChanged && scene && !sceneChanges.objectsMoved(*scene);
+
+		if (frameHitsKept)
+			hitCache.setFrame(bufferWidth, bufferHeight, reshade, !partial);
+		else
+			hitCache.clear();
+
+		if (scene)
+			sceneChanges.record(*scene);
+
+		settingsChanged = false;
+		framePartial = partial;
+		frameStart = chrono::steady_clock::now();
+
+		rtFrameSettings settings = frameSettings();
+		settings.radiancePixels = &radiance;
+		settings.bufferPixels = &frameBuffers[renderIndex]->getPixels();
+		settings.aovBuffers = aovs.anyEnabled() ? &aovs : nullptr;
+		settings.cache = frameCached ? &reprojectionCache : nullptr;
+		settings.hitCache = frameHitsKept ? &hitCache : nullptr;
+		settings.regions = partial ? &dirtyRegions : nullptr;
+		frameDenoised = denoiser.getPasses() > 0;
+		settings.denoiser = frameDenoised ? &denoiser : nullptr;
+		settings.denoisedPixels = &denoisedRadiance;
+		renderer.render(settings);
+		frameInFlight = true;
+		restartPending = false;
 
 		if (waitForRender)
+			finishFrame();
+	}
+
+	//Render a frame of the given size a band of rows at a time, writing each band to the file once it completes
+	void rtCam::renderToFile(string filePath, int width, int height, int bandRows)
+	{
+		unique_ptr<rtBandWriter> writer = rtBandWriter::forFile(filePath);
+
+		if (!writer)
+			throw "Cannot write images with extension '" + rtImageWriter::getExtension(filePath) + "' a band at a time";
+
+		writer->open(filePath, width, height);
+		//The bands share the renderer with the frame buffers
+		finishFrame();
+
+		//With anti-aliasing, each band also renders the neighbouring row of the bands next to it, so the edges between bands are found
+		int overlap = (maxSamples > 1) ? 1 : 0;
+		bandRows = max(bandRows, 1);
+		ofPixels bandPixels;
+		ofFloatPixels bandRadiance;
+
+		//Progressive refinement only helps frames that are shown as they render. The AOVs and caches are only kept for whole frames.
+		rtFrameSettings settings = frameSettings();
+		settings.progressive = false;
+		settings.radiancePixels = &bandRadiance;
+		settings.bufferPixels = &bandPixels;
+		settings.frameHeight = height;
+
+		for (int bandStart = 0; bandStart < height; bandStart += bandRows)
+		{
+			int bandEnd = min(bandStart + bandRows, height);
+			int firstRow = max(bandStart - overlap, 0);
+			int lastRow = min(bandEnd + overlap, height);
+
+			bandPixels.allocate(width, lastRow - firstRow, OF_PIXELS_RGB);
+			bandRadiance.allocate(width, lastRow - firstRow, OF_PIXELS_RGB);
+
+			settings.firstRow = firstRow;
+			renderer.render(settings);
 			renderer.waitForRender();
+
+			writer->writeBand(bandStart, bandEnd - bandStart, bandPixels, bandRadiance, bandStart - firstRow);
+		}
+
+		writer->close();
+	}
+
+	//Wait for the frame in flight to complete
+	void rtCam::finishFrame()
+	{
+		if (!frameInFlight)
+			return;
+
+		renderer.waitForRender();
+		completeFrame();
+	}
+
+	//Check if the frame in flight has completed without waiting for it
+	bool rtCam::pollFrame()
+	{
+		if (!frameInFlight || renderer.isRendering())
+			return false;
+
+		completeFrame();
+		return true;
+	}
+
+	//Stop the frame in flight after the tiles being rendered
+	void rtCam::cancelRender()
+	{
+		if (!frameInFlight)
+			return;
+
+		renderer.cancelRender();
+		frameInFlight = false;
+		//The cancelled frame is left unfinished, so the next frame can't build on it
+		sceneChanges.clear();
+		hitCache.clear();
+	}
+
+	//Drop the frame in flight so a frame with the new settings can start right away, instead of after the old frame finishes
+	void rtCam::restartRender()
+	{
+		settingsChanged = true;
+
+		if (!frameInFlight)
+			return;
+
+		cancelRender();
+		//Starting the new frame at the next draw lets several settings change without restarting for each one
+		restartPending = true;
 	}
 
-	//Draw the rendered image
+	bool rtCam::isRendering()
+	{
+		return renderer.isRendering();
+	}
+
+	//Draw the latest rendered image
 	void rtCam::draw()
 	{
-		frameBuffer->update();
-		frameBuffer->draw(0, 0);
-		updateFps();
+		if (restartPending)
+			render(false);
+
+		pollFrame();
+
+		//A single buffer is uploaded every time while a frame renders in the background, so it is shown as it progresses.
+		//Otherwise each completed frame is only uploaded once.
+		if ((buffering == frameBuffering::single && frameInFlight) || !latestUploaded)
+		{
+			frameBuffers[latestIndex]->update();
+			latestUploaded = true;
+		}
+
+		//Frames rendered below the display resolution are stretched to it
+		frameBuffers[latestIndex]->draw(0, 0, displayWidth, displayHeight);
 	}
 
-	//Reset the image buffer to black
+	//Reset the image buffers to black
 	void rtCam::clearBuffer()
 	{
-		frameBuffer->setColor(ofColor::black);
+		finishFrame();
+
+		for (int bufferIndex = 0; bufferIndex < frameBuffers.size(); bufferIndex++)
+			frameBuffers[bufferIndex]->setColor(ofColor::black);
+
+		latestUploaded = false;
+		settingsChanged = true;
+	}
+
+	//The scene, camera and render settings of the next frame, without any buffers
+	rtFrameSettings rtCam::frameSettings() const
+	{
+		rtFrameSettings settings;
+		settings.scene = scene;
+		settings.camPos = position;
+		settings.u = u;
+		settings.v = v;
+		settings.n = n;
+		settings.hFov = fov;
+		settings.nearClip = nearClip;
+		settings.farClip = farClip;
+		settings.RenderMode = RenderMode;
+		settings.maxBounces = maxBounces;
+		settings.packetSize = packetSize;
+		settings.pipeline = pipeline;
+		settings.tileSize = tileSize;
+		settings.progressive = progressive;
+		settings.refineThreshold = refineThreshold;
+		settings.maxSamples = maxSamples;
+		settings.antiAliasThreshold = antiAliasThreshold;
+		settings.ToneMapping = ToneMapping;
+		settings.exposure = exposure;
+		return settings;
 	}
 
 	//Calculates the axes of the viewing coordinates
@@ -110,6 +436,113 @@ namespace rtGraphics
 		v.normalize();
 	}
 
+	//Returns true if the scene or settings changed since the last frame started
+	bool rtCam::frameDue()
+	{
+		if (!scene)
+			return false;
+
+		if (settingsChanged || sceneChanges.hasChanged(*scene))
+			return true;
+
+		//Temporal anti-aliasing keeps blending jittered frames of a still view until each pixel holds the most samples
+		return reprojection && !progressive && reprojectionCache.isTemporalAntiAliasing() && stillFrames < reprojectionCache.getMaxTemporalSamples();
+	}
+
+	//Find the rectangles of pixels that the changes to the scene since the last frame started can affect
+	bool rtCam::findDirtyRegions(vector<rtTile>& regions)
+	{
+		regions.clear();
+
+		//Progressive frames interpolate from pixels outside the tiles, and reprojection and denoising carry colors from one pixel to others
+		if (settingsChanged || !scene || progressive || reprojection || denoiser.getPasses() > 0)
+			return false;
+
+		vector<rtAABB> visibleBounds, shadowBounds;
+
+		if (!sceneChanges.findChanges(*scene, maxBounces > 0, visibleBounds, shadowBounds))
+			return false;
+
+		rtVec3f firstPoint, hStep, vStep;
+		rtRenderThreadPool::calcGrid(position, u, v, n, fov, nearClip, bufferWidth, bufferHeight, firstPoint, hStep, vStep);
+		lightSet lights = scene->getLights();
+
+		//Each visible box is one region, and each moved box adds a region for its shadow from each light
+		int numRegions = visibleBounds.size() + shadowBounds.size() * lights->size();
+
+		for (int regionIndex = 0; regionIndex < numRegions; regionIndex++)
+		{
+			bool shadow = regionIndex >= visibleBounds.size();
+			int shadowIndex = regionIndex - visibleBounds.size();
+			const rtAABB& bounds = shadow ? shadowBounds[shadowIndex / lights->size()] : visibleBounds[regionIndex];
+			rtVec3f minCorner = bounds.getMin();
+			rtVec3f maxCorner = bounds.getMax();
+			rtVec3f lightPosition = shadow ? lights->at(shadowIndex % lights->size())->getPosition() : rtVec3f::zero;
+
+			//A light inside the box can be shadowed in every direction
+			if (shadow && lightPosition.getX() >= minCorner.getX() && lightPosition.getX() <= maxCorner.getX() &&
+				lightPosition.getY() >= minCorner.getY() && lightPosition.getY() <= maxCorner.getY() &&
+				lightPosition.getZ() >= minCorner.getZ() && lightPosition.getZ() <= maxCorner.getZ())
+				return false;
+
+			float minRow = INFINITY, maxRow = -INFINITY, minCol = INFINITY, maxCol = -INFINITY;
+
+			for (int cornerIndex = 0; cornerIndex < 8; cornerIndex++)
+			{
+				rtVec3f corner((cornerIndex & 1) ? maxCorner.getX() : minCorner.getX(), (cornerIndex & 2) ? maxCorner.getY() : minCorner.getY(),
+					(cornerIndex & 4) ? maxCorner.getZ() : minCorner.getZ());
+				float row, col;
+
+				//Boxes reaching behind the camera can cover pixels on any side of the frame
+				if (!projectToGrid(corner - position, firstPoint, hStep, vStep, row, col))
+					return false;
+
+				minRow = fminf(minRow, row); maxRow = fmaxf(maxRow, row);
+				minCol = fminf(minCol, col); maxCol = fmaxf(maxCol, col);
+
+				//The shadow of the box spreads from its corners away from the light, towards the points the directions vanish at
+				if (shadow)
+				{
+					if (!projectToGrid(corner - lightPosition, firstPoint, hStep, vStep, row, col))
+						return false;
+
+					minRow = fminf(minRow, row); maxRow = fmaxf(maxRow, row);
+					minCol = fminf(minCol, col); maxCol = fmaxf(maxCol, col);
+				}
+			}
+
+			//Pad the rectangle by a pixel for the rays anti-aliasing takes between grid points and the edges found next to the changed pixels
+			//It is clipped to the frame before converting, since points near the edge of the view project far outside it
+			rtTile region;
+			region.startRow = (int)fminf(fmaxf(floorf(minRow) - 1.0f, 0.0f), (float)bufferHeight);
+			region.endRow = (int)fminf(fmaxf(ceilf(maxRow) + 2.0f, 0.0f), (float)bufferHeight);
+			region.startCol = (int)fminf(fmaxf(floorf(minCol) - 1.0f, 0.0f), (float)bufferWidth);
+			region.endCol = (int)fminf(fmaxf(ceilf(maxCol) + 2.0f, 0.0f), (float)bufferWidth);
+
+			//Rectangles entirely outside the frame change nothing
+			if (region.startRow < region.endRow && region.startCol < region.endCol)
+				regions.push_back(region);
+		}
+
+		return true;
+	}
+
+	//Find the position on the pixel grid of a point given relative to the camera
+	bool rtCam::projectToGrid(const rtVec3f& toPoint, const rtVec3f& firstPoint, const rtVec3f& hStep, const rtVec3f& vStep, float& row, float& col) const
+	{
+		//The camera looks down the negative look vector
+		float depth = -toPoint.dot(n);
+
+		if (depth <= 0.0f)
+			return false;
+
+		//Scale the point onto the near clip plane, where the steps give the column and row
+		rtVec3f gridOffset = position + toPoint * (nearClip / depth) - firstPoint;
+		col = gridOffset.dot(hStep) / hStep.magnitudeSquared();
+		row = gridOffset.dot(vStep) / vStep.magnitudeSquared();
+		return true;
+	}
+
 	//Start counting the number of rendered frames
 	void rtCam::startFpsTimer()
 	{
@@ -135,25 +568,117 @@ namespace rtGraphics
 		}
 	}
 
+	//Move the render scale towards the scale whose frames take the target time
+	void rtCam::adjustRenderScale()
+	{
+		if (frameTime <= 0.0f)
+			return;
+
+		//The time of a frame grows with its number of pixels, so the time is scaled up to what a frame at the display resolution would take
+		float pixelFraction = (float)(bufferWidth * bufferHeight) / (displayWidth * displayHeight);
+		float frameEstimate = frameTime / pixelFraction;
+		//Average the estimates, so a single slow or quick frame doesn't replace the buffers
+		displayFrameTime = (displayFrameTime > 0.0f) ? displayFrameTime + (frameEstimate - displayFrameTime) * frameTimeSmoothing : frameEstimate;
+
+		//The largest step of the scale whose frames are expected to fit in the target
+		float fittingScale = sqrtf(targetFrameTime / displayFrameTime);
+		float steppedScale = fminf(fmaxf(floorf(fittingScale / renderScaleStep) * renderScaleStep, minRenderScale), 1.0f);
+
+		//Go down as soon as the frames run over, but only go up once the larger frames leave time to spare, so the scale doesn't flip back and forth
+		if (steppedScale < renderScale || steppedScale * steppedScale * displayFrameTime < targetFrameTime * scaleUpHeadroom)
+			setRenderScale(steppedScale);
+	}
+
+	//A new scale is due a frame even on an idle view, since the frame buffers are replaced when the next frame starts
+	void rtCam::setRenderScale(float renderScale)
+	{
+		if (renderScale != this->renderScale)
+			settingsChanged = true;
+
+		this->renderScale = renderScale;
+	}
+
 	///Buffer Methods
 	//Creates a 2D image buffer array based on the window size
 	void rtCam::createFrameBuffer()
 	{
-		createFrameBuffer(ofGetWindowWidth(), ofGetWindowHeight());
+		displayWidth = ofGetWindowWidth();
+		displayHeight = ofGetWindowHeight();
+		createFrameBuffer(renderSize(displayWidth), renderSize(displayHeight));
 	}
 
-	//Creates a 2D image buffer array
+	//Creates a 2D image buffer array for each frame buffer
 	void rtCam::createFrameBuffer(int width, int height)
 	{
 		//Save the dimensions of the buffer
 		bufferWidth = width;
 		bufferHeight = height;
-		//Create a frame buffer with the given dimensions
-		frameBuffer = make_shared<ofImage>();
-		frameBuffer->allocate(width, height, OF_IMAGE_COLOR);
-		//Store a reference to the pixel data
-		bufferPixels = &frameBuffer->getPixels();
-		//Set a the image to black by default
+		//Create the frame buffers with the given dimensions
+		frameBuffers.resize((int)buffering);
+
+		for (int bufferIndex = 0; bufferIndex < frameBuffers.size(); bufferIndex++)
+		{
+			frameBuffers[bufferIndex] = make_shared<ofImage>();
+			//A texture is only needed to draw the frame, and needs a window to create
+			frameBuffers[bufferIndex]->setUseTexture(!headless);
+			frameBuffers[bufferIndex]->allocate(width, height, OF_IMAGE_COLOR);
+		}
+
+		//Every frame is traced into the same radiance buffer, since only one frame renders at a time
+		radiance.allocate(width, height, OF_PIXELS_RGB);
+		radiance.set(0.0f);
+		denoisedRadiance.allocate(width, height, OF_PIXELS_RGB);
+		aovs.allocate(width, height);
+
+		renderIndex = 0;
+		latestIndex = 0;
+		//Set a the images to black by default
 		clearBuffer();
 	}
+
+	//Replace the frame buffers with ones of the given size
+	void rtCam::resizeFrameBuffer(int width, int height)
+	{
+		//Start from the latest frame rather than black, so the screen doesn't flash while the first frame of the new size renders
+		ofPixels latestFrame = frameBuffers[latestIndex]->getPixels();
+		latestFrame.resize(width, height);
+		createFrameBuffer(width, height);
+
+		for (int bufferIndex = 0; bufferIndex < frameBuffers.size(); bufferIndex++)
+			frameBuffers[bufferIndex]->getPixels() = latestFrame;
+	}
+
+	//Scale a side of the display by the render scale, keeping at least one pixel
+	int rtCam::renderSize(int displaySize) const
+	{
+		return max((int)roundf(displaySize * renderScale), 1);
+	}
+
+	//Make the frame in flight the latest completed frame
+	void rtCam::completeFrame()
+	{
+		frameInFlight = false;
+
+		//The cache keeps the radiance as rendered, before it is denoised
+		if (frameCached)
+			reprojectionCache.commitFrame(radiance);
+
+		if (frameHitsKept)
+			hitCache.commitFrame();
+
+		//The render threads filtered the frame into its own buffer, which becomes the radiance of the latest frame
+		if (frameDenoised)
+			radiance.swap(denoisedRadiance);
+
+		latestIndex = renderIndex;
+		latestUploaded = false;
+		frameNumber++;
+		//The fps counts completed frames, which can be fewer than the frames drawn when rendering in the background
+		updateFps();
+
+		frameTime = chrono::duration<float, milli>(chrono::steady_clock::now() - frameStart).count();
+
+		if (targetFrameTime > 0.0f && !framePartial)
+			adjustRenderScale();
+	}
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include <chrono>
 #include "ofAppRunner.h"
 #include "ofImage.h"
@@ -8,7 +9,11 @@
 #include "ofEventUtils.h"
 #include "rtNode.h"
 #include "Data Classes/rtScene.h"
+#include "Data Classes/rtAOVBuffers.h"
 #include "rtRenderer.h"
+#include "rtDenoiser.h"
+#include "rtChangeTracker.h"
+#include "Utilities/rtBandWriter.h"
 
 using namespace std;
 
@@ -29,6 +34,21 @@ namespace rtGraphics
 		float farClip = 1000.0f;
 		int maxBounces = 3;
 		renderMode RenderMode = renderMode::rayTrace;
+		//The size of the blocks of pixels whose camera rays are traced together when ray tracing
+		rayPacketSize packetSize = rayPacketSize::packet4x4;
+		//Whether ray traced pixels are traced depth-first or a tile at a time, one bounce after another
+		renderPipeline pipeline = renderPipeline::recursive;
+		//The width and height of the tiles the render threads take turns rendering
+		int tileSize = 32;
+		//Whether frames are traced coarse to fine, only refining the blocks whose corners differ by more than the threshold
+		bool progressive = false;
+		float refineThreshold = 0.02f;
+		//The most samples taken in a pixel that differs from a neighbour by more than the threshold. A single sample turns anti-aliasing off.
+		int maxSamples = 1;
+		float antiAliasThreshold = 0.05f;
+		//How the radiance of each frame is mapped to the display, and the factor the radiance is scaled by first
+		toneMapping ToneMapping = toneMapping::none;
+		float exposure = 1.0f;
 		//Vectors defining the viewing coordinates
 		rtVec3f position;
 		rtVec3f pref;	//Look-at point
@@ -37,12 +57,51 @@ namespace rtGraphics
 		rtVec3f v;		//Precise up vector
 		rtVec3f u;		//Perpendicular vector
 
-		//An image to temporarily store the render before being drawn to the screen
-		shared_ptr<ofImage> frameBuffer;
-		//A reference to the pixel data of the frame buffer
-		ofPixels* bufferPixels;
-		//The dimensions of the frame buffer
+		//The number of frame buffers. With more than one, frames render in the background while the latest completed frame is shown.
+		frameBuffering buffering = frameBuffering::single;
+		//Images to store the renders before being drawn to the screen
+		vector<shared_ptr<ofImage>> frameBuffers;
+		//The color of each pixel of the frame being rendered before it is tone mapped to the frame buffer
+		ofFloatPixels radiance;
+		//The hit data of each pixel of the frame being rendered, for the enabled outputs
+		rtAOVBuffers aovs;
+		//Filters the noise out of each frame once it is traced, on the render threads. It is guided by the normal, depth and albedo outputs.
+		rtDenoiser denoiser = rtDenoiser(0);
+		//The filtered radiance of the frame being rendered, which replaces the radiance once the frame completes
+		ofFloatPixels denoisedRadiance;
+		//True when the frame in flight is denoised, so its filtered radiance replaces the radiance once it completes
+		bool frameDenoised = false;
+		//Whether frames reuse the colors of the surfaces the last completed frame saw, and the cache holding that frame
+		bool reprojection = false;
+		rtReprojectionCache reprojectionCache;
+		//True when the frame in flight renders through the cache, so it is kept for the next frame once it completes
+		bool frameCached = false;
+		//Whether frames keep the hits of their camera rays, so frames where only lights and materials changed shade the kept hits instead of tracing them again
+		bool hitCaching = false;
+		rtHitCache hitCache;
+		//True when the frame in flight traces or reshades through the hit cache, so its hits are kept once it completes
+		bool frameHitsKept = false;
+		//The scene as the last frame started, so frames where nothing changed aren't rendered and frames where a few objects changed only render the tiles they reach
+		rtChangeTracker sceneChanges;
+		//True when a setting changed since the last frame started, so the next frame is rendered in full
+		bool settingsChanged = true;
+		//The number of frames started since the scene or settings last changed
+		int stillFrames = 0;
+		//The frame buffer being rendered to, and the frame buffer holding the latest completed frame
+		int renderIndex, latestIndex;
+		//True from when a frame is started until its completion is noticed
+		bool frameInFlight = false;
+		//True when a cancelled frame should be started again with the current settings at the next draw
+		bool restartPending = false;
+		//True once the latest completed frame has been uploaded for drawing
+		bool latestUploaded;
+		//The number of frames completed
+		unsigned long frameNumber = 0;
+		//The dimensions of the frame buffers, which frames render at, and of the image they are stretched to when drawn
 		int bufferWidth, bufferHeight;
+		int displayWidth, displayHeight;
+		//Headless cameras render without a window, so their frame buffers have no textures and can't be drawn
+		bool headless = false;
 		//An rtRenderer instance for this camera
 		rtRenderer renderer;
 
@@ -54,29 +113,102 @@ namespace rtGraphics
 		//Number of framed rendered in the last second interval
 		int fps;
 
+		///Frame time methods
+		//The time the frame in flight started, and the milliseconds from the start of the last completed frame until its completion was noticed
+		chrono::steady_clock::time_point frameStart;
+		float frameTime = 0.0f;
+		//True when the frame in flight only renders the tiles some changes reach, so its time says little about a whole frame
+		bool framePartial = false;
+		//The milliseconds the render resolution is scaled to fit each frame in, or zero to render at the display resolution
+		float targetFrameTime = 0.0f;
+		//The fraction of the display resolution frames render at, and the lowest fraction it may go down to
+		float renderScale = 1.0f;
+		float minRenderScale = 0.25f;
+		//The scale moves in steps of this size, so small changes in the frame time don't replace the buffers
+		float renderScaleStep = 0.0625f;
+		//The average milliseconds a frame at the display resolution would take, estimated from the frame times at the render resolution
+		float displayFrameTime = 0.0f;
+		//The weight of each new frame in the average
+		float frameTimeSmoothing = 0.25f;
+		//The scale only goes up once the larger frames are expected to take less than this fraction of the target
+		float scaleUpHeadroom = 0.8f;
+
 		///Buffer methods
-		//Instantiates the frame buffer. If no dimensions are given, the window size is used
+		//Instantiates the frame buffers. If no dimensions are given, the window size is used
 		void createFrameBuffer();
 		void createFrameBuffer(int width, int height);
+		//Replace the frame buffers with ones of the given dimensions, each starting with the latest frame stretched to fit
+		void resizeFrameBuffer(int width, int height);
+		//The number of pixels frames render along a side of the display with the given number of pixels
+		int renderSize(int displaySize) const;
+		//Make the frame in flight the latest completed frame
+		void completeFrame();
 		///Camera methods
 		//Calculates the axes of the viewing coordinates
 		void calcAxes();
+		//The scene, camera and render settings of the next frame. The buffers are left for the caller to fill in.
+		rtFrameSettings frameSettings() const;
+		//Returns true if the scene or settings changed since the last frame started, or temporal anti-aliasing is still gathering samples of a still view
+		bool frameDue();
+		/*
+		 * Find the rectangles of pixels that the changes to the scene since the last frame started can affect. Returns false if the whole frame must be rendered.
+		 * The rectangles cover the pixels changed objects covered or cover, and the shadows of moved objects from each light.
+		 */
+		bool findDirtyRegions(vector<rtTile>& regions);
+		//Find the position on the pixel grid of a point given relative to the camera. Points at infinity are given by their direction. Returns false if the point is behind the camera.
+		bool projectToGrid(const rtVec3f& toPoint, const rtVec3f& firstPoint, const rtVec3f& hStep, const rtVec3f& vStep, float& row, float& col) const;
 
 		///FPS methods
 		void startFpsTimer();
 		void updateFps();
+		//Move the render scale towards the scale whose frames take the target time, based on the time of the frame that just completed
+		void adjustRenderScale();
+		//Change the fraction of the display resolution the following frames render at
+		void setRenderScale(float renderScale);
 
 	public:
 		///Constructors
 		rtCam(bool enabled = true);
 		rtCam(const rtVec3f& position, const rtVec3f& lookAtPoint, const rtVec3f& upVector, bool enabled = true);
+		/*
+		 * A headless camera renders at the given resolution without a window. Its frames are read with getLatestFrame.
+		 * Its renderer has the given number of threads, or a thread for each core, so several headless cameras can share the cores.
+		 */
+		rtCam(int width, int height, const rtVec3f& position, const rtVec3f& lookAtPoint, const rtVec3f& upVector, int numThreads = 0);
 		///Event Listeners
+		//Render a new frame if the scene or settings changed since the last one, and draw the latest frame
 		void draw(ofEventArgs& event);
 		///Camera Methods
 		void enable();
 		void disable();
 		bool isEnabled() const;
+		/*
+		 * Render a frame of the scene. When only some objects changed since the last frame, and the frame isn't progressive, reprojected or denoised,
+		 * only the tiles those objects can affect are rendered and the rest is copied from the latest frame. A frame where nothing changed renders no tiles.
+		 * With anti-aliasing, the pixels on the border of those tiles are compared with anti-aliased neighbours, so a few can take different samples than in a full frame.
+		 * With hit caching, a frame where no object moved since the last one shades the camera ray hits of that frame instead of tracing them.
+		 */
 		void render(bool waitForRender);
+		/*
+		 * Render a frame of the given size a band of rows at a time, writing each band to the file once it completes
+		 * Only one band is held in memory, so the frame can be far larger than the frame buffers. The file must be a PPM or PFM file.
+		 * The AOV buffers aren't written.
+		 * Throws a string describing the problem if the file can't be written.
+		 */
+		void renderToFile(string filePath, int width, int height, int bandRows = 256);
+		//Wait for the frame in flight to complete
+		void finishFrame();
+		//Check if the frame in flight has completed without waiting for it. Returns true if a new frame completed.
+		bool pollFrame();
+		//Stop the frame in flight after the tiles being rendered. The frame doesn't count as completed.
+		void cancelRender();
+		/*
+		 * Cancel the frame in flight and render the next frame in full with the current settings at the next draw
+		 * Changes made through the setters of the scene, lights, objects and materials are noticed without this. Call it after changes they can't see,
+		 * such as colors changed through the references returned by getters, or call markChanged on what changed.
+		 */
+		void restartRender();
+		bool isRendering();
 		void draw();
 		void clearBuffer();
 		///Getters
@@ -85,9 +217,40 @@ namespace rtGraphics
 		float getFarClip() const;
 		int getMaxBounces() const;
 		renderMode getRenderMode() const;
+		rayPacketSize getPacketSize() const;
+		renderPipeline getRenderPipeline() const;
+		int getTileSize() const;
+		frameBuffering getFrameBuffering() const;
+		bool isProgressive() const;
+		float getRefineThreshold() const;
+		int getMaxSamples() const;
+		float getAntiAliasThreshold() const;
+		toneMapping getToneMapping() const;
+		float getExposure() const;
+		int getDenoisePasses() const;
+		bool isReprojecting() const;
+		bool isTemporalAntiAliasing() const;
+		bool isCachingHits() const;
 		int getFps() const;
+		//The milliseconds from the start of the last completed frame until its completion was noticed
+		float getFrameTime() const;
+		float getTargetFrameTime() const;
+		//The fraction of the display resolution frames render at
+		float getRenderScale() const;
+		float getMinRenderScale() const;
 		shared_ptr<rtScene> getScene() const;
 		ofPixels* getBufferPixels();
+		/*
+		 * The pixels of the latest completed frame, and the number of frames completed so far
+		 * The pixels stay unchanged until a newer frame completes and the frame after it starts, or one frame later with triple buffering.
+		 * With a single buffer the latest frame is also the one being rendered. The frame has the render resolution, which the frame time target can scale down.
+		 */
+		const ofPixels& getLatestFrame() const;
+		unsigned long getFrameNumber() const;
+		//The radiance of the last frame started. It is only complete once that frame has completed.
+		const ofFloatPixels& getRadiance() const;
+		//The AOV buffers of the last frame started. Like the radiance, they are only complete once that frame has completed.
+		const rtAOVBuffers& getAOVs() const;
 		rtVec3f getPosition() const;
 		rtVec3f getLookVector() const;
 		rtVec3f getUpVector() const;
@@ -98,6 +261,51 @@ namespace rtGraphics
 		void setFarClip(float farClip);
 		void setMaxBounces(int maxBounces);
 		void setRenderMode(renderMode RenderMode);
+		void setPacketSize(rayPacketSize packetSize);
+		void setRenderPipeline(renderPipeline pipeline);
+		void setTileSize(int tileSize);
+		void setFrameBuffering(frameBuffering buffering);
+		//Replace the frame buffers with ones of the given dimensions. With a frame time target, frames render at a fraction of it and are stretched to it when drawn.
+		void setResolution(int width, int height);
+		/*
+		 * Scale the render resolution down from the display resolution to keep each frame within the given number of milliseconds, or zero to turn scaling off
+		 * The scale follows the average frame time, going down as soon as the frames run over and back up once the larger frames fit with time to spare.
+		 * Changing the scale replaces the frame buffers, so the next frame is rendered in full. Frames that only render a few tiles don't move the scale.
+		 */
+		void setTargetFrameTime(float targetFrameTime);
+		//The lowest fraction of the display resolution frames render at, however long they take
+		void setMinRenderScale(float minRenderScale);
+		void setProgressive(bool progressive);
+		//The threshold is the fraction of the color range the corners of a block may differ by before the block is refined
+		void setRefineThreshold(float refineThreshold);
+		void setMaxSamples(int maxSamples);
+		//The threshold is the fraction of the color range a pixel may differ from its neighbours by before it is anti-aliased
+		void setAntiAliasThreshold(float antiAliasThreshold);
+		void setToneMapping(toneMapping ToneMapping);
+		void setExposure(float exposure);
+		//Write the given output for each pixel of the following frames, or stop writing it. Interpolated pixels of progressive frames take the outputs of the nearest traced pixel.
+		void enableAOV(aovType type, bool enable = true);
+		/*
+		 * Denoise each completed frame with the given number of filter passes, or zero to turn denoising off
+		 * Denoising writes the normal, depth and albedo outputs it is guided by. The render threads run it as the last passes of each frame, before the frame is shown.
+		 */
+		void setDenoisePasses(int passes);
+		/*
+		 * Reuse the colors of the surfaces the last frame saw instead of shading them again, only shading the newly visible pixels and a share of the rest
+		 * This speeds up navigating the scene, but highlights and reflections lag a few frames behind the camera. Progressive frames don't reproject.
+		 * Any change to the scene the camera notices clears the cache. Changes it can't see, made without the setters or markChanged, are only picked up as their pixels are refreshed.
+		 */
+		void setReprojection(bool reprojection);
+		//Jitter the camera rays of each frame by a fraction of a pixel and blend the frames together. Only applies while reprojecting.
+		void setTemporalAntiAliasing(bool temporalAntiAliasing);
+		//Shade every pixel of the next frame from scratch. Call this after moving objects or lights.
+		void clearReprojection();
+		/*
+		 * Keep the hit of each pixel's camera ray, so frames where only lights and materials changed only trace the shadow rays and reflections
+		 * The colors are the same as tracing the whole frame. Moving the camera or an object traces the camera rays again.
+		 * The hits take a few dozen bytes per pixel. Progressive and reprojected frames don't keep them.
+		 */
+		void setHitCaching(bool hitCaching);
 		void setScene(shared_ptr<rtScene> scene);
 		void setPosition(const rtVec3f& position);
 		void setLookAtPoint(const rtVec3f& lookAtPoint);
@@ -0,0 +1,197 @@
+#include "rtChangeTracker.h"
+
+namespace rtGraphics
+{
+	//Take a snapshot of the scene as it is now
+	void rtChangeTracker::record(const rtScene& scene)
+	{
+		lightSet sceneLights = scene.getLights();
+		objectSet sceneObjects = scene.getObjects();
+
+		this->scene = &scene;
+		sceneVersion = scene.getVersion();
+		lights = *sceneLights;
+		objects = *sceneObjects;
+		lightVersions.resize(lights.size());
+		objectStates.resize(objects.size());
+
+		for (int lightIndex = 0; lightIndex < lights.size(); lightIndex++)
+			lightVersions[lightIndex] = lights[lightIndex]->getVersion();
+
+		for (int objectIndex = 0; objectIndex < objects.size(); objectIndex++)
+		{
+			rtObject* object = objects[objectIndex];
+			objectStates[objectIndex] = { object->getVersion(), object->getMaterialVersion(), object->getBounds() };
+		}
+
+		hasSnapshot = true;
+	}
+
+	//Forget the snapshot
+	void rtChangeTracker::clear()
+	{
+		hasSnapshot = false;
+		scene = nullptr;
+	}
+
+	//Returns true if anything in the scene changed since the snapshot
+	bool rtChangeTracker::hasChanged(const rtScene& scene) const
+	{
+		if (!hasSnapshot || &scene != this->scene || scene.getVersion() != sceneVersion)
+			return true;
+
+		//The scene version is the same, so the lights and objects are the ones in the snapshot, unless the sets were changed directly
+		lightSet sceneLights = scene.getLights();
+		objectSet sceneObjects = scene.getObjects();
+
+		if (sceneLights->size() != lights.size() || sceneObjects->size() != objects.size())
+			return true;
+
+		for (int lightIndex = 0; lightIndex < lights.size(); lightIndex++)
+			if (sceneLights->at(lightIndex)->getVersion() != lightVersions[lightIndex])
+				return true;
+
+		for (int objectIndex = 0; objectIndex < objects.size(); objectIndex++)
+		{
+			rtObject* object = sceneObjects->at(objectIndex);
+			const rtObjectState& state = objectStates[objectIndex];
+
+			if (object->getVersion() != state.version || object->getMaterialVersion() != state.materialVersion)
+				return true;
+		}
+
+		return false;
+	}
+
+	//Returns true if an object was moved, added or removed since the snapshot
+	bool rtChangeTracker::objectsMoved(const rtScene& scene) const
+	{
+		if (!hasSnapshot || &scene != this->scene)
+			return true;
+
+		//The scene version also counts lights added and removed, so the objects are compared one by one
+		objectSet sceneObjects = scene.getObjects();
+
+		if (sceneObjects->size() != objects.size())
+			return true;
+
+		for (int objectIndex = 0; objectIndex < objects.size(); objectIndex++)
+		{
+			rtObject* object = sceneObjects->at(objectIndex);
+			const rtObjectState& state = objectStates[objectIndex];
+			rtAABB bounds = object->getBounds();
+
+			if (object != objects[objectIndex] || object->getVersion() != state.version || bounds.getMin() != state.bounds.getMin() || bounds.getMax() != state.bounds.getMax())
+				return true;
+		}
+
+		return false;
+	}
+
+	//Find the world space bounds of the changes since the snapshot
+	bool rtChangeTracker::findChanges(const rtScene& scene, bool reflections, vector<rtAABB>& visibleBounds, vector<rtAABB>& shadowBounds) const
+	{
+		visibleBounds.clear();
+		shadowBounds.clear();
+
+		if (!hasSnapshot || &scene != this->scene)
+			return false;
+
+		lightSet sceneLights = scene.getLights();
+		objectSet sceneObjects = scene.getObjects();
+
+		//A light added, removed or changed lights every surface it reaches differently
+		if (sceneLights->size() != lights.size())
+			return false;
+
+		for (int lightIndex = 0; lightIndex < lights.size(); lightIndex++)
+			if (sceneLights->at(lightIndex) != lights[lightIndex] || sceneLights->at(lightIndex)->getVersion() != lightVersions[lightIndex])
+				return false;
+
+		//Objects keep their order while nothing is added or removed. Otherwise the objects are matched up by their address.
+		bool sameObjects = (scene.getVersion() == sceneVersion && sceneObjects->size() == objects.size());
+		unordered_map<rtObject*, int> snapshotIndices;
+		vector<bool> matched;
+
+		if (!sameObjects)
+		{
+			matched.assign(objects.size(), false);
+
+			for (int objectIndex = 0; objectIndex < objects.size(); objectIndex++)
+				snapshotIndices[objects[objectIndex]] = objectIndex;
+		}
+
+		for (int objectIndex = 0; objectIndex < sceneObjects->size(); objectIndex++)
+		{
+			rtObject* object = sceneObjects->at(objectIndex);
+			int snapshotIndex = objectIndex;
+
+			if (!sameObjects)
+			{
+				unordered_map<rtObject*, int>::iterator found = snapshotIndices.find(object);
+
+				//An added object changes the pixels it covers and the shadows it casts
+				if (found == snapshotIndices.end())
+				{
+					if (!addBounds(object->getBounds(), true, visibleBounds, shadowBounds))
+						return false;
+
+					continue;
+				}
+
+				snapshotIndex = found->second;
+				matched[snapshotIndex] = true;
+			}
+
+			const rtObjectState& state = objectStates[snapshotIndex];
+			rtAABB bounds = object->getBounds();
+			bool moved = object->getVersion() != state.version || bounds.getMin() != state.bounds.getMin() || bounds.getMax() != state.bounds.getMax();
+
+			if (moved)
+			{
+				//A moved object uncovers what was behind it and covers something new
+				if (!addBounds(state.bounds, true, visibleBounds, shadowBounds) || !addBounds(bounds, true, visibleBounds, shadowBounds))
+					return false;
+			}
+			else if (object->getMaterialVersion() != state.materialVersion)
+			{
+				if (!addBounds(bounds, false, visibleBounds, shadowBounds))
+					return false;
+			}
+		}
+
+		//A removed object uncovers what was behind it and stops casting its shadows
+		for (int objectIndex = 0; objectIndex < matched.size(); objectIndex++)
+			if (!matched[objectIndex] && !addBounds(objectStates[objectIndex].bounds, true, visibleBounds, shadowBounds))
+				return false;
+
+		if (visibleBounds.empty())
+			return true;
+
+		//A reflective surface can show a changed object anywhere in the frame
+		if (reflections)
+			for (int objectIndex = 0; objectIndex < sceneObjects->size(); objectIndex++)
+				if (sceneObjects->at(objectIndex)->getMat().getReflectivity() > 0.0f)
+					return false;
+
+		return true;
+	}
+
+	//Add the bounds an object covered or covers to the changed bounds
+	bool rtChangeTracker::addBounds(const rtAABB& bounds, bool moved, vector<rtAABB>& visibleBounds, vector<rtAABB>& shadowBounds)
+	{
+		//Empty objects cover nothing, and objects without finite bounds, such as planes, can cover any pixel
+		if (bounds.isEmpty())
+			return true;
+
+		if (!bounds.isFinite())
+			return false;
+
+		visibleBounds.push_back(bounds);
+
+		if (moved)
+			shadowBounds.push_back(bounds);
+
+		return true;
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include "Data Classes/rtScene.h"
+#include "Data Classes/rtAABB.h"
+
+using namespace std;
+
+namespace rtGraphics
+{
+	/*
+	 * Remembers the versions of a scene and of its lights, objects and materials when a frame starts, so the next frame can tell what changed
+	 * A frame with no changes shows the same image, and a frame where only some objects changed only needs the pixels those objects can reach.
+	 * Objects that move change the pixels they covered and now cover, and the shadows they cast. Objects whose material changes only change their own pixels.
+	 * Lights reach every surface, so a change to a light has no bounds.
+	 */
+	class rtChangeTracker
+	{
+	private:
+		//The versions and bounds of an object when the snapshot was taken
+		struct rtObjectState
+		{
+			unsigned long version;
+			unsigned long materialVersion;
+			rtAABB bounds;
+		};
+
+		bool hasSnapshot = false;
+		//The scene the snapshot was taken of. It is only compared against, since it may have been deleted since.
+		const rtScene* scene = nullptr;
+		unsigned long sceneVersion;
+		vector<rtObject*> objects;
+		vector<rtObjectState> objectStates;
+		vector<rtLight*> lights;
+		vector<unsigned long> lightVersions;
+
+		//Add the bounds an object covered or covers to the changed bounds. Returns false if they aren't finite.
+		static bool addBounds(const rtAABB& bounds, bool moved, vector<rtAABB>& visibleBounds, vector<rtAABB>& shadowBounds);
+
+	public:
+		//Take a snapshot of the scene as it is now
+		void record(const rtScene& scene);
+		//Forget the snapshot, so every change is treated as unbounded until the next one is taken
+		void clear();
+
+		//Returns true if anything in the scene changed since the snapshot, or there is no snapshot of this scene
+		bool hasChanged(const rtScene& scene) const;
+		//Returns true if an object was moved, added or removed since the snapshot, or there is no snapshot of this scene. Changes to lights and materials don't count.
+		bool objectsMoved(const rtScene& scene) const;
+		/*
+		 * Find the world space bounds of the changes since the snapshot. Returns false if a change can affect any pixel of the frame.
+		 * The visible bounds hold everything drawn differently, and the shadow bounds the objects that moved, whose shadows moved with them.
+		 * Changes to lights, changes to objects without finite bounds, and any change while reflections may show objects elsewhere have no bounds.
+		 * Both lists are empty if nothing changed.
+		 */
+		bool findChanges(const rtScene& scene, bool reflections, vector<rtAABB>& visibleBounds, vector<rtAABB>& shadowBounds) const;
+	};
+}
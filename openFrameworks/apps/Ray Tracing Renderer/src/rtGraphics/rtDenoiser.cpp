@@ -0,0 +1,269 @@
+#include "rtDenoiser.h"
+
+namespace rtGraphics
+{
+	///Constructors
+	rtDenoiser::rtDenoiser(int passes, float colorPhi, float normalPhi, float depthPhi) :
+		passes(max(passes, 0)), colorPhi(colorPhi), normalPhi(normalPhi), depthPhi(depthPhi) {}
+
+	//Start filtering a frame of the given size
+	void rtDenoiser::setFrame(int width, int height, const rtAOVBuffers* guides)
+	{
+		this->width = width;
+		this->height = height;
+		this->guides = guides;
+		size_t numPixels = (size_t)width * height;
+
+		//Guide buffers of a different size belong to another frame
+		hasNormals = guides && guides->isEnabled(aovType::normal) && guides->getBuffer(aovType::normal).getWidth() == width && guides->getBuffer(aovType::normal).getHeight() == height;
+		hasDepth = guides && guides->isEnabled(aovType::depth) && guides->getBuffer(aovType::depth).getWidth() == width && guides->getBuffer(aovType::depth).getHeight() == height;
+		hasAlbedo = guides && guides->isEnabled(aovType::albedo) && guides->getBuffer(aovType::albedo).getWidth() == width && guides->getBuffer(aovType::albedo).getHeight() == height;
+
+		for (int channel = 0; channel < 3; channel++)
+		{
+			color[channel].resize(numPixels);
+			filtered[channel].resize(numPixels);
+			albedo[channel].resize(hasAlbedo ? numPixels : 0);
+			normal[channel].resize(hasNormals ? numPixels : 0);
+		}
+
+		depth.resize(hasDepth ? numPixels : 0);
+	}
+
+	//Copy the radiance and guides of the tile to the planes, dividing the radiance by the albedo
+	void rtDenoiser::loadTile(const ofFloatPixels& radiance, const rtTile& tile)
+	{
+		for (int row = tile.startRow; row < tile.endRow; row++)
+		{
+			for (int col = tile.startCol; col < tile.endCol; col++)
+			{
+				size_t pixel = (size_t)row * width + col;
+
+				for (int channel = 0; channel < 3; channel++)
+				{
+					float value = radiance[pixel * 3 + channel];
+
+					if (hasAlbedo)
+					{
+						//Pixels without an albedo, such as misses and black materials, are filtered as they are
+						float pixelAlbedo = guides->getBuffer(aovType::albedo)[pixel * 3 + channel];
+						albedo[channel][pixel] = (pixelAlbedo > 0.001f) ? pixelAlbedo : 1.0f;
+						value /= albedo[channel][pixel];
+					}
+
+					color[channel][pixel] = value;
+
+					if (hasNormals)
+						normal[channel][pixel] = guides->getBuffer(aovType::normal)[pixel * 3 + channel];
+				}
+
+				//Misses have an infinite depth, which is replaced by a finite one so differences between misses stay zero
+				if (hasDepth)
+					depth[pixel] = fminf(guides->getBuffer(aovType::depth)[pixel], 1e30f);
+			}
+		}
+	}
+
+	//Run the given pass over the tile
+	void rtDenoiser::filterTile(const rtTile& tile, int pass)
+	{
+		//Each pass doubles the spacing of the taps and halves the color difference it tolerates, since the noise left is smaller
+		//The output of each pass is the input of the next
+		if (pass % 2 == 0)
+			filterPlanes(tile, color, filtered, 1 << pass, colorPhi / (1 << pass));
+		else
+			filterPlanes(tile, filtered, color, 1 << pass, colorPhi / (1 << pass));
+	}
+
+	//Multiply the filtered tile by the albedo and write it to the output
+	void rtDenoiser::storeTile(ofFloatPixels& output, const rtTile& tile) const
+	{
+		//An odd number of passes ends in the filtered planes
+		const vector<float>* result = (passes % 2 == 0) ? color : filtered;
+
+		for (int row = tile.startRow; row < tile.endRow; row++)
+		{
+			for (int col = tile.startCol; col < tile.endCol; col++)
+			{
+				size_t pixel = (size_t)row * width + col;
+
+				for (int channel = 0; channel < 3; channel++)
+					output[pixel * 3 + channel] = hasAlbedo ? result[channel][pixel] * albedo[channel][pixel] : result[channel][pixel];
+			}
+		}
+	}
+
+	//Filter the pixels of the tile from the source planes to the target planes
+	void rtDenoiser::filterPlanes(const rtTile& tile, const vector<float>* source, vector<float>* target, int step, float colorSigma)
+	{
+		//The B3 spline kernel of each tap along one axis
+		static const float kernel[5] = { 1.0f / 16.0f, 1.0f / 4.0f, 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+
+		__m128 invColorSigma2 = _mm_set1_ps(1.0f / (colorSigma * colorSigma));
+		__m128 normalScale = _mm_set1_ps(normalPhi);
+		__m128 zero = _mm_setzero_ps();
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		__m128 laneOffsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+
+		//Local copies of the members, which the compiler would otherwise reload after every store to the target planes
+		const float* sourcePlanes[3] = { source[0].data(), source[1].data(), source[2].data() };
+		const float* normalPlanes[3] = { normal[0].data(), normal[1].data(), normal[2].data() };
+		const float* depthPlane = depth.data();
+		float* targetPlanes[3] = { target[0].data(), target[1].data(), target[2].data() };
+		bool useNormals = hasNormals, useDepth = hasDepth;
+		int width = this->width, height = this->height;
+
+		for (int row = tile.startRow; row < tile.endRow; row++)
+		{
+			int rowStart = row * width;
+
+			for (int col = tile.startCol; col < tile.endCol; col += 4)
+			{
+				//Quads whose taps all lie inside the frame load each tap as one vector
+				bool inside = (col - 2 * step >= 0) && (col + 3 + 2 * step < width);
+
+				__m128 centerColor[3], centerNormal[3], centerDepth, depthScale;
+
+				for (int channel = 0; channel < 3; channel++)
+				{
+					centerColor[channel] = loadTap(sourcePlanes[channel], rowStart, col, 0, width, inside);
+
+					if (useNormals)
+						centerNormal[channel] = loadTap(normalPlanes[channel], rowStart, col, 0, width, inside);
+				}
+
+				if (useDepth)
+				{
+					//Depth differences are relative to the depth of the center pixel and the spacing of the taps
+					centerDepth = loadTap(depthPlane, rowStart, col, 0, width, inside);
+					depthScale = _mm_div_ps(one, _mm_add_ps(_mm_mul_ps(centerDepth, _mm_set1_ps(depthPhi * step)), _mm_set1_ps(1e-6f)));
+				}
+
+				__m128 sum[3] = { zero, zero, zero };
+				__m128 weightSum = zero;
+
+				for (int tapRow = -2; tapRow <= 2; tapRow++)
+				{
+					int sourceRow = row + tapRow * step;
+
+					if (sourceRow < 0 || sourceRow >= height)
+						continue;
+
+					int sourceStart = sourceRow * width;
+
+					for (int tapCol = -2; tapCol <= 2; tapCol++)
+					{
+						int offset = tapCol * step;
+						__m128 tapColor[3];
+						//The sum of the scaled differences from the center pixel, which the weight falls exponentially with
+						__m128 difference = zero;
+
+						for (int channel = 0; channel < 3; channel++)
+						{
+							tapColor[channel] = loadTap(sourcePlanes[channel], sourceStart, col, offset, width, inside);
+							__m128 delta = _mm_sub_ps(tapColor[channel], centerColor[channel]);
+							difference = _mm_add_ps(difference, _mm_mul_ps(_mm_mul_ps(delta, delta), invColorSigma2));
+						}
+
+						if (useNormals)
+						{
+							__m128 dot = zero;
+
+							for (int channel = 0; channel < 3; channel++)
+								dot = _mm_add_ps(dot, _mm_mul_ps(loadTap(normalPlanes[channel], sourceStart, col, offset, width, inside), centerNormal[channel]));
+
+							difference = _mm_add_ps(difference, _mm_mul_ps(_mm_max_ps(_mm_sub_ps(one, dot), zero), normalScale));
+						}
+
+						if (useDepth)
+						{
+							__m128 delta = _mm_and_ps(_mm_sub_ps(loadTap(depthPlane, sourceStart, col, offset, width, inside), centerDepth), absMask);
+							difference = _mm_add_ps(difference, _mm_mul_ps(delta, depthScale));
+						}
+
+						__m128 weight = _mm_mul_ps(_mm_set1_ps(kernel[tapRow + 2] * kernel[tapCol + 2]), expNegative(_mm_sub_ps(zero, difference)));
+
+						//Taps past the left or right edge of the frame get no weight
+						if (!inside)
+						{
+							__m128 tapCols = _mm_add_ps(_mm_set1_ps((float)(col + offset)), laneOffsets);
+							weight = _mm_and_ps(weight, _mm_and_ps(_mm_cmpge_ps(tapCols, zero), _mm_cmplt_ps(tapCols, _mm_set1_ps((float)width))));
+						}
+
+						for (int channel = 0; channel < 3; channel++)
+							sum[channel] = _mm_add_ps(sum[channel], _mm_mul_ps(tapColor[channel], weight));
+
+						weightSum = _mm_add_ps(weightSum, weight);
+					}
+				}
+
+				//The center tap always has weight, so the sum is never zero for pixels inside the frame
+				int lanes = min(4, tile.endCol - col);
+
+				for (int channel = 0; channel < 3; channel++)
+				{
+					__m128 result = _mm_div_ps(sum[channel], weightSum);
+
+					if (lanes == 4)
+					{
+						_mm_storeu_ps(targetPlanes[channel] + rowStart + col, result);
+					}
+					//Lanes past the end of the tile belong to the next tile or lie outside the frame
+					else
+					{
+						float values[4];
+						_mm_storeu_ps(values, result);
+
+						for (int lane = 0; lane < lanes; lane++)
+							targetPlanes[channel][rowStart + col + lane] = values[lane];
+					}
+				}
+			}
+		}
+	}
+
+	//Load the value of a plane at the tap of four neighbouring pixels
+	__m128 rtDenoiser::loadTap(const float* plane, int rowStart, int col, int offset, int width, bool inside)
+	{
+		if (inside)
+			return _mm_loadu_ps(plane + rowStart + col + offset);
+
+		float values[4];
+
+		for (int lane = 0; lane < 4; lane++)
+			values[lane] = plane[rowStart + min(max(col + lane + offset, 0), width - 1)];
+
+		return _mm_loadu_ps(values);
+	}
+
+	//e raised to four powers no greater than zero
+	__m128 rtDenoiser::expNegative(__m128 values)
+	{
+		//Below this the result would no longer be a normal float
+		values = _mm_max_ps(values, _mm_set1_ps(-87.0f));
+
+		//Split e^x into 2^whole * 2^fraction
+		__m128 power = _mm_mul_ps(values, _mm_set1_ps(1.44269504f));
+		__m128i whole = _mm_cvttps_epi32(power);
+		__m128 wholeFloat = _mm_cvtepi32_ps(whole);
+		//Truncation rounds negative powers up, so step those down to the floor
+		__m128 roundedUp = _mm_and_ps(_mm_cmpgt_ps(wholeFloat, power), _mm_set1_ps(1.0f));
+		wholeFloat = _mm_sub_ps(wholeFloat, roundedUp);
+		whole = _mm_cvttps_epi32(wholeFloat);
+		__m128 fraction = _mm_sub_ps(power, wholeFloat);
+
+		//A polynomial fit of 2^fraction between 0 and 1
+		__m128 result = _mm_set1_ps(0.001333355f);
+		result = _mm_add_ps(_mm_mul_ps(result, fraction), _mm_set1_ps(0.009618129f));
+		result = _mm_add_ps(_mm_mul_ps(result, fraction), _mm_set1_ps(0.05550411f));
+		result = _mm_add_ps(_mm_mul_ps(result, fraction), _mm_set1_ps(0.2402265f));
+		result = _mm_add_ps(_mm_mul_ps(result, fraction), _mm_set1_ps(0.6931472f));
+		result = _mm_add_ps(_mm_mul_ps(result, fraction), _mm_set1_ps(1.0f));
+
+		//2^whole is built directly in the exponent bits of a float
+		__m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(whole, _mm_set1_epi32(127)), 23));
+
+		return _mm_mul_ps(result, scale);
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <immintrin.h>
+#include "ofPixels.h"
+#include "rtTileScheduler.h"
+#include "Data Classes/rtScene.h"
+#include "Data Classes/rtAOVBuffers.h"
+
+using namespace std;
+
+namespace rtGraphics
+{
+	/*
+	 * Removes noise from a rendered frame with an edge-avoiding a-trous wavelet filter, guided by the normal, depth and albedo AOVs
+	 * Each pass blurs with a 5x5 B3 spline kernel whose taps are spread twice as far apart as in the pass before, and weighs each tap by
+	 * how closely its color, normal and depth match the center pixel, so the blur stops at edges. The radiance is divided by the albedo
+	 * before filtering and multiplied back afterwards, so texture detail isn't blurred away with the noise.
+	 * The buffers are copied to one plane per channel so four neighbouring pixels are filtered at once.
+	 * The filter runs a tile at a time, so the render threads can share the work of each pass the way they share the tiles of a frame.
+	 */
+	class rtDenoiser
+	{
+	private:
+		int passes;
+		//How quickly the weight of a tap falls as its color, normal and depth differ from the center pixel
+		float colorPhi, normalPhi, depthPhi;
+
+		int width, height;
+		//The radiance divided by the albedo, filtered back and forth between the two sets of planes. Even passes read the color planes and odd passes the filtered ones.
+		vector<float> color[3], filtered[3];
+		//The guide planes. Guides without an AOV buffer are left empty and don't affect the weights.
+		vector<float> normal[3], depth, albedo[3];
+		bool hasNormals, hasDepth, hasAlbedo;
+		//The guides of the frame being filtered
+		const rtAOVBuffers* guides = nullptr;
+
+		//Filter the pixels of the tile from the source planes to the target planes, with the taps the given number of pixels apart
+		void filterPlanes(const rtTile& tile, const vector<float>* source, vector<float>* target, int step, float colorSigma);
+		//Load the value of a plane at the tap of four neighbouring pixels. Taps outside the frame are clamped to it and given no weight by the mask.
+		static __m128 loadTap(const float* plane, int rowStart, int col, int offset, int width, bool inside);
+		//e raised to four powers no greater than zero
+		static __m128 expNegative(__m128 values);
+
+	public:
+		///Constructors
+		rtDenoiser(int passes = 5, float colorPhi = 1.0f, float normalPhi = 64.0f, float depthPhi = 0.05f);
+
+		/*
+		 * Start filtering a frame of the given size. Any of the normal, depth and albedo buffers of the guides that are enabled and have the size of the frame
+		 * are used, and the filter only follows the color edges without them. The guides must stay unchanged until the frame is stored.
+		 * Must not be called while the tiles of another frame are being filtered.
+		 */
+		void setFrame(int width, int height, const rtAOVBuffers* guides);
+		//Copy the radiance and guides of the tile to the planes, dividing the radiance by the albedo
+		void loadTile(const ofFloatPixels& radiance, const rtTile& tile);
+		//Run the given pass over the tile. Every tile must be loaded for the first pass, or have finished the pass before, before any tile starts the pass.
+		void filterTile(const rtTile& tile, int pass);
+		//Multiply the filtered tile by the albedo and write it to the output, which has the size of the frame. Every tile must finish the last pass first.
+		void storeTile(ofFloatPixels& output, const rtTile& tile) const;
+		void setPasses(int passes);
+		int getPasses() const;
+	};
+
+	///In-line method definitions
+	inline void rtDenoiser::setPasses(int passes) { this->passes = max(passes, 0); }
+	inline int rtDenoiser::getPasses() const { return passes; }
+}
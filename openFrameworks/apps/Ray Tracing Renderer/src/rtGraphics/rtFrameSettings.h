@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "ofPixels.h"
+#include "Data Classes/rtScene.h"
+#include "Data Classes/Data Types.h"
+#include "Data Classes/rtVec3f.h"
+#include "Data Classes/rtAOVBuffers.h"
+#include "rtReprojectionCache.h"
+#include "rtHitCache.h"
+#include "rtDenoiser.h"
+#include "rtTileScheduler.h"
+
+using namespace std;
+
+namespace rtGraphics
+{
+	/*
+	 * The scene, camera, render settings and buffers of a single frame, handed to the renderer when the frame starts
+	 * The settings default to those of a new camera. The radiance and pixel buffers must be set for every frame, and the others are optional.
+	 */
+	struct rtFrameSettings
+	{
+		//The scene to render
+		shared_ptr<rtScene> scene;
+
+		//The position and axes of the camera, its horizontal field of view in degrees and its clip distances
+		rtVec3f camPos, u, v, n;
+		float hFov = 90.0f;
+		float nearClip = 0.1f;
+		float farClip = 1000.0f;
+
+		//Render settings
+		renderMode RenderMode = renderMode::rayTrace;
+		int maxBounces = 3;
+		//The size of the blocks of pixels whose camera rays are traced together when ray tracing
+		rayPacketSize packetSize = rayPacketSize::packet4x4;
+		renderPipeline pipeline = renderPipeline::recursive;
+		//The width and height of the tiles the render threads take turns rendering
+		int tileSize = 32;
+		//Progressive frames trace a coarse grid of pixels first and only refine the blocks whose corners differ by more than the threshold
+		bool progressive = false;
+		float refineThreshold = 0.02f;
+		//Anti-aliased frames take up to the maximum number of samples in the pixels that differ from a neighbour by more than the threshold
+		int maxSamples = 1;
+		float antiAliasThreshold = 0.05f;
+		//How the radiance is mapped to the pixel buffer, and the factor it is scaled by first
+		toneMapping ToneMapping = toneMapping::none;
+		float exposure = 1.0f;
+
+		//The buffers the frame is traced into and tone mapped to
+		ofFloatPixels* radiancePixels = nullptr;
+		ofPixels* bufferPixels = nullptr;
+		//The optional buffers the hit of each pixel's camera ray is written to
+		rtAOVBuffers* aovBuffers = nullptr;
+		//The optional cache of the last frame's colors, which the pixels of surfaces it saw reuse. Progressive frames can't use one.
+		rtReprojectionCache* cache = nullptr;
+		//The optional cache of each pixel's camera ray hit, set up for the frame beforehand. Progressive frames can't use one.
+		rtHitCache* hitCache = nullptr;
+		//The optional rectangles of pixels to render. Only the tiles overlapping them are rendered, and the rest of the buffers are left as they were.
+		const vector<rtTile>* regions = nullptr;
+		//The optional denoiser the finished frame is filtered by, guided by the AOV buffers, and the buffer the filtered radiance is written to and tone mapped from
+		//The radiance buffer keeps the frame as traced. Frames rendering only some regions can't be denoised.
+		rtDenoiser* denoiser = nullptr;
+		ofFloatPixels* denoisedPixels = nullptr;
+
+		//To render a band of rows of a taller frame, the height of the frame and the row the band starts at. The buffers then only hold the band.
+		int frameHeight = 0;
+		int firstRow = 0;
+	};
+}
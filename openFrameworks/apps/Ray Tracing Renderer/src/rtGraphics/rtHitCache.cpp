@@ -0,0 +1,34 @@
+#include "rtHitCache.h"
+
+namespace rtGraphics
+{
+	//Start a frame of the given size
+	void rtHitCache::setFrame(int width, int height, bool reshade, bool wholeFrame)
+	{
+		//The hits of a frame of another size don't line up with the new pixels
+		if (width != this->width || height != this->height)
+		{
+			this->width = width;
+			this->height = height;
+			hits.assign(width * height, rtRayHit());
+			hasHits = false;
+		}
+
+		//Without valid hits, the frame traces its camera rays instead
+		reshading = reshade && hasHits;
+		this->wholeFrame = wholeFrame;
+	}
+
+	//Keep the hits of the frame once it completes
+	void rtHitCache::commitFrame()
+	{
+		if (!reshading && wholeFrame)
+			hasHits = true;
+	}
+
+	//Forget the hits
+	void rtHitCache::clear()
+	{
+		hasHits = false;
+	}
+}
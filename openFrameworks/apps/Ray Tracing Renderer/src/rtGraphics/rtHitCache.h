@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include "Data Classes/rtScene.h"
+#include "Data Classes/rtRayHit.h"
+
+using namespace std;
+
+namespace rtGraphics
+{
+	/*
+	 * Keeps the hit of each pixel's camera ray from the frames that traced them, so a frame where only lights and materials changed can skip the camera rays
+	 * The hit holds the object, face, point and normal a pixel sees, which don't depend on the lights or materials. Reshading a frame only traces
+	 * the shadow rays and reflections of each kept hit, giving the same colors as tracing the camera rays again.
+	 * The hits are only valid while the camera and objects stay where they were, which the camera checks before reshading.
+	 */
+	class rtHitCache
+	{
+	private:
+		int width = 0, height = 0;
+		//The hit of each pixel's camera ray, stored row by row
+		vector<rtRayHit> hits;
+		//True once a completed frame traced every pixel, and no frame since left the hits out of date
+		bool hasHits = false;
+		//True when the frame being rendered shades the kept hits instead of tracing its camera rays
+		bool reshading = false;
+		//True when the frame being rendered covers every pixel rather than some tiles
+		bool wholeFrame = false;
+
+	public:
+		/*
+		 * Start a frame of the given size, which either reshades the kept hits or traces its camera rays and keeps their hits
+		 * Reshading needs the hits of a frame of the same size. A frame of a different size clears the cache. Must not be called while a frame is rendering.
+		 */
+		void setFrame(int width, int height, bool reshade, bool wholeFrame);
+		//Keep the hits of the frame once it completes. A frame tracing every pixel makes the hits valid, and one tracing some tiles keeps them as valid as they were.
+		void commitFrame();
+		//Forget the hits, so the next frame traces its camera rays. Call this when the camera or objects move without a frame keeping the new hits.
+		void clear();
+
+		//Returns true if a frame of the given size can reshade the kept hits
+		bool canReshade(int width, int height) const;
+		//Returns true if the frame being rendered reshades the kept hits
+		bool isReshading() const;
+		//Keep the hit of a pixel's camera ray, given by its index in the frame
+		void setHit(int pixelIndex, const rtRayHit& hit);
+		const rtRayHit& getHit(int pixelIndex) const;
+	};
+
+	///In-line method definitions
+	inline bool rtHitCache::canReshade(int width, int height) const { return hasHits && width == this->width && height == this->height; }
+	inline bool rtHitCache::isReshading() const { return reshading; }
+	inline void rtHitCache::setHit(int pixelIndex, const rtRayHit& hit) { hits[pixelIndex] = hit; }
+	inline const rtRayHit& rtHitCache::getHit(int pixelIndex) const { return hits[pixelIndex]; }
+}
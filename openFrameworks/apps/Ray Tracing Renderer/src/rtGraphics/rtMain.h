@@ -1,10 +1,15 @@
 #pragma once
 
 #include "rtCam.h"
+#include "rtAnimationJob.h"
 #include "Data Classes/rtScene.h"
 #include "Objects/rtSphereObject.h"
 #include "Objects/rtMeshObject.h"
 #include "Objects/rtTorusObject.h"
 #include "Objects/rtPlaneObject.h"
 #include "Objects/rtCylinderObject.h"
-#include "Utilities/ObjImporter.h"
\ No newline at end of file
+#include "Utilities/ObjImporter.h"
+#include "Utilities/rtBenchmark.h"
+#include "Utilities/rtSceneLoader.h"
+#include "Utilities/rtImageWriter.h"
+#include "Utilities/rtBandWriter.h"
\ No newline at end of file
@@ -2,8 +2,23 @@
 
 namespace rtGraphics
 {
-	//To-do: Implement object transform and parenting to function like ofNode
+	/*
+	 * To-do: Implement object transform and parenting to function like ofNode
+	 * Counts the changes made to the node, so a camera can tell which nodes changed since its last frame
+	 */
 	class rtNode
 	{
+	private:
+		unsigned long version = 0;
+
+	public:
+		//Record a change. The setters call this themselves, so it is only needed after changing the node through a reference returned by a getter.
+		void markChanged();
+		//The number of changes recorded. Only compare it to earlier versions of the same node.
+		unsigned long getVersion() const;
 	};
+
+	///In-line method definitions
+	inline void rtNode::markChanged() { version++; }
+	inline unsigned long rtNode::getVersion() const { return version; }
 }
\ No newline at end of file
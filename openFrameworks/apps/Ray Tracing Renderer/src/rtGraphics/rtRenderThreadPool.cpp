@@ -3,108 +3,848 @@
 namespace rtGraphics
 {
 	///Static data member initialization
-	//Set the number of threads to the number of cores on the machine
-	int rtRenderThreadPool::numThreads = thread::hardware_concurrency();
+	//Set the default number of threads to the number of cores on the machine
+	int rtRenderThreadPool::defaultThreads = max((int)thread::hardware_concurrency(), 1);
 
-	RenderThreadData::RenderThreadData(renderMode RenderMode, shared_ptr<rtScene>scene, rtVec3f& camPos, float nearClip, float farClip,
-		int maxBounces, ofPixels* bufferPixels, rtVec3f& firstPoint, rtVec3f& hStep, rtVec3f& vStep)
+	RenderThreadData::RenderThreadData(const rtFrameSettings& settings, rtVec3f& firstPoint, rtVec3f& hStep, rtVec3f& vStep) :
+		toneMapper(settings.ToneMapping, settings.exposure)
 	{
-		this->RenderMode = RenderMode;
+		this->RenderMode = settings.RenderMode;
+		this->pipeline = settings.pipeline;
 		//Scene data
-		this->objects = scene->getObjects();
-		this->lights = scene->getLights();
+		this->objects.build(settings.scene->getObjects());
+		this->lights = settings.scene->getLights();
 		//Camera Data
-		this->camPos = camPos;
-		this->nearClip = nearClip;
-		this->farClip = farClip;
-		this->maxBounces = maxBounces;
+		this->camPos = settings.camPos;
+		this->nearClip = settings.nearClip;
+		this->farClip = settings.farClip;
+		this->maxBounces = settings.maxBounces;
+		this->packetWidth = (int)settings.packetSize;
+		this->progressive = settings.progressive;
+		this->refineThreshold = settings.refineThreshold;
+		this->maxSamples = settings.maxSamples;
+		this->antiAliasThreshold = settings.antiAliasThreshold;
 		//Buffer data
-		this->bufferPixels = bufferPixels;
+		this->radiancePixels = settings.radiancePixels;
+		this->bufferPixels = settings.bufferPixels;
 		this->bufferWidth = bufferPixels->getWidth();
 		this->bufferHeight = bufferPixels->getHeight();
+		this->aovBuffers = settings.aovBuffers;
+		this->cache = settings.cache;
+		this->hitCache = settings.hitCache;
+		this->denoiser = settings.denoiser;
+		this->denoisedPixels = settings.denoisedPixels;
+		//A reshaded frame traces no camera rays, so only the AOV buffers take its hits
+		this->keepCameraHits = aovBuffers || (hitCache && !hitCache->isReshading());
+
+		//Object IDs are the index of each object in the scene, which the hierarchy doesn't keep
+		if (aovBuffers && aovBuffers->isEnabled(aovType::objectID))
+			for (int objectIndex = 0; objectIndex < settings.scene->getObjects()->size(); objectIndex++)
+				objectIDs[settings.scene->getObjects()->at(objectIndex)] = objectIndex;
+
+		//No pixel of a progressive frame is traced at the start
+		if (progressive)
+			traced.assign(bufferWidth * bufferHeight, 0);
+
+		if (maxSamples > 1)
+			edges.assign(bufferWidth * bufferHeight, 0);
 		//Ray iteration data
 		this->firstPoint = firstPoint;
 		this->hStep = hStep;
 		this->vStep = vStep;
+		this->firstRow = settings.firstRow;
 	}
 
-	//Renders a section of the frame buffer
+	//Waits for each frame and renders its tiles, until the pool closes
 	void RenderThread::threadedFunction()
 	{
-		//The current index in the buffer pixels array
-		int bufferIndex = sharedData->bufferWidth * startRow * 3;
+		//The number of the last frame this thread rendered
+		int lastFrame = 0;
+
+		while (true)
+		{
+			{
+				unique_lock<std::mutex> handoffLock(handoff->lock);
+				handoff->frameStarted.wait(handoffLock, [&] { return handoff->closing || handoff->frameNumber != lastFrame; });
+
+				if (handoff->closing)
+					return;
+
+				lastFrame = handoff->frameNumber;
+				sharedData = handoff->frameData;
+			}
+
+			int numPasses = framePasses();
+
+			for (int pass = 0; pass < numPasses; pass++)
+			{
+				renderTiles(pass);
+
+				//Each pass reads the pixels traced by the other threads in the previous passes
+				if (pass + 1 < numPasses && !finishPass())
+					break;
+			}
+
+			//The last thread to finish wakes the pool
+			lock_guard<std::mutex> handoffLock(handoff->lock);
+
+			if (--handoff->busyThreads == 0)
+				handoff->frameFinished.notify_all();
+		}
+	}
+
+	//The passes that trace the pixels of the frame
+	int RenderThread::tracePasses()
+	{
+		return sharedData->progressive ? progressivePasses : 1;
+	}
+
+	//Anti-aliased frames add a pass finding the edges once every pixel is traced, and a pass sampling them
+	int RenderThread::renderPasses()
+	{
+		return tracePasses() + (sharedData->maxSamples > 1 ? 2 : 0);
+	}
+
+	//Denoised frames add a pass for each pass of the filter, which reads the pixels the other threads filtered in the pass before
+	int RenderThread::framePasses()
+	{
+		return renderPasses() + (sharedData->denoiser ? sharedData->denoiser->getPasses() : 0);
+	}
+
+	//Renders tiles of the frame buffer until the scheduler runs out
+	void RenderThread::renderTiles(int pass)
+	{
+		rtTile tile;
+
+		while (scheduler->nextTile(threadIndex, tile))
+		{
+			if (pass >= renderPasses())
+			{
+				denoiseTile(tile, pass - renderPasses());
+				continue;
+			}
+
+			//Finding the edges only reads the pixels, so there is nothing new to show
+			if (pass == tracePasses())
+			{
+				findEdges(tile);
+				continue;
+			}
+
+			//The last pass of an anti-aliased frame adds samples to the edges
+			if (pass > tracePasses())
+				sampleEdges(tile);
+			//Progressive frames trace a grid of pixels first, then alternate between refining the blocks that differ and filling in the rest
+			else if (sharedData->progressive)
+			{
+				if (pass % 2 == 1)
+					fillTile(tile);
+				else if (pass == 0)
+					traceGrid(tile, progressiveSpacing);
+				else
+					refineBlocks(tile, progressiveSpacing >> (pass / 2 - 1));
+			}
+			//The kept hits replace the camera rays of every pipeline
+			else if (sharedData->hitCache && sharedData->hitCache->isReshading())
+				reshadeTile(tile);
+			//The cache decides pixel by pixel whether to shade, so it replaces the pipelines tracing many rays at once
+			else if (sharedData->cache)
+				renderCached(tile);
+			//The wavefront pipeline only applies to ray tracing
+			else if (sharedData->RenderMode == renderMode::rayTrace && sharedData->pipeline == renderPipeline::wavefront)
+				renderWavefront(tile);
+			//Neighbouring camera rays usually follow the same path through the scene, so they are traced in packets when ray tracing
+			else if (sharedData->RenderMode == renderMode::rayTrace && sharedData->packetWidth > 1)
+				renderPackets(tile);
+			else
+				renderRows(tile);
+
+			//The denoiser starts from the tile once its last render pass is done
+			if (sharedData->denoiser && pass + 1 == renderPasses())
+				sharedData->denoiser->loadTile(*sharedData->radiancePixels, tile);
+
+			//Show the finished tile
+			sharedData->toneMapper.mapTile(*sharedData->radiancePixels, *sharedData->bufferPixels, tile);
+		}
+	}
+
+	//Runs a pass of the denoiser over the tile
+	void RenderThread::denoiseTile(const rtTile& tile, int pass)
+	{
+		sharedData->denoiser->filterTile(tile, pass);
+
+		//Replace the noisy pixels shown when the tile was rendered
+		if (pass + 1 == sharedData->denoiser->getPasses())
+		{
+			sharedData->denoiser->storeTile(*sharedData->denoisedPixels, tile);
+			sharedData->toneMapper.mapTile(*sharedData->denoisedPixels, *sharedData->bufferPixels, tile);
+		}
+	}
+
+	//Wait for every thread to finish the pass before the next one starts
+	bool RenderThread::finishPass()
+	{
+		unique_lock<std::mutex> handoffLock(handoff->lock);
+		int passNumber = handoff->passNumber;
+
+		//The last thread to finish hands out the tiles again and wakes the others
+		if (--handoff->passThreads == 0)
+		{
+			handoff->passCancelled = handoff->cancelled;
+
+			if (!handoff->passCancelled)
+				scheduler->repeatFrame();
+
+			handoff->passThreads = handoff->numThreads;
+			handoff->passNumber++;
+			handoff->passFinished.notify_all();
+		}
+		else
+		{
+			handoff->passFinished.wait(handoffLock, [&] { return handoff->passNumber != passNumber; });
+		}
+
+		return !handoff->passCancelled;
+	}
+
+	//Calculate the color of a single pixel based on the current render mode
+	rtColorf RenderThread::renderPixel(int row, int col, float rowOffset, float colOffset, bool keepHit)
+	{
+		//Find the grid point from the first one rather than stepping across the tile, so the image doesn't depend on the tile size.
+		//The offset is added to the row of the frame, so a band of the frame traces exactly the same rays as the whole frame.
+		rtVec3f R = sharedData->firstPoint + (sharedData->hStep * (col + colOffset)) + (sharedData->vStep * ((row + sharedData->firstRow) + rowOffset));
+		//Find new direction vector
+		rtVec3f D = (R - sharedData->camPos).normalize();
+
+		//There is no origin point for a camera ray
+		rtRayHit originPoint;
+		originPoint.hit = false;
+		//The hit of the camera ray is only kept when there are AOV buffers or a hit cache to write it to
+		rtRayHit cameraHit;
+		rtRayHit* hitTarget = (keepHit && sharedData->keepCameraHits) ? &cameraHit : nullptr;
+		rtColorf color;
+
+		//Calculate the pixel color based on the current render mode
+		switch (sharedData->RenderMode)
+		{
+		case renderMode::rayTrace:
+			color = rtRenderer::rayTrace(sharedData->objects, sharedData->lights, sharedData->camPos, D, sharedData->nearClip, sharedData->farClip, 0, sharedData->maxBounces, originPoint, hitTarget);
+			break;
+
+		case renderMode::rayMarch:
+			//To-Do: Implement ray marching
+			color = rtRenderer::rayMarch(sharedData->objects, sharedData->lights, sharedData->camPos, D, sharedData->nearClip, sharedData->farClip, 0, sharedData->maxBounces, originPoint, hitTarget);
+			break;
+
+		default:
+			//If no render mode is selected, set it to black
+			return rtColorf::black;
+		}
+
+		if (hitTarget)
+			keepCameraHit(row, col, cameraHit);
+
+		return color;
+	}
+
+	//Keep the hit of a pixel's camera ray in the hit cache and the AOV buffers
+	void RenderThread::keepCameraHit(int row, int col, const rtRayHit& hit)
+	{
+		if (sharedData->hitCache)
+			sharedData->hitCache->setHit(row * (int)sharedData->bufferWidth + col, hit);
+
+		if (sharedData->aovBuffers)
+			setAOVs(row, col, hit);
+	}
+
+	//Write the hit of a pixel's camera ray to the AOV buffers
+	void RenderThread::setAOVs(int row, int col, const rtRayHit& hit)
+	{
+		int objectID = -1;
+
+		if (hit.hit && !sharedData->objectIDs.empty())
+		{
+			auto objectEntry = sharedData->objectIDs.find(hit.hitObject);
+
+			if (objectEntry != sharedData->objectIDs.end())
+				objectID = objectEntry->second;
+		}
 
-		//The first grid point of the current row. This vector stays on the left edge of the near clip plane and moves downwards
-		rtVec3f currRow = sharedData->firstPoint + (sharedData->vStep * startRow);
-		//The current grid point. This vector is in the same row as currRowStart and moves to the right
-		rtVec3f R = currRow;
-		//The direction vector from the camera to the current point
-		rtVec3f D;
+		sharedData->aovBuffers->setPixel(row * (int)sharedData->bufferWidth + col, hit, objectID);
+	}
+
+	//Renders the tile one pixel at a time
+	void RenderThread::renderRows(const rtTile& tile)
+	{
+		int bufferWidth = sharedData->bufferPixels->getWidth();
 
 		//Iterate over all the grid points
-		for (int row = startRow; row < endRow; row++)
+		for (int row = tile.startRow; row < tile.endRow; row++)
+		{
+			//The current index in the radiance array
+			int bufferIndex = (row * bufferWidth + tile.startCol) * 3;
+
+			for (int col = tile.startCol; col < tile.endCol; col++)
+			{
+				rtColorf pixelColor = renderPixel(row, col);
+
+				//Write the color to the radiance buffer
+				(*sharedData->radiancePixels)[bufferIndex++] = pixelColor.getR();
+				(*sharedData->radiancePixels)[bufferIndex++] = pixelColor.getG();
+				(*sharedData->radiancePixels)[bufferIndex++] = pixelColor.getB();
+			}
+		}
+	}
+
+
+	//Renders the tile in square blocks of pixels
+	void RenderThread::renderPackets(const rtTile& tile)
+	{
+		int packetWidth = sharedData->packetWidth;
+		int bufferWidth = sharedData->bufferPixels->getWidth();
+
+		//Every camera ray starts at the camera
+		rtRayPacket packet;
+		packet.origin = sharedData->camPos;
+		//The color of each pixel in the block, and the hit of its camera ray when it is kept
+		rtColorf pixelColors[maxPacketSize];
+		rtRayHit cameraHits[maxPacketSize];
+		rtRayHit* hitTarget = sharedData->keepCameraHits ? cameraHits : nullptr;
+
+		for (int blockRow = tile.startRow; blockRow < tile.endRow; blockRow += packetWidth)
 		{
-			for (int col = 0; col < sharedData->bufferPixels->getWidth(); col++)
+			for (int blockCol = tile.startCol; blockCol < tile.endCol; blockCol += packetWidth)
 			{
-				//Find new direction vector
-				D = (R - sharedData->camPos).normalize();
+				packet.setSize(packetWidth * packetWidth);
+
+				//Set the direction towards each grid point of the block. Rays past the edge of the tile are left inactive.
+				for (int ray = 0; ray < packet.size; ray++)
+				{
+					int row = blockRow + ray / packetWidth;
+					int col = blockCol + ray % packetWidth;
 
-				rtColorf pixelColor;
+					if (row < tile.endRow && col < tile.endCol)
+					{
+						rtVec3f R = sharedData->firstPoint + (sharedData->hStep * col) + (sharedData->vStep * (row + sharedData->firstRow));
+						packet.setRay(ray, (R - sharedData->camPos).normalize());
+					}
+				}
 
-				//There is no origin point for a camera ray
-				rtRayHit originPoint;
-				originPoint.hit = false;
+				packet.update();
+				rtRenderer::rayTracePacket(sharedData->objects, sharedData->lights, packet, sharedData->nearClip, sharedData->farClip, sharedData->maxBounces, pixelColors, hitTarget);
 
-				//Calculate the pixel color based on the current render mode
-				switch (sharedData->RenderMode)
+				//Write the color of each pixel in the block to the radiance buffer
+				for (int ray = 0; ray < packet.size; ray++)
 				{
-				case renderMode::rayTrace:
-					pixelColor = rtRenderer::rayTrace(sharedData->objects, sharedData->lights, sharedData->camPos, D, sharedData->nearClip, sharedData->farClip, 0, sharedData->maxBounces, originPoint);
-					break;
+					if (!packet.isActive(packet.activeMasks, ray))
+						continue;
 
-				case renderMode::rayMarch:
-					//To-Do: Implement ray marching
-					pixelColor = rtRenderer::rayMarch(sharedData->objects, sharedData->lights, sharedData->camPos, D, sharedData->nearClip, sharedData->farClip, 0, sharedData->maxBounces, originPoint);
-					break;
+					int bufferIndex = ((blockRow + ray / packetWidth) * bufferWidth + blockCol + ray % packetWidth) * 3;
+
+					(*sharedData->radiancePixels)[bufferIndex++] = pixelColors[ray].getR();
+					(*sharedData->radiancePixels)[bufferIndex++] = pixelColors[ray].getG();
+					(*sharedData->radiancePixels)[bufferIndex] = pixelColors[ray].getB();
+
+					if (hitTarget)
+						keepCameraHit(blockRow + ray / packetWidth, blockCol + ray % packetWidth, cameraHits[ray]);
+				}
+			}
+		}
+	}
+
+
+	//Renders the tile one bounce at a time
+	void RenderThread::renderWavefront(const rtTile& tile)
+	{
+		int bufferWidth = sharedData->bufferPixels->getWidth();
+		int tileWidth = tile.endCol - tile.startCol;
+		int tileHeight = tile.endRow - tile.startRow;
+
+		//The direction and color of each pixel in the tile, stored row by row
+		vector<rtVec3f> directions(tileWidth * tileHeight);
+		vector<rtColorf> pixelColors;
+
+		for (int row = 0; row < tileHeight; row++)
+		{
+			for (int col = 0; col < tileWidth; col++)
+			{
+				rtVec3f R = sharedData->firstPoint + (sharedData->hStep * (tile.startCol + col)) + (sharedData->vStep * (sharedData->firstRow + tile.startRow + row));
+				directions[row * tileWidth + col] = (R - sharedData->camPos).normalize();
+			}
+		}
+
+		wavefront.render(sharedData->objects, sharedData->lights, sharedData->camPos, directions, tileWidth, tileHeight,
+			sharedData->nearClip, sharedData->farClip, sharedData->maxBounces, sharedData->packetWidth, pixelColors);
+
+		//Write the color of each pixel in the tile to the radiance buffer
+		for (int row = 0; row < tileHeight; row++)
+		{
+			int bufferIndex = ((tile.startRow + row) * bufferWidth + tile.startCol) * 3;
+
+			for (int col = 0; col < tileWidth; col++)
+			{
+				rtColorf& pixelColor = pixelColors[row * tileWidth + col];
+
+				(*sharedData->radiancePixels)[bufferIndex++] = pixelColor.getR();
+				(*sharedData->radiancePixels)[bufferIndex++] = pixelColor.getG();
+				(*sharedData->radiancePixels)[bufferIndex++] = pixelColor.getB();
+
+				if (sharedData->keepCameraHits)
+					keepCameraHit(tile.startRow + row, tile.startCol + col, wavefront.getCameraHit(row * tileWidth + col));
+			}
+		}
+	}
+
+
+	/*
+	 * Renders the tile one pixel at a time, reusing the colors of the last frame for the surfaces it saw
+	 * Every camera ray is traced, but only the hits the cache can't vouch for are shaded. With temporal anti-aliasing,
+	 * the reused pixels also shade a jittered sample and blend it in, until they hold the most samples the cache blends.
+	 */
+	void RenderThread::renderCached(const rtTile& tile)
+	{
+		rtReprojectionCache& cache = *sharedData->cache;
+		ofFloatPixels& radiance = *sharedData->radiancePixels;
+		int bufferWidth = sharedData->bufferWidth;
+		bool temporalAntiAliasing = cache.isTemporalAntiAliasing();
+		int maxTemporalSamples = cache.getMaxTemporalSamples();
+
+		//Every ray of the frame is offset by the same jitter
+		float rowOffset, colOffset;
+		cache.getJitter(rowOffset, colOffset);
+
+		//There is no origin point for a camera ray
+		rtRayHit originPoint;
+		originPoint.hit = false;
+
+		for (int row = tile.startRow; row < tile.endRow; row++)
+		{
+			for (int col = tile.startCol; col < tile.endCol; col++)
+			{
+				int pixelIndex = row * bufferWidth + col;
+				rtVec3f R = sharedData->firstPoint + (sharedData->hStep * (col + colOffset)) + (sharedData->vStep * ((row + sharedData->firstRow) + rowOffset));
+				rtVec3f D = (R - sharedData->camPos).normalize();
+
+				rtRayHit hit = (sharedData->RenderMode == renderMode::rayMarch) ?
+					rtRenderer::rayMarch(sharedData->objects, sharedData->camPos, D, sharedData->nearClip, sharedData->farClip, originPoint) :
+					rtRenderer::rayTrace(sharedData->objects, sharedData->camPos, D, sharedData->nearClip, sharedData->farClip, originPoint);
+
+				if (sharedData->keepCameraHits)
+					keepCameraHit(row, col, hit);
+
+				rtColorf previousColor;
+				int previousSamples = 0;
+				bool seenBefore = cache.findPrevious(hit, pixelIndex, previousColor, previousSamples);
+				int pixelSamples = 1;
+				rtColorf color;
+
+				//Reuse the color unless the pixel is due a refresh, or hasn't gathered every temporal sample yet
+				if (seenBefore && !cache.refreshDue(pixelIndex) && !(temporalAntiAliasing && previousSamples < maxTemporalSamples))
+				{
+					color = previousColor;
+					pixelSamples = previousSamples;
+				}
+				else
+				{
+					color = rtRenderer::shadeHit(sharedData->RenderMode, sharedData->objects, sharedData->lights, sharedData->camPos, D,
+						sharedData->nearClip, sharedData->farClip, sharedData->maxBounces, hit);
+
+					//Blend the new sample into the samples of the last frames, weighing each equally until the most samples are reached
+					if (seenBefore && temporalAntiAliasing)
+					{
+						pixelSamples = min(previousSamples + 1, maxTemporalSamples);
+						float weight = 1.0f / pixelSamples;
+						color = previousColor * (1.0f - weight) + color * weight;
+					}
+				}
 
-				default:
-					//If no render mode is selected, set it to black
-					pixelColor = rtColorf::black;
+				cache.setPixel(pixelIndex, hit, pixelSamples);
+				radiance[pixelIndex * 3] = color.getR();
+				radiance[pixelIndex * 3 + 1] = color.getG();
+				radiance[pixelIndex * 3 + 2] = color.getB();
+			}
+		}
+	}
+
+
+	/*
+	 * Shades the hits of the tile's camera rays kept in the hit cache
+	 * The hits are where the camera rays of an earlier frame landed, so only the shadow rays and reflections are traced.
+	 * The AOVs are written again, since the albedo changes with the materials.
+	 */
+	void RenderThread::reshadeTile(const rtTile& tile)
+	{
+		const rtHitCache& hitCache = *sharedData->hitCache;
+		ofFloatPixels& radiance = *sharedData->radiancePixels;
+		int bufferWidth = sharedData->bufferWidth;
+
+		for (int row = tile.startRow; row < tile.endRow; row++)
+		{
+			for (int col = tile.startCol; col < tile.endCol; col++)
+			{
+				int pixelIndex = row * bufferWidth + col;
+				const rtRayHit& hit = hitCache.getHit(pixelIndex);
+				//The reflections bounce off in the direction of the camera ray
+				rtVec3f R = sharedData->firstPoint + (sharedData->hStep * col) + (sharedData->vStep * (row + sharedData->firstRow));
+				rtVec3f D = (R - sharedData->camPos).normalize();
+
+				rtColorf color = rtRenderer::shadeHit(sharedData->RenderMode, sharedData->objects, sharedData->lights, sharedData->camPos, D,
+					sharedData->nearClip, sharedData->farClip, sharedData->maxBounces, hit);
+
+				if (sharedData->aovBuffers)
+					setAOVs(row, col, hit);
+
+				radiance[pixelIndex * 3] = color.getR();
+				radiance[pixelIndex * 3 + 1] = color.getG();
+				radiance[pixelIndex * 3 + 2] = color.getB();
+			}
+		}
+	}
+
+
+	///Progressive rendering methods
+	//Trace the pixels of the tile that lie on the grid with the given spacing
+	void RenderThread::traceGrid(const rtTile& tile, int spacing)
+	{
+		for (int row = tile.startRow; row < tile.endRow; row++)
+			for (int col = tile.startCol; col < tile.endCol; col++)
+				if (onGrid(row, col, spacing))
+					setPixel(row, col, renderPixel(row, col));
+	}
+
+	/*
+	 * Trace the grid points of half the given spacing that lie on a block of the given width whose corners differ
+	 * These are the corners of the blocks of the next pass. Each point is traced by the thread rendering the tile it lies in,
+	 * and the blocks are checked using only the corners traced in earlier passes, so no pixel is traced twice.
+	 */
+	void RenderThread::refineBlocks(const rtTile& tile, int blockWidth)
+	{
+		int bufferWidth = sharedData->bufferWidth;
+		int bufferHeight = sharedData->bufferHeight;
+		int halfWidth = blockWidth / 2;
+
+		for (int row = tile.startRow; row < tile.endRow; row++)
+		{
+			for (int col = tile.startCol; col < tile.endCol; col++)
+			{
+				//Only new points of the finer grid are traced
+				if (!onGrid(row, col, halfWidth) || onGrid(row, col, blockWidth) || sharedData->traced[row * bufferWidth + col])
+					continue;
+
+				//A point on the edge of a block is shared with the block before it
+				int firstBlockRow = (row / blockWidth) * blockWidth;
+				int firstBlockCol = (col / blockWidth) * blockWidth;
+				bool refine = false;
+
+				for (int blockRow = firstBlockRow; blockRow >= firstBlockRow - blockWidth && !refine; blockRow -= blockWidth)
+				{
+					for (int blockCol = firstBlockCol; blockCol >= firstBlockCol - blockWidth && !refine; blockCol -= blockWidth)
+					{
+						//Skip the blocks that don't contain the point. The blocks on the last row and column are clipped to the frame.
+						if (blockRow < 0 || blockCol < 0 || row > min(blockRow + blockWidth, bufferHeight - 1) || col > min(blockCol + blockWidth, bufferWidth - 1))
+							continue;
+
+						refine = blockDiffers(blockRow, blockCol, blockWidth);
+					}
+				}
+
+				if (refine)
+					setPixel(row, col, renderPixel(row, col));
+			}
+		}
+	}
+
+	//Returns true if every corner of the block is traced and the corner colors differ by more than the threshold
+	bool RenderThread::blockDiffers(int blockRow, int blockCol, int blockWidth)
+	{
+		int bufferWidth = sharedData->bufferWidth;
+		int lastRow = min(blockRow + blockWidth, (int)sharedData->bufferHeight - 1);
+		int lastCol = min(blockCol + blockWidth, bufferWidth - 1);
+
+		int corners[4] = { blockRow * bufferWidth + blockCol, blockRow * bufferWidth + lastCol, lastRow * bufferWidth + blockCol, lastRow * bufferWidth + lastCol };
+
+		//A corner that was interpolated belongs to a block that was already found to be smooth
+		for (int corner = 0; corner < 4; corner++)
+			if (!sharedData->traced[corners[corner]])
+				return false;
+
+		//The threshold is a fraction of the full color range. The corners are compared as they are shown, after tone mapping.
+		int threshold = (int)(sharedData->refineThreshold * 255.0f);
+
+		for (int channel = 0; channel < 3; channel++)
+		{
+			int minValue = 255;
+			int maxValue = 0;
+
+			for (int corner = 0; corner < 4; corner++)
+			{
+				int value = (*sharedData->bufferPixels)[corners[corner] * 3 + channel];
+				minValue = min(minValue, value);
+				maxValue = max(maxValue, value);
+			}
+
+			if (maxValue - minValue > threshold)
+				return true;
+		}
+
+		return false;
+	}
+
+	//Interpolate each untraced pixel of the tile from the corners of the smallest traced block around it
+	void RenderThread::fillTile(const rtTile& tile)
+	{
+		int bufferWidth = sharedData->bufferWidth;
+		int bufferHeight = sharedData->bufferHeight;
+		ofFloatPixels& radiance = *sharedData->radiancePixels;
+
+		for (int row = tile.startRow; row < tile.endRow; row++)
+		{
+			for (int col = tile.startCol; col < tile.endCol; col++)
+			{
+				if (sharedData->traced[row * bufferWidth + col])
+					continue;
+
+				//The blocks of the first grid always have traced corners
+				for (int blockWidth = 2; blockWidth <= progressiveSpacing; blockWidth *= 2)
+				{
+					int blockRow = (row / blockWidth) * blockWidth;
+					int blockCol = (col / blockWidth) * blockWidth;
+					int lastRow = min(blockRow + blockWidth, bufferHeight - 1);
+					int lastCol = min(blockCol + blockWidth, bufferWidth - 1);
+
+					int topLeft = blockRow * bufferWidth + blockCol;
+					int topRight = blockRow * bufferWidth + lastCol;
+					int bottomLeft = lastRow * bufferWidth + blockCol;
+					int bottomRight = lastRow * bufferWidth + lastCol;
+
+					if (!sharedData->traced[topLeft] || !sharedData->traced[topRight] || !sharedData->traced[bottomLeft] || !sharedData->traced[bottomRight])
+						continue;
+
+					//Blend the radiance of the corners bilinearly. Blocks clipped to a single row or column use the first corner on that axis.
+					float colWeight = (lastCol > blockCol) ? (float)(col - blockCol) / (lastCol - blockCol) : 0.0f;
+					float rowWeight = (lastRow > blockRow) ? (float)(row - blockRow) / (lastRow - blockRow) : 0.0f;
+
+					for (int channel = 0; channel < 3; channel++)
+					{
+						float top = radiance[topLeft * 3 + channel] * (1.0f - colWeight) + radiance[topRight * 3 + channel] * colWeight;
+						float bottom = radiance[bottomLeft * 3 + channel] * (1.0f - colWeight) + radiance[bottomRight * 3 + channel] * colWeight;
+						radiance[(row * bufferWidth + col) * 3 + channel] = top * (1.0f - rowWeight) + bottom * rowWeight;
+					}
+
+					//Hit data can't be blended, so the pixel takes the outputs of the nearest corner
+					if (sharedData->aovBuffers)
+					{
+						int nearestCorner = (rowWeight < 0.5f) ? ((colWeight < 0.5f) ? topLeft : topRight) : ((colWeight < 0.5f) ? bottomLeft : bottomRight);
+						sharedData->aovBuffers->copyPixel(nearestCorner, row * bufferWidth + col);
+					}
+
+					break;
 				}
-				
-				
-				//Write the color to the pixel buffer
-				(*sharedData->bufferPixels)[bufferIndex++] = (int)(pixelColor.getR() * 255.0f);
-				(*sharedData->bufferPixels)[bufferIndex++] = (int)(pixelColor.getG() * 255.0f);
-				(*sharedData->bufferPixels)[bufferIndex++] = (int)(pixelColor.getB() * 255.0f);
+			}
+		}
+	}
+
+	//Returns true if the pixel lies on the grid with the given spacing
+	bool RenderThread::onGrid(int row, int col, int spacing)
+	{
+		return (row % spacing == 0 || row == sharedData->bufferHeight - 1) && (col % spacing == 0 || col == sharedData->bufferWidth - 1);
+	}
+
+	//Write a traced pixel to the radiance buffer and mark it as traced
+	void RenderThread::setPixel(int row, int col, const rtColorf& color)
+	{
+		int pixelIndex = row * sharedData->bufferWidth + col;
+
+		(*sharedData->radiancePixels)[pixelIndex * 3] = color.getR();
+		(*sharedData->radiancePixels)[pixelIndex * 3 + 1] = color.getG();
+		(*sharedData->radiancePixels)[pixelIndex * 3 + 2] = color.getB();
+		sharedData->traced[pixelIndex] = 1;
+	}
 
-				//Iterate to the next column
-				R += sharedData->hStep;
+
+	///Anti-aliasing methods
+	//Mark the pixels of the tile whose color differs from a neighbouring pixel by more than the threshold
+	void RenderThread::findEdges(const rtTile& tile)
+	{
+		int bufferWidth = sharedData->bufferWidth;
+		int bufferHeight = sharedData->bufferHeight;
+		ofPixels& pixels = *sharedData->bufferPixels;
+		//The pixels are compared as they are shown, after tone mapping
+		int threshold = (int)(sharedData->antiAliasThreshold * 255.0f);
+
+		for (int row = tile.startRow; row < tile.endRow; row++)
+		{
+			for (int col = tile.startCol; col < tile.endCol; col++)
+			{
+				int pixelIndex = row * bufferWidth + col;
+				//The pixels to each side. Pixels on the edges of the frame compare with themselves on that side.
+				int neighbours[4] = { (col > 0) ? pixelIndex - 1 : pixelIndex, (col + 1 < bufferWidth) ? pixelIndex + 1 : pixelIndex,
+					(row > 0) ? pixelIndex - bufferWidth : pixelIndex, (row + 1 < bufferHeight) ? pixelIndex + bufferWidth : pixelIndex };
+
+				//Each pixel only marks itself, so both sides of an edge are marked without writing to another thread's tile
+				for (int neighbour = 0; neighbour < 4 && !sharedData->edges[pixelIndex]; neighbour++)
+					for (int channel = 0; channel < 3; channel++)
+						if (abs(pixels[pixelIndex * 3 + channel] - pixels[neighbours[neighbour] * 3 + channel]) > threshold)
+							sharedData->edges[pixelIndex] = 1;
 			}
+		}
+	}
+
+	/*
+	 * Add jittered samples to the marked pixels of the tile until their color settles or the sample budget is spent
+	 * The samples are taken in groups of four, one in each quarter of the pixel. After each group the pixel stops once the
+	 * standard error of its mean brightness is below a quarter of the threshold, so smooth gradients stop early and hard edges take every sample.
+	 */
+	void RenderThread::sampleEdges(const rtTile& tile)
+	{
+		int bufferWidth = sharedData->bufferWidth;
+		ofFloatPixels& radiance = *sharedData->radiancePixels;
+		float maxError = sharedData->antiAliasThreshold / 4.0f;
+
+		for (int row = tile.startRow; row < tile.endRow; row++)
+		{
+			for (int col = tile.startCol; col < tile.endCol; col++)
+			{
+				int pixelIndex = row * bufferWidth + col;
+
+				if (!sharedData->edges[pixelIndex])
+					continue;
+
+				//The jitter follows the pixel's place in the frame, so a band gets the same samples as the whole frame
+				unsigned int framePixel = (unsigned int)(row + sharedData->firstRow) * bufferWidth + col;
+
+				//Start from the sample already traced through the pixel's grid point
+				float sum[3] = { radiance[pixelIndex * 3], radiance[pixelIndex * 3 + 1], radiance[pixelIndex * 3 + 2] };
+				//The running mean and sum of squared differences of the brightness of the samples
+				float mean = (sum[0] + sum[1] + sum[2]) / 3.0f;
+				float squaredDiffs = 0.0f;
+				int samples = 1;
+
+				while (samples < sharedData->maxSamples)
+				{
+					int groupSize = min(4, sharedData->maxSamples - samples);
 
-			//After a row is completed, move to the next row
-			currRow += sharedData->vStep;
-			R = currRow;
+					for (int quarter = 0; quarter < groupSize; quarter++)
+					{
+						//The samples cover the square of the pixel centered on its grid point
+						float rowOffset = ((quarter / 2) + jitter(framePixel, samples * 2)) / 2.0f - 0.5f;
+						float colOffset = ((quarter % 2) + jitter(framePixel, samples * 2 + 1)) / 2.0f - 0.5f;
+						rtColorf sample = renderPixel(row, col, rowOffset, colOffset, false);
+
+						sum[0] += sample.getR();
+						sum[1] += sample.getG();
+						sum[2] += sample.getB();
+						samples++;
+
+						//Welford's method keeps the variance accurate without storing the samples
+						float brightness = (sample.getR() + sample.getG() + sample.getB()) / 3.0f;
+						float delta = brightness - mean;
+						mean += delta / samples;
+						squaredDiffs += delta * (brightness - mean);
+					}
+
+					if (sqrtf(squaredDiffs / (samples - 1) / samples) < maxError)
+						break;
+				}
+
+				for (int channel = 0; channel < 3; channel++)
+					radiance[pixelIndex * 3 + channel] = sum[channel] / samples;
+			}
 		}
 	}
 
+	//Hash the pixel and sample index into a random number between 0 and 1
+	float RenderThread::jitter(unsigned int pixel, unsigned int sample)
+	{
+		//The PCG output permutation of the combined index
+		unsigned int state = pixel * 747796405u + sample * 2891336453u + 2891336453u;
+		unsigned int word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+		word = (word >> 22u) ^ word;
+
+		//The top 24 bits fit exactly in a float
+		return (word >> 8) * (1.0f / 16777216.0f);
+	}
+
 
-	rtRenderThreadPool::rtRenderThreadPool()
+	rtRenderThreadPool::rtRenderThreadPool(int numThreads) : numThreads((numThreads > 0) ? numThreads : defaultThreads)
 	{
 		//Instantiate the thread pool
-		threadPool = make_unique<RenderThread[]>(numThreads);
+		threadPool = make_unique<RenderThread[]>(this->numThreads);
+		//Give each thread its own queue of tiles
+		scheduler = make_unique<rtTileScheduler>(this->numThreads);
+		handoff.numThreads = this->numThreads;
+
+		//Start the threads, which wait until the first frame is started
+		for (int threadIndex = 0; threadIndex < this->numThreads; threadIndex++)
+		{
+			threadPool[threadIndex].setPool(&handoff, scheduler.get(), threadIndex);
+			threadPool[threadIndex].startThread();
+		}
+	}
+
+	rtRenderThreadPool::~rtRenderThreadPool()
+	{
+		waitForFrame();
+
+		//Wake the waiting threads so they can exit
+		{
+			lock_guard<mutex> handoffLock(handoff.lock);
+			handoff.closing = true;
+		}
+
+		handoff.frameStarted.notify_all();
+
+		for (int threadIndex = 0; threadIndex < numThreads; threadIndex++)
+			threadPool[threadIndex].waitForThread(false);
 	}
 
-	void rtRenderThreadPool::setData(renderMode RenderMode, shared_ptr<rtScene> scene, rtVec3f& camPos, rtVec3f& u, rtVec3f& v, rtVec3f& n,
-		float hFov, float nearClip, float farClip, int maxBounces, ofPixels* bufferPixels)
+	void rtRenderThreadPool::setData(const rtFrameSettings& settings)
 	{
+		rtFrameSettings frame = settings;
 		//Cache the pixel buffer dimensions as floats
-		float bufferWidth = bufferPixels->getWidth();
-		float bufferHeight = bufferPixels->getHeight();
+		float bufferWidth = frame.bufferPixels->getWidth();
+		float bufferHeight = frame.bufferPixels->getHeight();
+		//The grid spans the whole frame, even when the buffer only holds a band of it
+		float gridHeight = (frame.frameHeight > 0) ? frame.frameHeight : bufferHeight;
+
+		rtVec3f firstPoint, hStep, vStep;
+		calcGrid(frame.camPos, frame.u, frame.v, frame.n, frame.hFov, frame.nearClip, bufferWidth, gridHeight, firstPoint, hStep, vStep);
+
+		//Progressive frames interpolate most of their pixels, which have no hit to reproject or keep
+		if (frame.progressive)
+		{
+			frame.cache = nullptr;
+			frame.hitCache = nullptr;
+		}
+
+		if (frame.cache)
+			frame.cache->setFrame(bufferWidth, bufferHeight, frame.camPos, firstPoint, hStep, vStep);
 
+		//A denoiser without passes leaves the frame as it is
+		if (frame.denoiser && frame.denoiser->getPasses() == 0)
+			frame.denoiser = nullptr;
+
+		if (frame.denoiser)
+			frame.denoiser->setFrame(bufferWidth, bufferHeight, frame.aovBuffers);
+
+		//Save the scene data and render settings in a struct. The threads pick it up when the frame is started.
+		shared_ptr<RenderThreadData> sharedData = make_shared<RenderThreadData>(frame, firstPoint, hStep, vStep);
+
+		{
+			lock_guard<mutex> handoffLock(handoff.lock);
+			handoff.frameData = sharedData;
+		}
+
+		//Split the frame into tiles, which the threads take as they finish the previous ones
+		scheduler->setFrame(bufferWidth, bufferHeight, frame.tileSize, frame.regions);
+	}
+
+	void rtRenderThreadPool::calcGrid(rtVec3f& camPos, rtVec3f& u, rtVec3f& v, rtVec3f& n, float hFov, float nearClip, float gridWidth, float gridHeight,
+		rtVec3f& firstPoint, rtVec3f& hStep, rtVec3f& vStep)
+	{
 		//The width and height of the near clip plane based on the FOV and distance to the clip plane
 		float halfClipWidth = sin(degToRad(hFov / 2)) * nearClip;
-		float halfClipHeight = halfClipWidth * (bufferHeight / bufferWidth);
+		float halfClipHeight = halfClipWidth * (gridHeight / gridWidth);
 
 		//Calculate the point in the center of the near clip plane using the camera position and look vector
 		rtVec3f clipCenter = camPos + (-n * nearClip);
@@ -112,61 +852,53 @@ namespace rtGraphics
 		rtVec3f widthVector = u * halfClipWidth;
 		rtVec3f heightVector = v * halfClipHeight;
 		//The distance between each grid point of the near clip plane in world space
-		rtVec3f hStep = (widthVector * -2) / bufferWidth;
-		rtVec3f vStep = (heightVector * -2) / bufferHeight;
+		hStep = (widthVector * -2) / gridWidth;
+		vStep = (heightVector * -2) / gridHeight;
 
 		//The first grid point, at the top-left corner
-		rtVec3f firstPoint = clipCenter + widthVector + heightVector;
-
-		//Save the scene data and render settings in a struct
-		sharedData = make_shared<RenderThreadData>(RenderMode, scene, camPos, nearClip, farClip, maxBounces, bufferPixels, firstPoint, hStep, vStep);
-
-		//The minimum number of rows each thread will render
-		int baseRows = bufferHeight / numThreads;
-		//The number of threads that will render an additional row
-		int extraRows = bufferHeight - (numThreads * baseRows);
-		//The starting row of the next section
-		int sectionStart = 0;
+		firstPoint = clipCenter + widthVector + heightVector;
+	}
 
-		//Spawn threads to render all of the image
-		for (int threadIndex = 0; threadIndex < numThreads; threadIndex++)
+	void rtRenderThreadPool::startFrame()
+	{
 		{
-			//Calculate the end of the section
-			int sectionEnd = sectionStart + baseRows;
-
-			//Add an extra row until all the extra rows are allocated
-			if (threadIndex < extraRows)
-				sectionEnd++;
-
-			//Set the shared data and section to render
-			threadPool[threadIndex].setData(sharedData);
-			threadPool[threadIndex].setSection(sectionStart, sectionEnd);
-
-			//Move onto the next section
-			sectionStart = sectionEnd;
+			lock_guard<mutex> handoffLock(handoff.lock);
+			handoff.frameNumber++;
+			handoff.busyThreads = numThreads;
+			handoff.passThreads = numThreads;
+			handoff.cancelled = false;
+			handoff.passCancelled = false;
 		}
+
+		handoff.frameStarted.notify_all();
 	}
 
-	void rtRenderThreadPool::startThreads()
+	void rtRenderThreadPool::waitForFrame()
 	{
-		for (int threadIndex = 0; threadIndex < numThreads; threadIndex++)
-			if (!threadPool[threadIndex].isThreadRunning())
-				threadPool[threadIndex].startThread();
+		unique_lock<mutex> handoffLock(handoff.lock);
+		handoff.frameFinished.wait(handoffLock, [&] { return handoff.busyThreads == 0; });
 	}
 
-	void rtRenderThreadPool::joinThreads()
+	void rtRenderThreadPool::cancelFrame()
 	{
-		for (int threadIndex = 0; threadIndex < numThreads; threadIndex++)
-			if (threadPool[threadIndex].isThreadRunning())
-				threadPool[threadIndex].waitForThread();
+		//Skip the remaining passes of a frame
+		{
+			lock_guard<mutex> handoffLock(handoff.lock);
+			handoff.cancelled = true;
+		}
+
+		//The threads check for tiles between tiles, so emptying the queues stops them
+		scheduler->cancel();
 	}
 
-	bool rtRenderThreadPool::threadsRunning()
+	bool rtRenderThreadPool::frameRunning()
 	{
-		for (int threadIndex = 0; threadIndex < numThreads; threadIndex++)
-			if (~threadPool[threadIndex].isThreadRunning())
-				return false;
+		lock_guard<mutex> handoffLock(handoff.lock);
+		return handoff.busyThreads > 0;
+	}
 
-		return true;
+	int rtRenderThreadPool::getDefaultThreads()
+	{
+		return defaultThreads;
 	}
 }
\ No newline at end of file
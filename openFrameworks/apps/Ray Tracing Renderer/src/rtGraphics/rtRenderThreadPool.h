@@ -1,8 +1,16 @@
 #pragma once
 
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
 #include "memory.h"
 #include "rtRenderer.h"
+#include "rtWavefrontRenderer.h"
+#include "rtTileScheduler.h"
+#include "rtHitCache.h"
+#include "rtFrameSettings.h"
+#include "rtToneMapper.h"
 #include "Data Classes/Data Types.h"
 
 namespace rtGraphics
@@ -11,82 +19,210 @@ namespace rtGraphics
 	struct RenderThreadData
 	{
 	public:
-		RenderThreadData(renderMode RenderMode, shared_ptr<rtScene>scene, rtVec3f& camPos, float nearClip, float farClip,
-			int maxBounces, ofPixels* bufferPixels, rtVec3f& firstPoint, rtVec3f& hStep, rtVec3f& vStep);
+		//Copy the settings of the frame, which is traced through the grid of points on the near plane given by the first point and steps
+		RenderThreadData(const rtFrameSettings& settings, rtVec3f& firstPoint, rtVec3f& hStep, rtVec3f& vStep);
 
 		//Render data
 		renderMode RenderMode;
-		//Scene data
-		objectSet objects;
+		renderPipeline pipeline;
+		//Scene data. The object hierarchy is rebuilt for each render so that moved objects are accounted for.
+		rtSceneBVH objects;
 		lightSet lights;
 		//Camera data
 		rtVec3f camPos;
 		float nearClip, farClip;
 		int maxBounces;
-		//Output buffer data
+		//The width of the blocks of pixels whose camera rays are traced together
+		int packetWidth;
+		//Progressive frames trace a coarse grid of pixels first and only refine the blocks whose corners differ by more than the threshold
+		bool progressive;
+		float refineThreshold;
+		//Marks the pixels of a progressive frame that have been traced rather than interpolated
+		vector<unsigned char> traced;
+		//Anti-aliased frames take up to the maximum number of samples in the pixels that differ from a neighbour by more than the threshold
+		int maxSamples;
+		float antiAliasThreshold;
+		//Marks the pixels of an anti-aliased frame that get extra samples
+		vector<unsigned char> edges;
+		//Output buffer data. The threads trace into the radiance buffer and tone map each finished tile to the pixel buffer.
+		ofFloatPixels* radiancePixels;
 		ofPixels* bufferPixels;
+		//The optional buffers the hit of each pixel's camera ray is written to, and the index of each object in the scene for the object IDs
+		rtAOVBuffers* aovBuffers;
+		unordered_map<rtObject*, int> objectIDs;
+		//The optional cache of the last frame's colors, which the pixels of surfaces it saw reuse
+		rtReprojectionCache* cache;
+		//The optional cache of each pixel's camera ray hit, which the frame either reshades or writes the hits it traces to
+		rtHitCache* hitCache;
+		//The optional denoiser the frame is filtered by once it is traced, and the buffer the filtered radiance is written to
+		rtDenoiser* denoiser;
+		ofFloatPixels* denoisedPixels;
+		//True when the hits of the camera rays are kept, for the AOV buffers or the hit cache
+		bool keepCameraHits;
+		rtToneMapper toneMapper;
 		float bufferWidth, bufferHeight;
 		//Grid data
 		rtVec3f firstPoint, hStep, vStep;
+		//The row of the frame the buffers start at. It is only above zero when the buffers hold a band of a larger frame.
+		int firstRow;
 	};
 
 
-	//A threadable nested class that renders a portion of the final image
+	//The state the pool and its threads use to hand frames back and forth
+	struct RenderFrameHandoff
+	{
+		mutex lock;
+		//Signals the threads that a frame was started or that the pool is closing
+		condition_variable frameStarted;
+		//Signals the pool that the last busy thread finished its tiles
+		condition_variable frameFinished;
+		//The data of the latest frame
+		shared_ptr<RenderThreadData> frameData;
+		//Counts the started frames, so each thread can tell when a frame is new
+		int frameNumber = 0;
+		//The number of threads still rendering the current frame
+		int busyThreads = 0;
+		//Signals the threads that every thread finished the current pass of a frame with several passes
+		condition_variable passFinished;
+		//Counts the finished passes, so each waiting thread can tell when the pass it waits on is over
+		int passNumber = 0;
+		//The number of threads in the pool, and the number still rendering the current pass
+		int numThreads = 0;
+		int passThreads = 0;
+		//Set when the current frame is cancelled so the threads skip its remaining passes
+		bool cancelled = false;
+		//Whether the frame was cancelled when the last pass finished. The last thread of the pass decides this once for every thread,
+		//so a cancel arriving while the others wake can't make some threads stop and others start the next pass.
+		bool passCancelled = false;
+		//Set when the pool is destroyed so the threads stop waiting for frames
+		bool closing = false;
+	};
+
+
+	//A threadable nested class that waits for frames and renders their tiles until none are left
 	class RenderThread : public ofThread
 	{
 	private:
-		//Shared data
+		//Shared data of the frame being rendered
 		shared_ptr<RenderThreadData> sharedData;
-		//Instance data
-		int startRow, endRow;
+		//The handoff to wait for frames on
+		RenderFrameHandoff* handoff;
+		//The scheduler handing out the tiles, and the index of this thread's queue
+		rtTileScheduler* scheduler;
+		int threadIndex;
+		//The queues of the wavefront pipeline, kept between frames to avoid reallocating them
+		rtWavefrontRenderer wavefront;
 
-		//Renders a section of the frame buffer
+		//Waits for each frame and renders its tiles, until the pool closes
 		void threadedFunction();
+		//The spacing of the first pixels traced in a progressive frame. Each refinement pass halves it, down to every pixel.
+		static const int progressiveSpacing = 8;
+		//The first pass and a refinement for each halving of the spacing, each followed by a pass filling in the untraced pixels
+		static const int progressivePasses = 8;
 
-	public:
-		//Set the shared data
-		void setData(shared_ptr<RenderThreadData> sharedData)
-		{
-			this->sharedData = sharedData;
-		}
+		//The passes that trace the pixels of the frame, the passes rendering it including anti-aliasing, and the passes in total including denoising
+		int tracePasses();
+		int renderPasses();
+		int framePasses();
+		//Renders tiles of the frame buffer until the scheduler runs out
+		void renderTiles(int pass);
+		//Runs a pass of the denoiser over the tile, writing the filtered tile to the buffers after the last pass
+		void denoiseTile(const rtTile& tile, int pass);
+		//Wait for every thread to finish the pass before the next one starts. Returns false if the frame was cancelled.
+		bool finishPass();
+		//Calculate the color of a single pixel based on the current render mode. The offsets move the ray by a fraction of a pixel.
+		//The hit of the ray is kept, unless it is an extra sample of the pixel.
+		rtColorf renderPixel(int row, int col, float rowOffset = 0.0f, float colOffset = 0.0f, bool keepHit = true);
+		//Keep the hit of a pixel's camera ray in the hit cache and the AOV buffers
+		void keepCameraHit(int row, int col, const rtRayHit& hit);
+		//Write the hit of a pixel's camera ray to the AOV buffers
+		void setAOVs(int row, int col, const rtRayHit& hit);
+		//Renders the tile one pixel at a time
+		void renderRows(const rtTile& tile);
+		//Renders the tile in square blocks of pixels, tracing the camera rays of each block as a packet
+		void renderPackets(const rtTile& tile);
+		//Renders the tile one bounce at a time
+		void renderWavefront(const rtTile& tile);
+		//Renders the tile one pixel at a time, reusing the colors of the last frame for the surfaces it saw
+		void renderCached(const rtTile& tile);
+		//Shades the hits of the tile's camera rays kept in the hit cache, without tracing the camera rays again
+		void reshadeTile(const rtTile& tile);
 
-		//Set the section of the image to render
-		void setSection(int startRow, int endRow)
+		///Progressive rendering methods
+		//Trace the pixels of the tile that lie on the grid with the given spacing
+		void traceGrid(const rtTile& tile, int spacing);
+		//Trace the grid points of half the given spacing that lie on a block of the given width whose corners differ
+		void refineBlocks(const rtTile& tile, int blockWidth);
+		//Returns true if every corner of the block is traced and the corner colors differ by more than the threshold
+		bool blockDiffers(int blockRow, int blockCol, int blockWidth);
+		//Interpolate each untraced pixel of the tile from the corners of the smallest traced block around it
+		void fillTile(const rtTile& tile);
+		//Returns true if the pixel lies on the grid with the given spacing. The last row and column are part of every grid.
+		bool onGrid(int row, int col, int spacing);
+		//Write a traced pixel to the radiance buffer and mark it as traced
+		void setPixel(int row, int col, const rtColorf& color);
+
+		///Anti-aliasing methods
+		//Mark the pixels of the tile whose color differs from a neighbouring pixel by more than the threshold
+		void findEdges(const rtTile& tile);
+		//Add jittered samples to the marked pixels of the tile until their color settles or the sample budget is spent
+		void sampleEdges(const rtTile& tile);
+		//A random number between 0 and 1 that only depends on the pixel and sample, so the image doesn't depend on which thread renders it
+		static float jitter(unsigned int pixel, unsigned int sample);
+
+	public:
+		//Set the handoff to wait for frames on and the scheduler to take tiles from
+		void setPool(RenderFrameHandoff* handoff, rtTileScheduler* scheduler, int threadIndex)
 		{
-			this->startRow = startRow;
-			this->endRow = endRow;
+			this->handoff = handoff;
+			this->scheduler = scheduler;
+			this->threadIndex = threadIndex;
 		}
 	};
 
 
+	/*
+	 * A pool of render threads that live as long as the pool
+	 * The threads are started once and sleep between frames. Starting a frame wakes them through a condition variable,
+	 * and the last thread to run out of tiles wakes the pool, so no threads are created or destroyed per frame.
+	 */
 	class rtRenderThreadPool
 	{
 	private:
-		//The number of threads in the pool
-		static int numThreads;
-		//Shared thread data
-		shared_ptr<RenderThreadData> sharedData;
+		//The number of threads a pool has unless told otherwise
+		static int defaultThreads;
+		//The number of threads in this pool
+		int numThreads;
 		//A pool of threads to render the image
 		unique_ptr<RenderThread[]> threadPool;
+		//The tiles of the current frame
+		unique_ptr<rtTileScheduler> scheduler;
+		//The frame data and signals shared with the threads
+		RenderFrameHandoff handoff;
 
 	public:
-		//Initialize a pool of render threads
-		rtRenderThreadPool();
+		//Initialize a pool of render threads and start them. With no thread count, the pool has a thread for each core.
+		rtRenderThreadPool(int numThreads = 0);
+		//Stop the threads once they finish the current frame
+		~rtRenderThreadPool();
 
-		//Wait for any running threads to finish when the pool is destroyed
-		~rtRenderThreadPool()
-		{
-			joinThreads();
-		}
+		//Set the render settings and scene of the next frame. Must not be called while a frame is rendering. Progressive frames leave out the caches.
+		void setData(const rtFrameSettings& settings);
 
-		//Set the render settings and scene for each thread
-		void setData(renderMode RenderMode, shared_ptr<rtScene> scene, rtVec3f& camPos, rtVec3f& u, rtVec3f& v, rtVec3f& n,
-			float hFov, float nearClip, float farClip, int maxBounces, ofPixels* bufferPixels);
+		//Find the grid of points on the near clip plane that the camera ray of each pixel passes through, starting at the top-left corner
+		static void calcGrid(rtVec3f& camPos, rtVec3f& u, rtVec3f& v, rtVec3f& n, float hFov, float nearClip, float gridWidth, float gridHeight,
+			rtVec3f& firstPoint, rtVec3f& hStep, rtVec3f& vStep);
 
-		//Thread management methods
-		void startThreads();
-		void joinThreads();
-		//Returns true if any thread in the pool is still running
-		bool threadsRunning();
+		//Frame management methods
+		//Wake the threads to render the frame set by setData
+		void startFrame();
+		//Wait until every thread has finished the current frame
+		void waitForFrame();
+		//Stop the current frame once the tiles being rendered are finished. Returns without waiting for them.
+		void cancelFrame();
+		//Returns true if any thread in the pool is still rendering the current frame
+		bool frameRunning();
+		//The number of threads a pool has when no thread count is given
+		static int getDefaultThreads();
 	};
 }
\ No newline at end of file
@@ -2,30 +2,40 @@
 
 namespace rtGraphics
 {
-	rtRenderer::rtRenderer()
+	rtRenderer::rtRenderer(int numThreads)
 	{
-		threadPool = make_unique<rtRenderThreadPool>();
+		threadPool = make_unique<rtRenderThreadPool>(numThreads);
 	}
 
-	void rtRenderer::render(renderMode RenderMode, shared_ptr<rtScene> scene, rtVec3f& camPos, rtVec3f& u, rtVec3f& v, rtVec3f& n,
-		float hFov, float nearClip, float farClip, int maxBounces, ofPixels* bufferPixels)
+	void rtRenderer::render(const rtFrameSettings& settings)
 	{
-		//Wait for any currently running threads to finish first
-		threadPool->joinThreads();
-		//Set the render settings and start the threads
-		threadPool->setData(RenderMode, scene, camPos, u, v, n, hFov, nearClip, farClip, maxBounces, bufferPixels);
-		threadPool->startThreads();
+		//Wait for the previous frame to finish first
+		threadPool->waitForFrame();
+		//Set the render settings and wake the threads
+		threadPool->setData(settings);
+		threadPool->startFrame();
 	}
 
 	void rtRenderer::waitForRender()
 	{
-		threadPool->joinThreads();
+		threadPool->waitForFrame();
+	}
+
+	void rtRenderer::cancelRender()
+	{
+		threadPool->cancelFrame();
+		threadPool->waitForFrame();
+	}
+
+	bool rtRenderer::isRendering()
+	{
+		return threadPool->frameRunning();
 	}
 
 
 	///Helper methods
 	//Given a hit point, shade the point using the Phong shading method
-	rtColorf rtRenderer::calcPixelColor(renderMode RenderMode, objectSet& objects, lightSet& lights, rtVec3f& P, rtVec3f& D,
+	rtColorf rtRenderer::calcPixelColor(renderMode RenderMode, rtSceneBVH& objects, lightSet& lights, rtVec3f& P, rtVec3f& D,
 		float nearClip, float farClip, int currBounce, int maxBounces, rtRayHit hitData)
 	{
 		//If the ray didn't intersect any objects, return a black pixel
@@ -93,14 +103,13 @@ namespace rtGraphics
 				finalColor = (objectColor * (1 - reflectivity)) + (reflectedColor * reflectivity) + specular;
 			}
 
-			//Clamp the values of the final color and return it
-			finalColor.clampColors();
+			//The color is left unclamped, so bright highlights and reflections keep their radiance until the frame is tone mapped
 			return finalColor;
 		}
 	}
 
 	//Bounce a ray off of the object it hits and find the reflected color
-	rtColorf rtRenderer::bounceRay(renderMode RenderMode, objectSet& objects, lightSet& lights, rtVec3f& P, rtVec3f& D,
+	rtColorf rtRenderer::bounceRay(renderMode RenderMode, rtSceneBVH& objects, lightSet& lights, rtVec3f& P, rtVec3f& D,
 		float nearClip, float farClip, int currBounce, int maxBounces, rtRayHit hitData)
 	{
 		//If the ray has already bounced too many times return black
@@ -130,24 +139,21 @@ namespace rtGraphics
 	}
 
 	//Determine if a given light shines on a point or is occluded
-	bool rtRenderer::isShadow(renderMode RenderMode, objectSet& objects, rtVec3f& lightVector, rtVec3f& targetPoint, float lightDistSquared, float nearClip, float farClip, rtRayHit originPoint)
+	bool rtRenderer::isShadow(renderMode RenderMode, rtSceneBVH& objects, rtVec3f& lightVector, rtVec3f& targetPoint, float lightDistSquared, float nearClip, float farClip, rtRayHit originPoint)
 	{
+		//When ray tracing, only check if any object lies between the point and the light without finding the closest one
+		if (RenderMode == renderMode::rayTrace)
+			return objects.occluded(targetPoint, lightVector, nearClip, fminf(sqrtf(lightDistSquared), farClip), originPoint);
+
 		//Cast a ray from the hit point towards the light source to check if the light is occluded
 		rtRayHit shadowRay;
 
-		//Compute if the point is in shadow using the current rendering mode
-		switch (RenderMode)
-		{
-		case renderMode::rayTrace:
-			shadowRay = rayTrace(objects, targetPoint, lightVector, nearClip, farClip, originPoint);
-			break;
-		case renderMode::rayMarch:
+		//Compute if the point is in shadow using ray marching
+		if (RenderMode == renderMode::rayMarch)
 			shadowRay = rayMarch(objects, targetPoint, lightVector, nearClip, farClip, originPoint);
-			break;
-		default:
-			//If no rendering mode was specified, exit the method
+		//If no rendering mode was specified, exit the method
+		else
 			return false;
-		}
 
 		//If they ray doesn't hit anything, return false
 		if (!shadowRay.hit)
@@ -168,39 +174,49 @@ namespace rtGraphics
 
 	///Ray tracing methods
 	//Ray trace a single ray and return the color at the intersection
-	rtColorf rtRenderer::rayTrace(objectSet& objects, lightSet& lights, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, int currBounce, int maxBounces, rtRayHit originPoint)
+	rtColorf rtRenderer::rayTrace(rtSceneBVH& objects, lightSet& lights, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, int currBounce, int maxBounces, rtRayHit originPoint, rtRayHit* cameraHit)
 	{
 		//Find the closest object the ray hits
 		rtRayHit hitData = rayTrace(objects, P, D, nearClip, farClip, originPoint);
+
+		if (cameraHit)
+			*cameraHit = hitData;
+
 		//Calculate the color of that point
 		return calcPixelColor(renderMode::rayTrace, objects, lights, P, D, nearClip, farClip, currBounce, maxBounces, hitData);
 	}
 
 	//Ray trace a single ray and return the ray hit data
-	rtRayHit rtRenderer::rayTrace(objectSet& objects, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, rtRayHit originPoint)
+	rtRayHit rtRenderer::rayTrace(rtSceneBVH& objects, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, rtRayHit originPoint)
 	{
-		//The intersection data of the closest intersection
-		rtRayHit nearestHit;
-		//Set the hit data to a miss by default.
-		nearestHit.hit = false;
-		nearestHit.distance = INFINITY;
+		//Find the closest intersection using the scene hierarchy
+		return objects.rayIntersect(P, D, nearClip, farClip, originPoint);
+	}
 
-		//Iterate over the all the objects
-		for (int objectIndex = 0; objectIndex < objects->size(); objectIndex++)
-		{
-			//Get a pointer to the current object
-			rtObject* currObject = objects->at(objectIndex);
+	//Ray trace a packet of camera rays and calculate the color of each ray
+	void rtRenderer::rayTracePacket(rtSceneBVH& objects, lightSet& lights, rtRayPacket& packet, float nearClip, float farClip, int maxBounces, rtColorf* colors, rtRayHit* cameraHits)
+	{
+		//Find the closest object each ray hits
+		rtRayHit localHits[maxPacketSize];
+		rtRayHit* hits = cameraHits ? cameraHits : localHits;
+		objects.rayIntersectPacket(packet, nearClip, farClip, hits);
 
-			//Determine if the ray intersects the object
-			rtRayHit hitData = currObject->rayIntersect(P, D, nearClip, farClip, originPoint);
+		//Shade each hit on its own, since the shadow and reflected rays no longer share an origin
+		for (int ray = 0; ray < packet.size; ray++)
+		{
+			if (!packet.isActive(packet.activeMasks, ray))
+				continue;
 
-			//If the ray hit and the object is not obscured, save hit data
-			if (hitData.hit && hitData.distance < nearestHit.distance)
-				nearestHit = hitData;
+			rtVec3f D = packet.directions[ray];
+			colors[ray] = calcPixelColor(renderMode::rayTrace, objects, lights, packet.origin, D, nearClip, farClip, 0, maxBounces, hits[ray]);
 		}
+	}
+
 
-		//Return the hit data
-		return nearestHit;
+	//Shade the hit of a camera ray traced beforehand
+	rtColorf rtRenderer::shadeHit(renderMode RenderMode, rtSceneBVH& objects, lightSet& lights, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, int maxBounces, const rtRayHit& hitData)
+	{
+		return calcPixelColor(RenderMode, objects, lights, P, D, nearClip, farClip, 0, maxBounces, hitData);
 	}
 
 
@@ -211,19 +227,25 @@ namespace rtGraphics
 
 	///Ray marching methods
 	//Ray trace a single ray and return the color at the intersection
-	rtColorf rtRenderer::rayMarch(objectSet& objects, lightSet& lights, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, int currBounce, int maxBounces, rtRayHit originPoint)
+	rtColorf rtRenderer::rayMarch(rtSceneBVH& objects, lightSet& lights, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, int currBounce, int maxBounces, rtRayHit originPoint, rtRayHit* cameraHit)
 	{
 		//Find the closest object the ray hits
 		rtRayHit hitData = rayMarch(objects, P, D, nearClip, farClip, originPoint);
+
+		if (cameraHit)
+			*cameraHit = hitData;
+
 		//Calculate the color of that point
 		return calcPixelColor(renderMode::rayMarch, objects, lights, P, D, nearClip, farClip, currBounce, maxBounces, hitData);
 	}
 
 	//Ray trace a single ray and return the ray hit data
-	rtRayHit rtRenderer::rayMarch(objectSet& objects, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, rtRayHit originPoint)
+	rtRayHit rtRenderer::rayMarch(rtSceneBVH& objects, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, rtRayHit originPoint)
 	{
 		//The intersection data of the closest intersection
 		rtRayHit hitData;
+		//Signed distance functions are evaluated for every object
+		objectSet& objectList = objects.getObjects();
 		//Make a copy of the ray to march forward
 		rtVec3f marchedRay = P;
 
@@ -234,10 +256,10 @@ namespace rtGraphics
 			float nearestDist = INFINITY;
 
 			//Iterate over the all the objects
-			for (int objectIndex = 0; objectIndex < objects->size(); objectIndex++)
+			for (int objectIndex = 0; objectIndex < objectList->size(); objectIndex++)
 			{
 				//Get a pointer to the current object
-				rtObject* currObject = objects->at(objectIndex);
+				rtObject* currObject = objectList->at(objectIndex);
 
 				//Determine the distance from the ray to the current object
 				hitData = currObject->sdf(marchedRay);
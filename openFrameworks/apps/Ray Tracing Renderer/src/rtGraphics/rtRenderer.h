@@ -7,6 +7,12 @@
 #include "ofThread.h"
 #include "Data Classes/rtScene.h"
 #include "Data Classes/Data Types.h"
+#include "Data Classes/rtAOVBuffers.h"
+#include "rtReprojectionCache.h"
+#include "rtTileScheduler.h"
+#include "rtHitCache.h"
+#include "rtFrameSettings.h"
+#include "Acceleration Structures/rtSceneBVH.h"
 #include "PhongShader.h"
 #include "rtRenderThreadPool.h"
 
@@ -34,34 +40,47 @@ namespace rtGraphics
 
 		///Helper methods
 		//Given a hit point, shade the point using the Phong shading method
-		static rtColorf calcPixelColor(renderMode RenderMode, objectSet& objects, lightSet& lights, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, int currBounce, int maxBounces, rtRayHit hitData);
+		static rtColorf calcPixelColor(renderMode RenderMode, rtSceneBVH& objects, lightSet& lights, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, int currBounce, int maxBounces, rtRayHit hitData);
 		//Bounce the ray off of an object and calculate the color at the next intersection point
-		static rtColorf bounceRay(renderMode RenderMode, objectSet& objects, lightSet& lights, rtVec3f& P, rtVec3f& D,float nearClip, float farClip, int currBounce, int maxBounces, rtRayHit hitData);
+		static rtColorf bounceRay(renderMode RenderMode, rtSceneBVH& objects, lightSet& lights, rtVec3f& P, rtVec3f& D,float nearClip, float farClip, int currBounce, int maxBounces, rtRayHit hitData);
 		//Determine, using ray tracing, if a given light shines on the target point or is occluded. The ray hit point is required to resolve surface intersection issues.
-		static bool isShadow(renderMode RenderMode, objectSet& objects, rtVec3f& lightVector, rtVec3f& targetPoint, float lightDistSquared, float nearClip, float farClip, rtRayHit originPoint);
+		static bool isShadow(renderMode RenderMode, rtSceneBVH& objects, rtVec3f& lightVector, rtVec3f& targetPoint, float lightDistSquared, float nearClip, float farClip, rtRayHit originPoint);
 
 		///Ray marching methods
 		//Update the normal of an rtRayHit struct
 		static void updateNormalRM(rtRayHit);
 	public:
-		//Initialize the thread pool
-		rtRenderer();
-		//Render the scene
-		void render(renderMode RenderMode, shared_ptr<rtScene> scene, rtVec3f& camPos, rtVec3f& u, rtVec3f& v, rtVec3f& n,
-			float hFov, float nearClip, float farClip, int maxBounces, ofPixels* bufferPixels);
+		//Initialize the thread pool. With no thread count, the pool has a thread for each core.
+		rtRenderer(int numThreads = 0);
+		/*
+		 * Render a frame with the given settings. The AOV buffers are optional, and are written in the same pass as the radiance.
+		 * With a reprojection cache, the colors of the surfaces the last frame saw are reused rather than shaded again.
+		 * With a hit cache, the frame either shades the hits it kept instead of tracing the camera rays, or keeps the hits it traces.
+		 */
+		void render(const rtFrameSettings& settings);
 		//Wait for the current render to complete
 		void waitForRender();
+		//Stop the current render and wait for the tiles being rendered to finish. The pixels of the remaining tiles are left as they were.
+		void cancelRender();
+		//Returns true while a render is in progress
+		bool isRendering();
 
 		///Ray tracing methods
 		//Ray trace a single ray and return the color at the intersection. If the ray is a bounced ray, the ray hit data can be given to resolve surface intersection issues.
-		static rtColorf rayTrace(objectSet& objects, lightSet& lights, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, int currBounce, int maxBounces, rtRayHit originPoint);
+		//The hit of the ray is stored in the camera hit if one is given.
+		static rtColorf rayTrace(rtSceneBVH& objects, lightSet& lights, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, int currBounce, int maxBounces, rtRayHit originPoint, rtRayHit* cameraHit = nullptr);
 		//Ray trace a single ray and return the ray hit data. If the ray is a bounced ray, the ray hit data can be given to resolve surface intersection issues.
-		static rtRayHit rayTrace(objectSet& objects, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, rtRayHit sourceObject);
+		static rtRayHit rayTrace(rtSceneBVH& objects, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, rtRayHit sourceObject);
+		//Ray trace a packet of camera rays together and store the color of each active ray, and its hit if the camera hits are given. The bounced and shadow rays are traced one at a time.
+		static void rayTracePacket(rtSceneBVH& objects, lightSet& lights, rtRayPacket& packet, float nearClip, float farClip, int maxBounces, rtColorf* colors, rtRayHit* cameraHits = nullptr);
+		//Shade the hit of a camera ray traced beforehand. The color is the same as tracing the ray with the color returning methods.
+		static rtColorf shadeHit(renderMode RenderMode, rtSceneBVH& objects, lightSet& lights, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, int maxBounces, const rtRayHit& hitData);
 
 		///Ray marching methods
 		//Ray march a single ray and return the color at the intersection. If the ray is a bounced ray, the ray hit data can be given to resolve surface intersection issues.
-		static rtColorf rayMarch(objectSet& objects, lightSet& lights, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, int currBounce, int maxBounces, rtRayHit originPoint);
+		//The hit of the ray is stored in the camera hit if one is given.
+		static rtColorf rayMarch(rtSceneBVH& objects, lightSet& lights, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, int currBounce, int maxBounces, rtRayHit originPoint, rtRayHit* cameraHit = nullptr);
 		//Ray march a single ray and return the closest object. If the ray is a bounced ray, the ray distance data can be given to resolve surface intersection issues.
-		static rtRayHit rayMarch(objectSet& objects, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, rtRayHit sourceObject);
+		static rtRayHit rayMarch(rtSceneBVH& objects, rtVec3f& P, rtVec3f& D, float nearClip, float farClip, rtRayHit sourceObject);
 	};
 }
\ No newline at end of file
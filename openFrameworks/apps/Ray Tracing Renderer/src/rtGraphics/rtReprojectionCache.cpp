@@ -0,0 +1,177 @@
+#include "rtReprojectionCache.h"
+
+namespace rtGraphics
+{
+	//Start a frame of the given size, traced through the given grid
+	void rtReprojectionCache::setFrame(int width, int height, const rtVec3f& camPos, const rtVec3f& firstPoint, const rtVec3f& hStep, const rtVec3f& vStep)
+	{
+		//The pixels of a frame of another size don't line up with the new ones
+		if (width != this->width || height != this->height)
+		{
+			this->width = width;
+			this->height = height;
+			depths.assign(width * height, INFINITY);
+			objects.assign(width * height, nullptr);
+			samples.assign(width * height, 0);
+			hasHistory = false;
+		}
+
+		this->camPos = camPos;
+		this->firstPoint = firstPoint;
+		this->hStep = hStep;
+		this->vStep = vStep;
+	}
+
+	//Make the frame the last completed frame
+	void rtReprojectionCache::commitFrame(const ofFloatPixels& radiance)
+	{
+		previousColors = radiance;
+		//The buffers of the older frame are overwritten by the next frame, so they are swapped rather than copied
+		previousDepths.swap(depths);
+		previousObjects.swap(objects);
+		previousSamples.swap(samples);
+		depths.resize(width * height);
+		objects.resize(width * height);
+		samples.resize(width * height);
+
+		previousCamPos = camPos;
+		previousFirstPoint = firstPoint;
+		previousHStep = hStep;
+		previousVStep = vStep;
+		hasHistory = true;
+		frameIndex++;
+	}
+
+	//Forget the last frame
+	void rtReprojectionCache::clear()
+	{
+		hasHistory = false;
+	}
+
+	//The sub-pixel offset of the camera rays of the current frame
+	void rtReprojectionCache::getJitter(float& rowOffset, float& colOffset) const
+	{
+		if (!temporalAntiAliasing)
+		{
+			rowOffset = 0.0f;
+			colOffset = 0.0f;
+			return;
+		}
+
+		//The offsets are spread over the square of the pixel centered on its grid point. The sequence starts at one, since its first point is zero.
+		unsigned int index = frameIndex % jitterLength + 1;
+		colOffset = halton(index, 2) - 0.5f;
+		rowOffset = halton(index, 3) - 0.5f;
+	}
+
+	//Find the color the last frame saw the hit of a camera ray with
+	bool rtReprojectionCache::findPrevious(const rtRayHit& hit, int pixelIndex, rtColorf& color, int& pixelSamples) const
+	{
+		if (!hasHistory)
+			return false;
+
+		//Without a camera delta every pixel sees what it saw before, including the jittered rays that hit the other side of an edge
+		if (camPos == previousCamPos && firstPoint == previousFirstPoint && hStep == previousHStep && vStep == previousVStep)
+		{
+			color = rtColorf(previousColors[pixelIndex * 3], previousColors[pixelIndex * 3 + 1], previousColors[pixelIndex * 3 + 2]);
+			pixelSamples = previousSamples[pixelIndex];
+			return true;
+		}
+
+		//Misses have no point to project
+		if (!hit.hit)
+			return false;
+
+		//Intersect the line from the last camera position to the point with the last near plane
+		rtVec3f planeNormal = previousHStep.getCrossed(previousVStep);
+		rtVec3f toPoint = hit.hitPoint - previousCamPos;
+		float pointDistance = toPoint.dot(planeNormal);
+		float planeDistance = (previousFirstPoint - previousCamPos).dot(planeNormal);
+
+		//Points beside or behind the last camera weren't in view
+		if (pointDistance * planeDistance <= 0.0f)
+			return false;
+
+		rtVec3f gridOffset = previousCamPos + toPoint * (planeDistance / pointDistance) - previousFirstPoint;
+		//The steps are perpendicular, so the offset along each gives the column and row the point was seen at
+		float colPosition = gridOffset.dot(previousHStep) / previousHStep.magnitudeSquared();
+		float rowPosition = gridOffset.dot(previousVStep) / previousVStep.magnitudeSquared();
+		int firstCol = (int)floorf(colPosition);
+		int firstRow = (int)floorf(rowPosition);
+		float colWeight = colPosition - firstCol;
+		float rowWeight = rowPosition - firstRow;
+		float pointDepth = toPoint.magnitude();
+
+		float sum[3] = { 0.0f, 0.0f, 0.0f };
+		float weightSum = 0.0f;
+		pixelSamples = maxTemporalSamples;
+
+		//Blend the four pixels around the point, leaving out the ones that saw something else
+		for (int corner = 0; corner < 4; corner++)
+		{
+			int row = firstRow + corner / 2;
+			int col = firstCol + corner % 2;
+
+			if (col < 0 || col >= width || row < 0 || row >= height)
+				continue;
+
+			int previousIndex = row * width + col;
+			float previousDepth = previousDepths[previousIndex];
+
+			//A different object or depth means the point was hidden behind something else, or the scene changed
+			if (previousObjects[previousIndex] != hit.hitObject || fabsf(pointDepth - previousDepth) > previousDepth * depthTolerance)
+				continue;
+
+			float weight = ((corner % 2) ? colWeight : 1.0f - colWeight) * ((corner / 2) ? rowWeight : 1.0f - rowWeight);
+
+			for (int channel = 0; channel < 3; channel++)
+				sum[channel] += previousColors[previousIndex * 3 + channel] * weight;
+
+			weightSum += weight;
+			//The blend holds no more samples than the pixel with the fewest
+			pixelSamples = min(pixelSamples, (int)previousSamples[previousIndex]);
+		}
+
+		if (weightSum <= 0.0f)
+			return false;
+
+		color = rtColorf(sum[0] / weightSum, sum[1] / weightSum, sum[2] / weightSum);
+		return true;
+	}
+
+	//Returns true if the pixel is due to be shaded from scratch this frame
+	bool rtReprojectionCache::refreshDue(int pixelIndex) const
+	{
+		//Scatter the pixels refreshed each frame, so the refreshes don't show as a pattern
+		unsigned int hash = (unsigned int)pixelIndex * 2654435761u;
+		hash ^= hash >> 16;
+
+		return (frameIndex + hash) % refreshInterval == 0;
+	}
+
+	//Temporal anti-aliasing changes what the colors hold
+	void rtReprojectionCache::setTemporalAntiAliasing(bool temporalAntiAliasing)
+	{
+		if (temporalAntiAliasing != this->temporalAntiAliasing)
+			clear();
+
+		this->temporalAntiAliasing = temporalAntiAliasing;
+	}
+
+	//The Halton sequence of the given base
+	float rtReprojectionCache::halton(unsigned int index, unsigned int base)
+	{
+		float result = 0.0f;
+		float fraction = 1.0f / base;
+
+		//Mirror the digits of the index around the decimal point
+		while (index > 0)
+		{
+			result += fraction * (index % base);
+			index /= base;
+			fraction /= base;
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+#include <math.h>
+#include "ofPixels.h"
+#include "Data Classes/rtScene.h"
+#include "Data Classes/rtRayHit.h"
+#include "Data Classes/rtVec3f.h"
+#include "Data Classes/rtColorf.h"
+
+using namespace std;
+
+namespace rtGraphics
+{
+	/*
+	 * Keeps the color, depth and hit object of each pixel of the last completed frame, so the next frame can reuse the colors of the surfaces it still sees
+	 * Each pixel of a new frame traces its camera ray, then projects the hit point into the view of the last frame. If the pixel it lands on saw the
+	 * same object at the same depth, the color of that pixel is reused instead of shading the hit again. Disocclusions and pixels failing the test are shaded.
+	 * A staggered share of the pixels is shaded again every frame, so view dependent highlights and reflections catch up with the camera,
+	 * and changes to the scene the cache isn't told about are picked up within a few frames.
+	 * With temporal anti-aliasing, the camera rays of each frame are offset by a sub-pixel jitter and blended into the reused colors,
+	 * so a still or slowly moving view gathers several samples per pixel over consecutive frames.
+	 */
+	class rtReprojectionCache
+	{
+	private:
+		//The most frames blended into a pixel with temporal anti-aliasing. Later frames keep blending in with this weight.
+		static const int maxTemporalSamples = 8;
+		//The number of jitter offsets cycled through
+		static const int jitterLength = 16;
+		//The depths seen by the two frames may differ by this fraction and still be the same surface, allowing for the pixel grids not lining up
+		float depthTolerance = 0.02f;
+		//Each pixel is shaded from scratch once every this many frames
+		int refreshInterval = 8;
+		bool temporalAntiAliasing = false;
+
+		int width = 0, height = 0;
+		//The number of frames completed since the cache was cleared, which staggers the refreshes and steps through the jitter offsets
+		unsigned int frameIndex = 0;
+
+		//The last completed frame. Its grid is used to find the pixel a point was seen at.
+		bool hasHistory = false;
+		ofFloatPixels previousColors;
+		vector<float> previousDepths;
+		vector<rtObject*> previousObjects;
+		vector<unsigned char> previousSamples;
+		rtVec3f previousCamPos, previousFirstPoint, previousHStep, previousVStep;
+
+		//The depth, hit object and number of blended frames of each pixel of the frame being rendered
+		vector<float> depths;
+		vector<rtObject*> objects;
+		vector<unsigned char> samples;
+		rtVec3f camPos, firstPoint, hStep, vStep;
+
+		//The Halton sequence of the given base, a sequence of evenly spread numbers between 0 and 1
+		static float halton(unsigned int index, unsigned int base);
+
+	public:
+		/*
+		 * Start a frame of the given size, traced through the grid of points on the near plane given by the first point and steps
+		 * A frame of a different size clears the cache. Must not be called while a frame is rendering.
+		 */
+		void setFrame(int width, int height, const rtVec3f& camPos, const rtVec3f& firstPoint, const rtVec3f& hStep, const rtVec3f& vStep);
+		//Make the frame the last completed frame, keeping its radiance as the colors to reuse
+		void commitFrame(const ofFloatPixels& radiance);
+		//Forget the last frame, so every pixel of the next frame is shaded. Call this when the scene or shading settings change.
+		void clear();
+
+		//The sub-pixel offset of the camera rays of the current frame. Without temporal anti-aliasing the rays go through the grid points.
+		void getJitter(float& rowOffset, float& colOffset) const;
+		/*
+		 * Find the color the last frame saw the hit of a pixel's camera ray with, and the number of frames blended into it
+		 * The color is blended bilinearly from the pixels around the point that saw the same object at the same depth. Returns false if none did.
+		 * When the camera hasn't moved, every pixel takes its own color, so the jittered rays of a pixel on an edge keep blending both sides.
+		 */
+		bool findPrevious(const rtRayHit& hit, int pixelIndex, rtColorf& color, int& pixelSamples) const;
+		//Returns true if the pixel is due to be shaded from scratch this frame
+		bool refreshDue(int pixelIndex) const;
+		//Record the hit of a pixel's camera ray and the number of frames blended into its color
+		void setPixel(int pixelIndex, const rtRayHit& hit, int pixelSamples);
+
+		bool isTemporalAntiAliasing() const;
+		int getMaxTemporalSamples() const;
+		//Temporal anti-aliasing changes what the colors hold, so turning it on or off clears the cache
+		void setTemporalAntiAliasing(bool temporalAntiAliasing);
+		void setRefreshInterval(int refreshInterval);
+	};
+
+	///In-line method definitions
+	inline bool rtReprojectionCache::isTemporalAntiAliasing() const { return temporalAntiAliasing; }
+	inline int rtReprojectionCache::getMaxTemporalSamples() const { return maxTemporalSamples; }
+	inline void rtReprojectionCache::setRefreshInterval(int refreshInterval) { this->refreshInterval = max(refreshInterval, 1); }
+
+	inline void rtReprojectionCache::setPixel(int pixelIndex, const rtRayHit& hit, int pixelSamples)
+	{
+		//The depth is measured from the camera rather than taken from the hit, since ray marched hits store the distance to the surface instead
+		depths[pixelIndex] = hit.hit ? (hit.hitPoint - camPos).magnitude() : INFINITY;
+		objects[pixelIndex] = hit.hit ? hit.hitObject : nullptr;
+		samples[pixelIndex] = (unsigned char)pixelSamples;
+	}
+}
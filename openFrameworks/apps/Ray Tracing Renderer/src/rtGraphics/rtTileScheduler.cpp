@@ -0,0 +1,123 @@
+#include "rtTileScheduler.h"
+
+namespace rtGraphics
+{
+	///Constructors
+	rtTileScheduler::rtTileScheduler(int numQueues) : numQueues(numQueues)
+	{
+		queues = make_unique<rtTileQueue[]>(numQueues);
+	}
+
+	//Split the frame into square tiles of the given width and give each queue an equal run of them
+	void rtTileScheduler::setFrame(int frameWidth, int frameHeight, int tileSize, const vector<rtTile>* regions)
+	{
+		this->frameWidth = frameWidth;
+		this->frameHeight = frameHeight;
+		this->tileSize = tileSize;
+		wholeFrame = (regions == nullptr);
+
+		//Repeated frames reuse the regions, so they are copied in case the caller's list changes
+		if (regions && regions != &this->regions)
+			this->regions = *regions;
+
+		int tilesPerRow = (frameWidth + tileSize - 1) / tileSize;
+		int tilesPerCol = (frameHeight + tileSize - 1) / tileSize;
+		vector<rtTile> frameTiles;
+
+		for (int tileIndex = 0; tileIndex < tilesPerRow * tilesPerCol; tileIndex++)
+		{
+			rtTile tile;
+			tile.startRow = (tileIndex / tilesPerRow) * tileSize;
+			tile.startCol = (tileIndex % tilesPerRow) * tileSize;
+			//Clip the tiles on the right and bottom edges to the frame
+			tile.endRow = min(tile.startRow + tileSize, frameHeight);
+			tile.endCol = min(tile.startCol + tileSize, frameWidth);
+
+			if (wholeFrame || overlapsRegion(tile))
+				frameTiles.push_back(tile);
+		}
+
+		int numTiles = frameTiles.size();
+
+		for (int queueIndex = 0; queueIndex < numQueues; queueIndex++)
+		{
+			lock_guard<mutex> queueLock(queues[queueIndex].lock);
+			queues[queueIndex].tiles.clear();
+
+			//Each queue gets a run of tiles in reading order, so the tiles a thread renders itself are next to each other
+			int firstTile = (numTiles * queueIndex) / numQueues;
+			int lastTile = (numTiles * (queueIndex + 1)) / numQueues;
+
+			for (int tileIndex = firstTile; tileIndex < lastTile; tileIndex++)
+				queues[queueIndex].tiles.push_back(frameTiles[tileIndex]);
+		}
+	}
+
+	//Hand out the tiles of the last frame again
+	void rtTileScheduler::repeatFrame()
+	{
+		setFrame(frameWidth, frameHeight, tileSize, wholeFrame ? nullptr : &regions);
+	}
+
+	//Returns true if the tile shares a pixel with one of the regions
+	bool rtTileScheduler::overlapsRegion(const rtTile& tile) const
+	{
+		for (int regionIndex = 0; regionIndex < regions.size(); regionIndex++)
+		{
+			const rtTile& region = regions[regionIndex];
+
+			if (tile.startRow < region.endRow && region.startRow < tile.endRow && tile.startCol < region.endCol && region.startCol < tile.endCol)
+				return true;
+		}
+
+		return false;
+	}
+
+	//Get the next tile for the given thread to render
+	bool rtTileScheduler::nextTile(int thread, rtTile& tile)
+	{
+		{
+			rtTileQueue& queue = queues[thread];
+			lock_guard<mutex> queueLock(queue.lock);
+
+			if (!queue.tiles.empty())
+			{
+				tile = queue.tiles.front();
+				queue.tiles.pop_front();
+				return true;
+			}
+		}
+
+		return stealTile(thread, tile);
+	}
+
+	//Take a tile from the back of another thread's queue, the end furthest from the tiles its owner is rendering
+	bool rtTileScheduler::stealTile(int thief, rtTile& tile)
+	{
+		//Start with the next thread so the threads don't all steal from the same queue
+		for (int offset = 1; offset < numQueues; offset++)
+		{
+			rtTileQueue& victim = queues[(thief + offset) % numQueues];
+			lock_guard<mutex> queueLock(victim.lock);
+
+			if (!victim.tiles.empty())
+			{
+				tile = victim.tiles.back();
+				victim.tiles.pop_back();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	//Drop every tile not yet taken
+	void rtTileScheduler::cancel()
+	{
+		for (int queueIndex = 0; queueIndex < numQueues; queueIndex++)
+		{
+			lock_guard<mutex> queueLock(queues[queueIndex].lock);
+			queues[queueIndex].tiles.clear();
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <memory>
+
+using namespace std;
+
+namespace rtGraphics
+{
+	//A rectangle of pixels rendered by one thread. The end row and column are exclusive.
+	struct rtTile
+	{
+		int startRow, endRow;
+		int startCol, endCol;
+	};
+
+	//The tiles waiting to be rendered by one thread
+	struct rtTileQueue
+	{
+		mutex lock;
+		deque<rtTile> tiles;
+	};
+
+
+	/*
+	 * Hands out the tiles of a frame to the render threads
+	 * Each thread starts with its own queue of neighbouring tiles and takes them from the front. A thread whose queue runs out
+	 * steals from the back of another thread's queue, so no thread sits idle while tiles of an expensive part of the image are left.
+	 */
+	class rtTileScheduler
+	{
+	private:
+		int numQueues;
+		unique_ptr<rtTileQueue[]> queues;
+		//The dimensions of the last frame
+		int frameWidth, frameHeight, tileSize;
+		//The rectangles the tiles of the last frame were picked by, unless the whole frame was rendered
+		vector<rtTile> regions;
+		bool wholeFrame = true;
+
+		//Take a tile from the back of another thread's queue. Returns false if every queue is empty.
+		bool stealTile(int thief, rtTile& tile);
+		//Returns true if the tile shares a pixel with one of the regions
+		bool overlapsRegion(const rtTile& tile) const;
+
+	public:
+		///Constructors
+		rtTileScheduler(int numQueues);
+
+		/*
+		 * Split the frame into square tiles of the given width and give each queue an equal run of them
+		 * Given a list of rectangles of pixels, only the tiles overlapping one of them are handed out, and the rest of the frame is left as it was.
+		 */
+		void setFrame(int frameWidth, int frameHeight, int tileSize, const vector<rtTile>* regions = nullptr);
+		//Hand out the tiles of the last frame again, for another pass over the same frame
+		void repeatFrame();
+		//Get the next tile for the given thread to render. Returns false once every tile of the frame has been taken.
+		bool nextTile(int thread, rtTile& tile);
+		//Drop every tile not yet taken, so each thread stops once it finishes its current tile
+		void cancel();
+	};
+}
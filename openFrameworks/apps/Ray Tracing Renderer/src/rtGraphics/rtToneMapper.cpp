@@ -0,0 +1,106 @@
+#include "rtToneMapper.h"
+
+namespace rtGraphics
+{
+	///Constructors
+	rtToneMapper::rtToneMapper(toneMapping ToneMapping, float exposure) : ToneMapping(ToneMapping), exposure(exposure)
+	{
+		for (int entry = 0; entry < tableSize; entry++)
+		{
+			float linear = (float)entry / (tableSize - 1);
+			//The piecewise sRGB transfer function
+			float srgb = (linear <= 0.0031308f) ? linear * 12.92f : 1.055f * powf(linear, 1.0f / 2.4f) - 0.055f;
+			srgbTable[entry] = (unsigned char)(srgb * 255.0f + 0.5f);
+		}
+	}
+
+	//Map four scaled radiance values to the display range
+	__m128 rtToneMapper::mapValues(__m128 values) const
+	{
+		__m128 zero = _mm_setzero_ps();
+		__m128 one = _mm_set1_ps(1.0f);
+		values = _mm_max_ps(values, zero);
+
+		switch (ToneMapping)
+		{
+		//Reinhard: x / (1 + x)
+		case toneMapping::reinhard:
+			values = _mm_div_ps(values, _mm_add_ps(values, one));
+			break;
+
+		//The ACES filmic curve fitted by Narkowicz: x(2.51x + 0.03) / (x(2.43x + 0.59) + 0.14)
+		case toneMapping::aces:
+		{
+			__m128 numerator = _mm_mul_ps(values, _mm_add_ps(_mm_mul_ps(values, _mm_set1_ps(2.51f)), _mm_set1_ps(0.03f)));
+			__m128 denominator = _mm_add_ps(_mm_mul_ps(values, _mm_add_ps(_mm_mul_ps(values, _mm_set1_ps(2.43f)), _mm_set1_ps(0.59f))), _mm_set1_ps(0.14f));
+			values = _mm_div_ps(numerator, denominator);
+			break;
+		}
+
+		default:
+			break;
+		}
+
+		return _mm_min_ps(values, one);
+	}
+
+	//Convert a display value between 0 and 1 to 8 bits
+	unsigned char rtToneMapper::encodeValue(float value) const
+	{
+		//Linear color is truncated the same way the pixels have always been written
+		if (ToneMapping == toneMapping::none)
+			return (unsigned char)(value * 255.0f);
+
+		//Round to the nearest entry the same way the four channel path does
+		return srgbTable[_mm_cvtss_si32(_mm_set_ss(value * (tableSize - 1)))];
+	}
+
+	//Convert the radiance of the tile to display pixels
+	void rtToneMapper::mapTile(const ofFloatPixels& radiance, ofPixels& display, const rtTile& tile) const
+	{
+		int bufferWidth = display.getWidth();
+		//The channels of a row of the tile are contiguous in both buffers, so each row is mapped as one run of values
+		int rowValues = (tile.endCol - tile.startCol) * 3;
+		__m128 scale = _mm_set1_ps(exposure);
+
+		for (int row = tile.startRow; row < tile.endRow; row++)
+		{
+			const float* source = radiance.getData() + (row * bufferWidth + tile.startCol) * 3;
+			unsigned char* target = display.getData() + (row * bufferWidth + tile.startCol) * 3;
+			int value = 0;
+
+			for (; value + 4 <= rowValues; value += 4)
+			{
+				__m128 mapped = mapValues(_mm_mul_ps(_mm_loadu_ps(source + value), scale));
+
+				if (ToneMapping == toneMapping::none)
+				{
+					//Truncate to integers and narrow them to bytes. The values are already between 0 and 255.
+					__m128i integers = _mm_cvttps_epi32(_mm_mul_ps(mapped, _mm_set1_ps(255.0f)));
+					__m128i words = _mm_packs_epi32(integers, integers);
+					__m128i bytes = _mm_packus_epi16(words, words);
+					int packed = _mm_cvtsi128_si32(bytes);
+					memcpy(target + value, &packed, 4);
+				}
+				else
+				{
+					//SSE has no gather, so the table is read one entry at a time
+					__m128i entries = _mm_cvtps_epi32(_mm_mul_ps(mapped, _mm_set1_ps((float)(tableSize - 1))));
+					int indices[4];
+					_mm_storeu_si128((__m128i*)indices, entries);
+
+					for (int lane = 0; lane < 4; lane++)
+						target[value + lane] = srgbTable[indices[lane]];
+				}
+			}
+
+			//Map the values left over at the end of the row
+			for (; value < rowValues; value++)
+			{
+				float mapped;
+				_mm_store_ss(&mapped, mapValues(_mm_set_ss(source[value] * exposure)));
+				target[value] = encodeValue(mapped);
+			}
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstring>
+#include <immintrin.h>
+#include "ofPixels.h"
+#include "rtTileScheduler.h"
+#include "Data Classes/Data Types.h"
+
+namespace rtGraphics
+{
+	/*
+	 * Converts the float radiance of a frame to the 8-bit pixels shown on the screen
+	 * The radiance is scaled by the exposure and mapped to the display range four channels at a time. With no tone mapping the result
+	 * is clamped and scaled to 255 as linear color. The tone mapped curves are encoded as sRGB through a lookup table.
+	 */
+	class rtToneMapper
+	{
+	private:
+		//The number of entries in the sRGB table, enough that neighbouring entries of the darkest colors stay within one 8-bit step
+		static const int tableSize = 4096;
+
+		toneMapping ToneMapping;
+		float exposure;
+		//The 8-bit sRGB encoding of evenly spaced linear values between 0 and 1
+		unsigned char srgbTable[tableSize];
+
+		//Map four scaled radiance values to the display range
+		__m128 mapValues(__m128 values) const;
+		//Convert a display value between 0 and 1 to 8 bits
+		unsigned char encodeValue(float value) const;
+
+	public:
+		///Constructors
+		rtToneMapper(toneMapping ToneMapping = toneMapping::none, float exposure = 1.0f);
+
+		//Convert the radiance of the tile to display pixels. Both buffers hold three channels per pixel and have the same dimensions.
+		void mapTile(const ofFloatPixels& radiance, ofPixels& display, const rtTile& tile) const;
+	};
+}
@@ -0,0 +1,277 @@
+#include "rtWavefrontRenderer.h"
+
+namespace rtGraphics
+{
+	//Map a value between the given bounds to one of 32 cells
+	static unsigned int quantize(float value, float minValue, float maxValue)
+	{
+		float scaled = (value - minValue) / (maxValue - minValue) * 32.0f;
+
+		//NaNs and values below the range go in the first cell
+		if (!(scaled > 0.0f))
+			return 0;
+
+		return (scaled >= 31.0f) ? 31 : (unsigned int)scaled;
+	}
+
+	//Ray trace a batch of camera rays one bounce at a time
+	void rtWavefrontRenderer::render(rtSceneBVH& objects, lightSet& lights, const rtVec3f& camPos, vector<rtVec3f>& directions, int batchWidth, int batchHeight,
+		float nearClip, float farClip, int maxBounces, int packetWidth, vector<rtColorf>& colors)
+	{
+		rays.clear();
+		sceneBounds = objects.getBounds();
+
+		//There is no origin point for a camera ray
+		rtRayHit originPoint;
+		originPoint.hit = false;
+
+		//Queue a camera ray for each pixel
+		for (int pixel = 0; pixel < directions.size(); pixel++)
+		{
+			rtWavefrontRay cameraRay;
+			cameraRay.origin = camPos;
+			cameraRay.direction = directions[pixel];
+			cameraRay.nearClip = nearClip;
+			cameraRay.originPoint = originPoint;
+			cameraRay.parent = -1;
+			cameraRay.pixel = pixel;
+
+			rays.push_back(cameraRay);
+		}
+
+		traceCameraRays(objects, batchWidth, batchHeight, packetWidth, farClip);
+
+		//Shade each bounce, which queues the rays of the next bounce after the current ones
+		int first = 0;
+		int last = rays.size();
+
+		for (int currBounce = 0; first < last; currBounce++)
+		{
+			if (currBounce > 0)
+				traceRays(objects, first, last, farClip);
+
+			shadeHits(objects, lights, first, last, farClip, currBounce, maxBounces);
+
+			first = last;
+			last = rays.size();
+		}
+
+		colors.resize(directions.size());
+		resolveColors(colors);
+	}
+
+	//Trace the camera rays of the batch
+	void rtWavefrontRenderer::traceCameraRays(rtSceneBVH& objects, int batchWidth, int batchHeight, int packetWidth, float farClip)
+	{
+		//Neighbouring camera rays are already coherent, so they are traced in pixel order without sorting
+		if (packetWidth <= 1)
+		{
+			for (int rayIndex = 0; rayIndex < rays.size(); rayIndex++)
+			{
+				rtWavefrontRay& ray = rays[rayIndex];
+				ray.hitData = objects.rayIntersect(ray.origin, ray.direction, ray.nearClip, farClip, ray.originPoint);
+			}
+
+			return;
+		}
+
+		rtRayPacket packet;
+		packet.origin = rays[0].origin;
+		rtRayHit hits[maxPacketSize];
+
+		for (int blockRow = 0; blockRow < batchHeight; blockRow += packetWidth)
+		{
+			for (int blockCol = 0; blockCol < batchWidth; blockCol += packetWidth)
+			{
+				packet.setSize(packetWidth * packetWidth);
+
+				//Rays past the edge of the batch are left inactive
+				for (int ray = 0; ray < packet.size; ray++)
+				{
+					int row = blockRow + ray / packetWidth;
+					int col = blockCol + ray % packetWidth;
+
+					if (row < batchHeight && col < batchWidth)
+						packet.setRay(ray, rays[row * batchWidth + col].direction);
+				}
+
+				packet.update();
+				objects.rayIntersectPacket(packet, rays[0].nearClip, farClip, hits);
+
+				for (int ray = 0; ray < packet.size; ray++)
+					if (packet.isActive(packet.activeMasks, ray))
+						rays[(blockRow + ray / packetWidth) * batchWidth + blockCol + ray % packetWidth].hitData = hits[ray];
+			}
+		}
+	}
+
+	//Sort the rays of a bounce so that rays travelling into the same octant from nearby points are traced one after another
+	void rtWavefrontRenderer::traceRays(rtSceneBVH& objects, int first, int last, float farClip)
+	{
+		sortBuffer.clear();
+
+		for (int rayIndex = first; rayIndex < last; rayIndex++)
+			sortBuffer.push_back(make_pair(calcSortKey(rays[rayIndex].origin, rays[rayIndex].direction), rayIndex));
+
+		sort(sortBuffer.begin(), sortBuffer.end());
+
+		for (int sortedIndex = 0; sortedIndex < sortBuffer.size(); sortedIndex++)
+		{
+			rtWavefrontRay& ray = rays[sortBuffer[sortedIndex].second];
+			ray.hitData = objects.rayIntersect(ray.origin, ray.direction, ray.nearClip, farClip, ray.originPoint);
+		}
+	}
+
+	//Shade the hits of a bounce using the Phong shading method
+	void rtWavefrontRenderer::shadeHits(rtSceneBVH& objects, lightSet& lights, int first, int last, float farClip, int currBounce, int maxBounces)
+	{
+		//Group the hits by object so the hits sharing a material are shaded together
+		hitOrder.clear();
+
+		for (int rayIndex = first; rayIndex < last; rayIndex++)
+			if (rays[rayIndex].hitData.hit)
+				hitOrder.push_back(rayIndex);
+
+		stable_sort(hitOrder.begin(), hitOrder.end(), [&](int lhs, int rhs) {
+			return less<rtObject*>()(rays[lhs].hitData.hitObject, rays[rhs].hitData.hitObject);
+		});
+
+		//Cast a shadow ray from each hit point towards each light. The rays towards one light are queued together, in the order of the hits,
+		//since rays from nearby points to the same light cross the same part of the scene.
+		shadowRays.resize(hitOrder.size() * lights->size());
+
+		for (int lightIndex = 0; lightIndex < lights->size(); lightIndex++)
+		{
+			rtVec3f lightPosition = lights->at(lightIndex)->getPosition();
+
+			for (int hitIndex = 0; hitIndex < hitOrder.size(); hitIndex++)
+			{
+				rtWavefrontShadowRay& shadowRay = shadowRays[lightIndex * hitOrder.size() + hitIndex];
+				shadowRay.ray = hitOrder[hitIndex];
+
+				//Calculate the vector pointing from the hit position towards the light
+				shadowRay.lightVector = lightPosition - rays[shadowRay.ray].hitData.hitPoint;
+				//Get the squared distance from the hit position to the light before normalizing it
+				float lightDistSquared = shadowRay.lightVector.magnitudeSquared();
+				shadowRay.lightVector.normalize();
+				shadowRay.maxDist = fminf(sqrtf(lightDistSquared), farClip);
+			}
+		}
+
+		traceShadowRays(objects);
+
+		//Add up the light reaching each hit point, and queue the reflected rays for the next bounce
+		for (int hitIndex = 0; hitIndex < hitOrder.size(); hitIndex++)
+		{
+			rtWavefrontRay& ray = rays[hitOrder[hitIndex]];
+			rtRayHit& hitData = ray.hitData;
+
+			//The material of the object
+			rtMat objectMat = hitData.hitObject->getMat();
+			//Get the reflectivity of the material
+			float reflectivity = objectMat.getReflectivity();
+
+			ray.objectColor = rtColorf();
+			ray.specular = rtColorf();
+			ray.reflectivity = reflectivity;
+
+			//Iterate over the all the lights
+			for (int lightIndex = 0; lightIndex < lights->size(); lightIndex++)
+			{
+				rtLight* currLight = lights->at(lightIndex);
+				rtWavefrontShadowRay& shadowRay = shadowRays[lightIndex * hitOrder.size() + hitIndex];
+
+				//Add the ambient color if the object is not perfectly reflective, regardless of if the point is in shadow or not.
+				if (reflectivity < 1.0f)
+					ray.objectColor += PhongShader::ambientColor((*currLight).getAmbient(), objectMat.getAmbient(), currLight->getAmbientIntensity());
+
+				//If the point is not in shadow, check for specular and diffuse color as well
+				if (!shadowRay.occluded)
+				{
+					if (reflectivity < 1.0f)
+						ray.objectColor += PhongShader::diffuseColor(shadowRay.lightVector, hitData.hitNormal, (*currLight).getDiffuse(), objectMat.getDiffuse(), currLight->getIncidentIntensity());
+
+					ray.specular += PhongShader::specularColor(shadowRay.lightVector, ray.direction, hitData.hitNormal, (*currLight).getSpecular(), objectMat.getSpecular(), objectMat.getSmoothness(), currLight->getIncidentIntensity());
+				}
+			}
+
+			//Queue the reflected ray if the object is reflective and the ray can still bounce
+			if (reflectivity != 0.0f && currBounce < maxBounces)
+			{
+				rtWavefrontRay reflectedRay;
+				reflectedRay.origin = hitData.hitPoint;
+				reflectedRay.direction = ray.direction.getReflected(hitData.hitNormal);
+				reflectedRay.nearClip = 0.0f;
+				reflectedRay.originPoint = hitData;
+				reflectedRay.parent = hitOrder[hitIndex];
+				reflectedRay.pixel = ray.pixel;
+
+				//Adding the ray may move the ray list, so the reference to the current ray is not used afterwards
+				rays.push_back(reflectedRay);
+			}
+		}
+	}
+
+	//Trace the queued shadow rays
+	void rtWavefrontRenderer::traceShadowRays(rtSceneBVH& objects)
+	{
+		for (int shadowIndex = 0; shadowIndex < shadowRays.size(); shadowIndex++)
+		{
+			rtWavefrontShadowRay& shadowRay = shadowRays[shadowIndex];
+			rtWavefrontRay& ray = rays[shadowRay.ray];
+
+			//Only check if any object lies between the point and the light without finding the closest one
+			shadowRay.occluded = objects.occluded(ray.hitData.hitPoint, shadowRay.lightVector, ray.nearClip, shadowRay.maxDist, ray.hitData);
+		}
+	}
+
+	//Reflected rays always come after their parent, so a reverse pass finishes every reflected color before the ray that needs it
+	void rtWavefrontRenderer::resolveColors(vector<rtColorf>& colors)
+	{
+		reflectedColors.assign(rays.size(), rtColorf::black);
+
+		for (int rayIndex = rays.size() - 1; rayIndex >= 0; rayIndex--)
+		{
+			rtWavefrontRay& ray = rays[rayIndex];
+			rtColorf finalColor = rtColorf::black;
+
+			if (ray.hitData.hit)
+			{
+				//If the object is perfectly non-reflective, only use the object color
+				if (ray.reflectivity == 0.0f)
+					finalColor = ray.objectColor + ray.specular;
+				//Otherwise combine the object color and reflected color. Rays that could not bounce again reflect black.
+				else
+					finalColor = (ray.objectColor * (1 - ray.reflectivity)) + (reflectedColors[rayIndex] * ray.reflectivity) + ray.specular;
+			}
+
+			if (ray.parent == -1)
+				colors[ray.pixel] = finalColor;
+			else
+				reflectedColors[ray.parent] = finalColor;
+		}
+	}
+
+	//Build a key from the direction octant followed by the interleaved bits of the quantized origin
+	unsigned int rtWavefrontRenderer::calcSortKey(const rtVec3f& origin, const rtVec3f& direction) const
+	{
+		unsigned int octant = (signbit(direction.getX()) ? 1 : 0) | (signbit(direction.getY()) ? 2 : 0) | (signbit(direction.getZ()) ? 4 : 0);
+
+		//Interleaving the origin bits keeps nearby origins close in the order
+		unsigned int originBits = 0;
+
+		if (sceneBounds.isFinite())
+		{
+			unsigned int cells[3];
+
+			for (int axis = 0; axis < 3; axis++)
+				cells[axis] = quantize(origin.getAxis(axis), sceneBounds.getMin().getAxis(axis), sceneBounds.getMax().getAxis(axis));
+
+			for (int bit = 4; bit >= 0; bit--)
+				for (int axis = 0; axis < 3; axis++)
+					originBits = (originBits << 1) | ((cells[axis] >> bit) & 1);
+		}
+
+		return (octant << 15) | originBits;
+	}
+}
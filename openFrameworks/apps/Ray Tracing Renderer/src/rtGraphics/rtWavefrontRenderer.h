@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include "Data Classes/rtScene.h"
+#include "Data Classes/rtRayHit.h"
+#include "Data Classes/rtRayPacket.h"
+#include "Acceleration Structures/rtSceneBVH.h"
+#include "PhongShader.h"
+
+using namespace std;
+
+namespace rtGraphics
+{
+	//A camera or reflected ray of the wavefront, along with the shading of the point it hits
+	struct rtWavefrontRay
+	{
+		rtVec3f origin;
+		rtVec3f direction;
+		float nearClip;
+		//The hit the ray leaves from, used to resolve surface intersection issues. Camera rays have none.
+		rtRayHit originPoint;
+		//The ray whose reflected color this ray finds, or -1 for camera rays
+		int parent;
+		//The pixel of the batch the ray contributes to
+		int pixel;
+
+		//The closest hit of the ray
+		rtRayHit hitData;
+		//The color of the hit point before the reflected color is added
+		rtColorf objectColor;
+		rtColorf specular;
+		float reflectivity;
+	};
+
+	//A shadow ray from a hit point towards a light
+	struct rtWavefrontShadowRay
+	{
+		//The ray whose hit point the shadow ray starts from
+		int ray;
+		//The normalized vector from the hit point to the light
+		rtVec3f lightVector;
+		float maxDist;
+		bool occluded;
+	};
+
+
+	/*
+	 * A breadth-first alternative to the recursive ray tracer
+	 * Each batch of camera rays is traced one bounce at a time: every ray of a bounce is intersected, the hits are shaded sorted by object,
+	 * and the shadow rays they cast are queued light by light. Reflected rays are sorted by direction octant and origin before the next bounce is traced.
+	 * Once the last bounce is traced, the reflected colors are combined from the deepest bounce up, which produces the same image as the recursive tracer.
+	 */
+	class rtWavefrontRenderer
+	{
+	private:
+		//The rays of every bounce, in the order they were cast. Reflected rays always follow the ray they reflect.
+		vector<rtWavefrontRay> rays;
+		//The shadow rays of the current bounce, indexed as [light][hit]
+		vector<rtWavefrontShadowRay> shadowRays;
+		//The reflected color found for each ray
+		vector<rtColorf> reflectedColors;
+		//Ray indices paired with their sort keys
+		vector<pair<unsigned int, int>> sortBuffer;
+		//The rays of the current bounce that hit an object, sorted by object
+		vector<int> hitOrder;
+		//The bounds used to quantize ray origins for sorting
+		rtAABB sceneBounds;
+
+		//Trace the camera rays of the batch, in packets if the packet width is larger than 1
+		void traceCameraRays(rtSceneBVH& objects, int batchWidth, int batchHeight, int packetWidth, float farClip);
+		//Sort the rays in the given range by direction octant and origin, and trace them
+		void traceRays(rtSceneBVH& objects, int first, int last, float farClip);
+		//Shade the hits in the given range of rays sorted by object, casting their shadow rays and queueing their reflected rays
+		void shadeHits(rtSceneBVH& objects, lightSet& lights, int first, int last, float farClip, int currBounce, int maxBounces);
+		//Trace the shadow rays of the current bounce
+		void traceShadowRays(rtSceneBVH& objects);
+		//Combine the shaded color of each ray with its reflected color, from the deepest bounce up
+		void resolveColors(vector<rtColorf>& colors);
+
+		//A key that groups rays by their direction octant, then by their origin
+		unsigned int calcSortKey(const rtVec3f& origin, const rtVec3f& direction) const;
+
+	public:
+		/*
+		 * Ray trace a batch of camera rays starting at the camera, stored row by row, and store the color of each ray
+		 * The camera rays are traced in square packets of the given width, and the rest of the rays are traced one at a time
+		 */
+		void render(rtSceneBVH& objects, lightSet& lights, const rtVec3f& camPos, vector<rtVec3f>& directions, int batchWidth, int batchHeight,
+			float nearClip, float farClip, int maxBounces, int packetWidth, vector<rtColorf>& colors);
+		//The hit of the camera ray of a pixel of the last batch rendered
+		const rtRayHit& getCameraHit(int pixel) const;
+	};
+
+	///In-line method definitions
+	//The camera rays are the first rays of the batch, in pixel order
+	inline const rtRayHit& rtWavefrontRenderer::getCameraHit(int pixel) const
+	{
+		return rays[pixel].hitData;
+	}
+}